@@ -0,0 +1,34 @@
+#ifndef PUFU_BOOT_TRACE_H
+#define PUFU_BOOT_TRACE_H
+
+// Boot Trace
+// Real monotonic timestamps (also under --virtual-time) for each boot
+// phase and for the first frame of each Trinity window, relative to
+// pufu_boot_trace_start. Spans with the same name add up (one line for
+// every program parsed during boot). Boot ends when the first node waits
+// for user input (login prompt, shell) or the system stops; after that
+// every call is a no-op.
+
+#define PUFU_BOOT_TRACE_MAX 32 // Records kept; later names are dropped
+
+// t = 0 (first thing in main)
+void pufu_boot_trace_start(void);
+
+// Microseconds since start, 0 once boot is over (skip the span)
+long long pufu_boot_trace_now(void);
+
+// Phase `name` ran from `start_us` (pufu_boot_trace_now) until now
+void pufu_boot_trace_span(const char *name, long long start_us);
+
+// A window presented its first frame
+void pufu_boot_trace_frame(const char *window);
+
+// End of boot: log the summary (once)
+void pufu_boot_trace_finish(void);
+
+int pufu_boot_trace_done(void);
+
+// One line per record plus the total; returns the number of lines
+int pufu_boot_trace_report(void (*emit)(const char *line));
+
+#endif // PUFU_BOOT_TRACE_H
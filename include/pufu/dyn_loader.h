@@ -14,6 +14,10 @@ int pufu_load_socket(const char *path);
 // Retorna 0 si éxito, -1 si error (mantiene el socket anterior)
 int pufu_reload_socket(const char *path);
 
+// Called before a hot swap unloads the old socket: waits until no other
+// thread is still running its code (see executor.h)
+void pufu_loader_set_quiesce(void (*quiesce_func)(void));
+
 // Obtiene el socket activo cargado dinámicamente
 PufuSocket *pufu_loader_get_current(void);
 // Alias para compatibilidad std
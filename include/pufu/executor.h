@@ -0,0 +1,45 @@
+#ifndef PUFU_EXECUTOR_H
+#define PUFU_EXECUTOR_H
+
+#include "pufu/node.h"
+
+// Multi-core Executor (M:N)
+// A pool of worker threads runs compute turns of assembler nodes: each
+// worker has its own run queue, a node goes back to the worker that ran it
+// last (warm caches) and idle workers steal from the others.
+// Workers never enter the kernel: a turn stops in front of the first
+// syscall (pufu_node_execute_compute) and the scheduler runs the syscall on
+// the main thread, so subsystems stay single-threaded.
+
+typedef struct PufuExecutor PufuExecutor;
+
+// Start `workers` threads (0 = one per online CPU). NULL on failure.
+PufuExecutor *pufu_executor_init(int workers);
+
+// Hand `node` to the workers (sets node->in_flight; the main thread must
+// not touch the node until pufu_executor_reap gives it back). Workers keep
+// running it, one quantum per turn, until it reaches a syscall or ends.
+void pufu_executor_submit(PufuExecutor *exec, PufuNode *node);
+
+// Nodes handed back, as a list linked through exec_next (in_flight cleared)
+PufuNode *pufu_executor_reap(PufuExecutor *exec);
+
+// Readable (eventfd) whenever nodes are waiting to be reaped
+int pufu_executor_fd(const PufuExecutor *exec);
+
+int pufu_executor_workers(const PufuExecutor *exec);
+
+// Nodes submitted but not reaped yet
+int pufu_executor_in_flight(const PufuExecutor *exec);
+
+// Block until the workers have handed back every node (still unreaped)
+void pufu_executor_drain(PufuExecutor *exec);
+
+// Per-worker turn and steal counters, one line per worker
+int pufu_executor_format_stats(const PufuExecutor *exec, char *buf,
+                               int size);
+
+// Stop and join the workers (waits for the turns still running)
+void pufu_executor_cleanup(PufuExecutor *exec);
+
+#endif // PUFU_EXECUTOR_H
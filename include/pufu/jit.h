@@ -0,0 +1,37 @@
+#ifndef PUFU_JIT_H
+#define PUFU_JIT_H
+
+#include "pufu/node.h"
+
+// Baseline x86-64 JIT for hot loops (build with `make JIT=1`).
+// The interpreter counts taken back-edges; once a loop head is hot its
+// block [head, back-edge] is translated from per-opcode templates into
+// mmap'd executable memory. Syscalls call back into the kernel dispatch.
+// Only sockets that advertise PUFU_SOCKET_CAP_NATIVE_ALU are compiled,
+// any other ALU keeps running in the interpreter.
+
+#define PUFU_JIT_HOT_THRESHOLD 50 // Back-edges before a loop is compiled
+#define PUFU_JIT_MAX_BLOCK 256    // Longest block (instructions) to compile
+#define PUFU_JIT_ARENA_SIZE (64 * 1024) // Code memory per node
+
+typedef struct PufuJit PufuJit;
+
+// Estado JIT de un nodo (NULL si la plataforma no tiene JIT)
+PufuJit *pufu_jit_create(const PufuParser *parser);
+
+// Liberar código y contadores
+void pufu_jit_destroy(PufuJit *jit);
+
+// Drop all compiled code (hot reload, program change)
+void pufu_jit_invalidate(PufuJit *jit);
+
+// Called after a taken backward branch from `from` to node->ip.
+// Runs native code for the loop if it is (or just became) hot and
+// returns the instructions it executed, or 0 to keep interpreting.
+int pufu_jit_backedge(PufuJit *jit, PufuNodeSystem *sys, PufuNode *node,
+                      int from, int budget);
+
+// Formatear estadísticas JIT (una línea)
+int pufu_jit_format_stats(const PufuJit *jit, char *buf, int size);
+
+#endif // PUFU_JIT_H
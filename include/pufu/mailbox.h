@@ -0,0 +1,86 @@
+#ifndef PUFU_MAILBOX_H
+#define PUFU_MAILBOX_H
+
+// Mailbox
+// Per-node message queue. Messages are variable-length records
+// {header, sender, content} in a byte ring (the arena), so a short message
+// costs its length instead of a fixed slot. The arena starts small and
+// doubles when a record does not fit; the only limit a sender sees is the
+// capacity in messages, which each node may change at any time. A post to
+// a full mailbox is refused (backpressure) and counted as dropped.
+// Fan-out (topics, broadcast) posts a refcounted PufuMailPayload instead:
+// each mailbox keeps a pointer and every recipient shares one copy.
+
+#define PUFU_MAILBOX_DEFAULT_CAPACITY 16
+#define PUFU_MAILBOX_MAX_CAPACITY 4096
+#define PUFU_MAILBOX_ARENA_MIN 512 // Initial arena bytes
+#define PUFU_MAIL_SENDER_MAX 63    // Longer senders are truncated
+#define PUFU_MAIL_CONTENT_MAX 255  // Fits the InputBuffer ((ipc_read))
+
+// pufu_mailbox_post results
+#define PUFU_MAIL_OK 0
+#define PUFU_MAIL_FULL 1     // `capacity` messages pending
+#define PUFU_MAIL_NO_MEMORY -1
+
+// Estructura para mensajes IPC (copied out by pufu_mailbox_take)
+typedef struct {
+  char sender[PUFU_MAIL_SENDER_MAX + 1];
+  char content[PUFU_MAIL_CONTENT_MAX + 1];
+  int type; // 0=Text, 1=ProcessExit, 2=Broadcast, 3=Signal (VirtualBus),
+            // 4=Shared buffer ("shm <handle> <size>"), 5=Topic ("topic:msg"),
+            // 6=RPC request ("rpc <id> <pid> <body>")
+} PufuMessage;
+
+// Content shared by several mailboxes; freed with the last reference
+typedef struct {
+  int refs;
+  int len;
+  char data[]; // len chars + NUL
+} PufuMailPayload;
+
+// Cola de mensajes de un nodo
+typedef struct {
+  char *arena;
+  int arena_size;
+  int head;     // Write offset
+  int tail;     // Read offset
+  int used;     // Arena bytes holding records
+  int count;    // Messages pending
+  int capacity; // Messages accepted before posts are refused
+  int max_count; // Deepest seen
+  long long posted;
+  long long dropped; // Refused: full or out of memory
+} PufuMailbox;
+
+int pufu_mailbox_init(PufuMailbox *mailbox, int capacity);
+
+// Clamped to [1, PUFU_MAILBOX_MAX_CAPACITY]; returns the new capacity.
+// Shrinking below the pending count keeps those messages; new posts are
+// refused until the reader drains them.
+int pufu_mailbox_set_capacity(PufuMailbox *mailbox, int capacity);
+
+// Copy a message in (content truncated to PUFU_MAIL_CONTENT_MAX).
+// Returns PUFU_MAIL_OK, PUFU_MAIL_FULL or PUFU_MAIL_NO_MEMORY.
+int pufu_mailbox_post(PufuMailbox *mailbox, const char *sender,
+                      const char *content, int type);
+
+// Same as pufu_mailbox_post, but the mailbox takes a reference to
+// `payload` instead of copying its content
+int pufu_mailbox_post_shared(PufuMailbox *mailbox, const char *sender,
+                             PufuMailPayload *payload, int type);
+
+// One reference, content truncated to PUFU_MAIL_CONTENT_MAX; NULL if out
+// of memory
+PufuMailPayload *pufu_mail_payload_create(const char *content);
+void pufu_mail_payload_release(PufuMailPayload *payload);
+
+// Oldest message into `out`: 1, or 0 if the mailbox is empty
+int pufu_mailbox_take(PufuMailbox *mailbox, PufuMessage *out);
+
+static inline int pufu_mailbox_count(const PufuMailbox *mailbox) {
+  return mailbox ? mailbox->count : 0;
+}
+
+void pufu_mailbox_cleanup(PufuMailbox *mailbox);
+
+#endif // PUFU_MAILBOX_H
@@ -5,6 +5,12 @@
 #include "pufu/parser.h"
 
 #include "pufu/crystal.h"
+#include "pufu/mailbox.h"
+#include "pufu/proc_table.h"
+#include "pufu/rpc.h"
+#include "pufu/shm.h"
+#include "pufu/timer_wheel.h"
+#include "pufu/topics.h"
 #include "pufu/virtual_bus.h"
 
 // Tipos de nodos
@@ -16,19 +22,81 @@ typedef enum {
 
 // Forward declaration
 struct PufuEntity;
+struct PufuJit;
+struct PufuProgram;
 
-// Estructura para mensajes IPC
+// Filenames up to this length live inside the node (no strdup on spawn)
+#define PUFU_NODE_NAME_INLINE 128
+
+// Time slice per scheduler turn (see pufu_node_execute)
+#define PUFU_DEFAULT_QUANTUM 1000    // Max instructions per turn
+#define PUFU_DEFAULT_QUANTUM_US 2000 // Max microseconds per turn
+
+// Why a syscall ended the turn early (node->yielded)
+typedef enum {
+  PUFU_YIELD_NONE = 0,
+  PUFU_YIELD_TURN,  // Gave the turn away but can run again right now
+  PUFU_YIELD_SYSCALL, // Worker stopped before a syscall (main thread runs it)
+  PUFU_YIELD_INPUT, // No key on stdin
+  PUFU_YIELD_IPC,   // Empty mailbox
+  PUFU_YIELD_EVENT, // No Trinity event queued
+  PUFU_YIELD_WAIT   // (wait): none of node->wait_sources is ready
+} PufuYieldReason;
+
+// (wait) sources (node->wait_sources). r0 gets the one that fired, or
+// PUFU_WAIT_TIMEOUT.
+#define PUFU_WAIT_TIMEOUT 0
+#define PUFU_WAIT_IPC 1   // Mailbox not empty
+#define PUFU_WAIT_INPUT 2 // Key available
+#define PUFU_WAIT_EVENT 4 // Trinity event queued
+#define PUFU_WAIT_PENDING 0x100 // Set while the (wait) is in progress
+
+// Where the scheduler keeps a node between turns (node->run_state)
+typedef enum {
+  PUFU_RUN_IDLE = 0, // In no queue: new, or its turn is running right now
+  PUFU_RUN_READY,    // In the run queue
+  PUFU_RUN_SLEEPING, // In the timer wheel (wake_time)
+  PUFU_RUN_PARKED,   // Yielded on input/IPC/events: waits for a wakeup
+  PUFU_RUN_WORKER,   // Handed to the executor (in_flight)
+  PUFU_RUN_ZOMBIE    // Exited: freed by the reaper at the end of the pass
+} PufuRunState;
+
+// Scheduling class (node->sched_class). Each pass runs interactive nodes
+// first, earliest deadline first, and again between later turns when they
+// get woken; normal nodes next; batch nodes only in leftover time.
+typedef enum {
+  PUFU_CLASS_INTERACTIVE = 0, // UI: window manager, desktop, sessions
+  PUFU_CLASS_NORMAL,          // Default
+  PUFU_CLASS_BATCH,           // Background services
+  PUFU_CLASS_COUNT
+} PufuSchedClass;
+
+#define PUFU_INTERACTIVE_DEADLINE_US 4000 // Default ready -> run budget
+#define PUFU_BATCH_MAX_WAIT_MS 100 // Batch runs at least this often anyway
+
+// Ready -> turn latency of one class (log2 histogram for percentiles)
+#define PUFU_LATENCY_BUCKETS 24 // Bucket b: under 2^b us
 typedef struct {
-  char sender[64];
-  char content[192];
-  int type; // 0=Text, 1=ProcessExit, 2=Broadcast
-} PufuMessage;
+  long long turns;
+  long long total_us;
+  long long max_us;
+  long long missed; // Turns that started past their deadline (interactive)
+  long long histogram[PUFU_LATENCY_BUCKETS];
+} PufuClassStats;
 
-#define PUFU_IPC_QUEUE_SIZE 16
+// Estadísticas de ejecución del nodo
+typedef struct {
+  long long instructions;    // Instructions executed (total)
+  long long turns;           // Scheduler turns that ran code
+  long long quantum_expired; // Turns cut by the quantum (insns or time)
+  long long yields;          // Turns ended by sleep / blocking I/O
+  int last_turn;             // Instructions executed in the last turn
+} PufuNodeStats;
 
 // Estructura para representar un nodo Pufu
 typedef struct PufuNode {
   char *filename;    // Nombre del archivo
+  int pid;           // Process table ID (0 = not in a table)
   PufuNodeType type; // Tipo de nodo
   struct PufuEntity
       *body; // The Physical Body (Trinity Entity) linked to this Logic Node
@@ -40,27 +108,82 @@ typedef struct PufuNode {
   int loop_counter;       // Contador para bucles (restart)
   int ip;                 // Instruction Pointer (para multitasking)
   int active;             // Si el nodo está activo/ejecutándose
+  int exit_code;          // (exit) status, 0 unless given
   long long wake_time;    // Tiempo (ms) para despertar (si está durmiendo)
+  int wait_sources;       // (wait) in progress: PUFU_WAIT_* mask (0 = none)
+  long long wait_deadline; // (wait) timeout (ms), 0 = none
   int registers[16];      // Registros de propósito general (r0-r15)
   int cmp_flag;           // Flag de comparación (-1, 0, 1)
   char input_buffer[256]; // Buffer de entrada para terminal
   int input_pos;          // Posición actual en el buffer
 
   // IPC Event Bus (Queue)
-  PufuMessage ipc_queue[PUFU_IPC_QUEUE_SIZE];
-  int ipc_head;  // Write Index
-  int ipc_tail;  // Read Index
-  int ipc_count; // Messages pending
+  PufuMailbox *mailbox; // NULL until the first message (pufu_node_post)
+  int mailbox_capacity; // (ipc_capacity); applied when the mailbox exists
+  PufuShmRefs shm;      // Shared buffer handles held (released on exit)
+  int call_id;          // (call) in progress: correlation id (0 = none)
+  int call_state;       // PUFU_CALL_*; the deadline is wait_deadline
+  PufuRpcAccepted accepted; // Requests taken by (rpc_accept), unanswered
 
   char args[256]; // Argumentos de lanzamiento (e.g. "NO_GUI")
   int tws_id;     // Terminal Window Space ID (0 by default)
+
+  // Scheduling
+  int quantum;         // Max instructions per turn
+  int quantum_us;      // Max microseconds per turn (0 = no time limit)
+  int yielded;         // PufuYieldReason of a syscall that would block
+  PufuNodeStats stats; // Execution statistics
+  PufuTimer timer;     // wake_time / wait_deadline in the timer wheel
+  int watched;         // Reload fd registered with the scheduler
+  int run_state;       // PufuRunState
+  struct PufuNode *run_next; // Run queue link
+  int sched_class;     // PufuSchedClass (inherited by spawned children)
+  int deadline_budget_us; // Interactive: ready -> run budget
+  long long ready_us;     // When it entered the run queue
+  long long deadline_us;  // Interactive: ready_us + deadline_budget_us
+  long long spin_pass;    // Pass in which it last used up its quantum
+
+  // Process table chains (see proc_table.h)
+  unsigned name_hash;
+  struct PufuNode *pid_next;
+  struct PufuNode *name_next;
+
+  // Multi-core executor (see executor.h)
+  int on_workers; // Compute-bound: turns run on worker threads
+  int in_flight;  // Queued or running on a worker (main thread keeps off)
+  int worker;     // Last worker that ran it (run queue affinity)
+  int stop_pending; // Killed while in flight
+  int jit_stale;    // Reloaded while in flight: JIT reset at handback
+  struct PufuNode *exec_next; // Executor queue link
+
+  struct PufuJit *jit; // Native code for hot loops (make JIT=1)
+  struct PufuProgram *program; // Shared image behind parser (or NULL)
+  char name_buf[PUFU_NODE_NAME_INLINE]; // filename, unless it is longer
 } PufuNode;
 
+// FIFO through run_next (interactive: sorted by deadline_us)
+typedef struct {
+  PufuNode *head;
+  PufuNode *tail;
+} PufuRunQueue;
+
 // Estructura para el sistema de nodos
 typedef struct {
   PufuNode *arbiter;   // Nodo árbitro actual
   PufuNode *nodes;     // Lista de nodos cargados
   PufuVirtualBus *bus; // Bus de mensajes IPC (VirtualBus)
+  PufuProcTable procs; // PID and name indexes
+  PufuTopicTable topics; // Publish/subscribe (pufu_node_publish)
+  PufuRpcStats rpc;      // (call) / (reply) outcomes
+
+  // Run queues, one per class: only nodes that can run now
+  PufuRunQueue ready[PUFU_CLASS_COUNT];
+  PufuClassStats class_stats[PUFU_CLASS_COUNT];
+  int live_count;   // Loaded and not exited
+  int parked_count; // Waiting for input/IPC/events
+  int zombie_count; // Exited, not reaped yet
+  long long reaped; // Nodes freed by the reaper
+  int exit_status;  // exit_code of the arbiter once reaped (--batch)
 } PufuNodeSystem;
 
 // Inicializar el sistema de nodos
@@ -72,20 +195,130 @@ PufuNode *pufu_node_load(PufuNodeSystem *system, const char *filename);
 // Establecer un nodo como árbitro
 int pufu_node_set_arbiter(PufuNodeSystem *system, PufuNode *node);
 
-// Ejecutar un nodo (un paso)
+// Syscall target: a PID ("12") or a filename (newest live instance)
+PufuNode *pufu_node_find(PufuNodeSystem *system, const char *target);
+
+// Not exited, for the main thread. A turn running on a worker owns
+// node->active, so a node in flight counts as live until it is handed back.
+static inline int pufu_node_live(const PufuNode *node) {
+  return node->in_flight || node->active;
+}
+
+// PID written as decimal digits, or 0 if `target` is a name
+int pufu_node_parse_pid(const char *target);
+
+// Queue a message in target's mailbox (allocated on first use). Returns
+// PUFU_MAIL_OK, PUFU_MAIL_FULL (backpressure: the sender may retry once the
+// target reads) or PUFU_MAIL_NO_MEMORY.
+int pufu_node_post(PufuNode *target, const char *sender, const char *content,
+                   int type);
+
+// Deliver "topic:content" (type 5) to every subscriber of `topic` but the
+// sender, sharing one copy of the payload; `delivered` gets the count (0
+// without subscribers). Returns PUFU_MAIL_OK, PUFU_MAIL_FULL (a subscriber
+// mailbox is full: nobody got it, retry later) or PUFU_MAIL_NO_MEMORY.
+int pufu_node_publish(PufuNodeSystem *system, PufuNode *sender,
+                      const char *topic, const char *content,
+                      int *delivered);
+
+// Same shared delivery to every other live node (type 2). Returns the
+// number of nodes whose mailbox refused it.
+int pufu_node_broadcast(PufuNodeSystem *system, PufuNode *sender,
+                        const char *content);
+
+// Route VirtualBus signals with `id` to the node's mailbox ("0xID
+// nibbles", type 3). Subscribing twice still delivers each signal once.
+// The route goes away with the node.
+int pufu_node_subscribe(PufuNodeSystem *system, PufuNode *node, uint16_t id);
+
+// Put a node in the run queue (no-op if it is already there or exited)
+void pufu_node_ready(PufuNodeSystem *system, PufuNode *node);
+
+// Change a node's class. A queued node moves to the new class queue.
+void pufu_node_set_class(PufuNodeSystem *system, PufuNode *node,
+                         int sched_class);
+
+// "interactive" / "normal" / "batch" -> PufuSchedClass, or -1
+int pufu_node_parse_class(const char *name);
+const char *pufu_node_class_name(int sched_class);
+
+// Wake a parked node (new mail, input): back to the run queue
+void pufu_node_wake(PufuNodeSystem *system, PufuNode *node);
+
+// Detener un nodo (kill). A turn running on a worker owns node->active:
+// the stop is applied when that turn is handed back.
+void pufu_node_stop(PufuNodeSystem *system, PufuNode *node);
+
+// Free every zombie node (unlinked from system->nodes). Only call it at a
+// safe point: no syscall running and nothing else holding node pointers.
+// Returns the number of nodes freed.
+int pufu_node_system_reap(PufuNodeSystem *system);
+
+// Release everything a node owns (program image, reload watcher, JIT code,
+// Crystal engine, mailbox) and return it to the node slab. It must be off
+// every list already.
+void pufu_node_destroy(PufuNode *node);
+
+// Ejecutar un nodo (un turno: hasta node->quantum instrucciones)
 int pufu_node_execute(PufuNodeSystem *system, PufuNode *node);
 
+// Same turn without kernel access (worker threads): stops in front of the
+// first syscall with node->yielded = PUFU_YIELD_SYSCALL
+int pufu_node_execute_compute(PufuNode *node);
+
+// Detectar el tipo de nodo (extensión / magic header)
+PufuNodeType pufu_node_detect_type(const char *filename);
+
+// Formatear las estadísticas del nodo (una línea)
+int pufu_node_format_stats(PufuNode *node, char *buf, int size);
+
+// Contadores del sistema: live, parked, zombie, reaped y slab (una línea)
+int pufu_node_system_format_stats(PufuNodeSystem *system, char *buf,
+                                  int size);
+
+// Ready -> run latency per class: turns, average, p99, max (una línea)
+int pufu_node_system_format_class_stats(PufuNodeSystem *system, char *buf,
+                                        int size);
+
+// Run one syscall instruction: kernel dispatch, then the socket fallback
+void pufu_node_syscall(PufuNodeSystem *sys, PufuNode *node,
+                       PufuInstruction *inst);
+
+// Dispatch engine compiled in: "switch" or "threaded" (make ENGINE=...)
+const char *pufu_node_engine(void);
+
 // Verificar cambios en todos los nodos
 // Verificar cambios en todos los nodos
 int pufu_node_system_check(PufuNodeSystem *system);
 
+// Hot-reload check for a single node (1 if its file changed)
+int pufu_node_check(PufuNode *node);
+
+// Hot-reload check for the shared program images (pufu_program_watch_fd):
+// the number of images whose source changed
+int pufu_node_system_check_programs(PufuNodeSystem *system);
+
 // VM Helpers
 int get_reg_index(const char *str);
 int get_value(PufuNode *node, const char *str);
+int get_operand_reg(int kind, int value);
+int get_operand_value(PufuNode *node, int kind, int value);
+const char *get_string_arg(PufuNode *node, PufuInstruction *inst);
 long long get_time_ms(void);
-int find_label(PufuNode *node, const char *label);
+long long get_time_us(void);
+
+// Virtual time (pufu_os --virtual-time): get_time_ms/us read a simulated
+// clock. It moves PUFU_VIRTUAL_NS_PER_INSN per instruction executed and
+// jumps to the next timer when every node is asleep, so sleeps cost no
+// real time and an inline run always interleaves the same way.
+#define PUFU_VIRTUAL_EPOCH_MS 3600000LL // Start value (never 0)
+#define PUFU_VIRTUAL_NS_PER_INSN 10
+void pufu_clock_set_virtual(int enabled);
+int pufu_clock_is_virtual(void);
+void pufu_clock_charge(int instructions);     // End of a turn
+void pufu_clock_advance_to(long long ms);     // Fast-forward (never back)
 
-// Node Lifecycle (Internal/Core)
+// Node Lifecycle (Internal/Core). Free the node with pufu_node_destroy.
 PufuNode *pufu_create_node(const char *filename, int type_override);
 
 // Liberar recursos del sistema
@@ -18,6 +18,16 @@ typedef enum {
   OP_BGT = 0x14,
   OP_LABEL = 0x15, // Meta-instruction
 
+  // Superinstructions (written by pufu_parser_optimize, never by hand).
+  // They replace the first op of a pair and read the second from ip + 1,
+  // which is left in place so jumps into it still work.
+  OP_CMP_BEQ = 0x20,
+  OP_CMP_BNE = 0x21,
+  OP_CMP_BLT = 0x22,
+  OP_CMP_BGT = 0x23,
+  OP_MOV_ADD = 0x24,
+  OP_MOV_SYSCALL = 0x25,
+
   // System
   OP_SYSCALL = 0xFF
 } PufuOpcode;
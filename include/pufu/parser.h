@@ -2,19 +2,37 @@
 #define PUFU_PARSER_H
 
 #include "pufu/opcode.h"
+#include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
-// Estructura para representar una instrucción Pufu
+// Operand kinds decoded once by the parser (the VM never re-parses text)
+typedef enum {
+  PUFU_OPERAND_NONE = 0,
+  PUFU_OPERAND_REG,  // value = register index (r0-r15)
+  PUFU_OPERAND_IMM,  // value = immediate integer
+  PUFU_OPERAND_STR,  // value = offset into the parser string pool
+  PUFU_OPERAND_LABEL // value = resolved instruction index (after link)
+} PufuOperandKind;
+
+// Packed Pufu instruction (16 bytes). Strings live in the parser string
+// pool, source text lives in the debug side table.
 typedef struct {
-  PufuOpcode opcode; // Numeric Opcode (The Optimization!)
-  char op[32];       // Legacy string op (kept for debug)
-  char reg1[128];    // Primer registro (reg.1, reg.2, etc.)
-  char reg2[128];    // Segundo registro (si es necesario)
-  char value[128];   // Valor o dirección
-  int is_syscall;    // Flag para syscalls
-  int syscall_id;    // Optimized Syscall ID
+  uint8_t opcode;      // PufuOpcode
+  uint8_t a_kind : 4;  // PufuOperandKind of a
+  uint8_t b_kind : 4;  // PufuOperandKind of b
+  uint16_t syscall_id; // PufuSyscallID (OP_SYSCALL only)
+  int32_t a;           // Dest register, branch target or syscall argument
+  int32_t b;           // Source operand, or syscall argument text (STR)
+  int32_t c;           // Syscall name in the pool (socket fallback)
 } PufuInstruction;
 
+// Debug Side Table (one entry per instruction, never read by the VM loop)
+typedef struct {
+  int line; // Source line number
+  int text; // Source line in the string pool
+} PufuDebugInfo;
+
 // Label Entry for O(1) Jumps
 typedef struct {
   char name[64];
@@ -24,6 +42,7 @@ typedef struct {
 // Estructura para el parser
 typedef struct {
   PufuInstruction *instructions; // Array de instrucciones
+  PufuDebugInfo *debug;          // Side table parallel to instructions
   int count;                     // Número de instrucciones
   int capacity;                  // Capacidad actual del array
   int has_pufu_init;             // Flag 3.0: Archivo inicia con _pufu::init
@@ -32,6 +51,22 @@ typedef struct {
   PufuLabelEntry *labels;
   int label_count;
   int label_capacity;
+
+  // Interned String Pool (NUL-separated, referenced by PUFU_OPERAND_STR)
+  char *strings;
+  int strings_size;
+  int strings_capacity;
+  int *intern_table; // Open addressing: pool offset + 1, 0 = empty
+  int intern_capacity;
+  int intern_count;
+
+  int line_no;      // Lines consumed so far (comments included)
+  int in_docstring; // Inside a """ ... """ block (skipped like comments)
+  int linked;  // Set once pufu_parser_link has resolved all branches
+
+  // Set when the arrays above live in a read-only .pufub mapping
+  void *image;
+  size_t image_size;
 } PufuParser;
 
 // Inicializar el parser
@@ -43,6 +78,20 @@ int pufu_parse_line(PufuParser *parser, const char *line);
 // Parsear un archivo Pufu completo
 int pufu_parse_file(PufuParser *parser, const char *filename);
 
+// Resolve branch labels into instruction indices and strip OP_LABEL slots.
+// Returns 0 on success, or -1 if any branch names an unknown label.
+int pufu_parser_link(PufuParser *parser, const char *filename);
+
+// Peephole pass over a linked program: fuse common pairs (cmp+branch,
+// mov+add, mov+syscall) into superinstructions. Returns the fused count.
+int pufu_parser_optimize(PufuParser *parser);
+
+// Get a string from the pool by PUFU_OPERAND_STR offset
+const char *pufu_parser_string(const PufuParser *parser, int offset);
+
+// Print the decoded program with its source lines (debug only)
+void pufu_parser_disassemble(const PufuParser *parser, FILE *out);
+
 // Liberar recursos del parser
 void pufu_parser_cleanup(PufuParser *parser);
 
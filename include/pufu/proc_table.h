@@ -0,0 +1,36 @@
+#ifndef PUFU_PROC_TABLE_H
+#define PUFU_PROC_TABLE_H
+
+// Process Table
+// Every loaded node gets an integer PID. Two hash indexes (chained through
+// the node itself) map a PID to its node and a filename to every node
+// running it, so syscalls find their target in O(1) instead of a strcmp
+// walk over the node list. Both grow together when the load passes 1.
+
+struct PufuNode;
+
+typedef struct {
+  struct PufuNode **by_pid;  // Buckets chained through pid_next
+  struct PufuNode **by_name; // Buckets chained through name_next
+  int buckets;               // Power of two, shared by both indexes
+  int count;                 // Nodes in the table
+  int next_pid;              // PIDs are never reused
+} PufuProcTable;
+
+int pufu_proc_table_init(PufuProcTable *table);
+void pufu_proc_table_cleanup(PufuProcTable *table);
+
+// Assign node->pid and index the node. Returns the PID or -1.
+int pufu_proc_add(PufuProcTable *table, struct PufuNode *node);
+
+// Drop a node from both indexes (before it is freed)
+void pufu_proc_remove(PufuProcTable *table, struct PufuNode *node);
+
+struct PufuNode *pufu_proc_find(const PufuProcTable *table, int pid);
+
+// Newest node running `name`; pufu_proc_next_named walks the older ones
+struct PufuNode *pufu_proc_find_named(const PufuProcTable *table,
+                                      const char *name);
+struct PufuNode *pufu_proc_next_named(const struct PufuNode *node);
+
+#endif // PUFU_PROC_TABLE_H
@@ -0,0 +1,48 @@
+#ifndef PUFU_PROGRAM_H
+#define PUFU_PROGRAM_H
+
+#include "pufu/parser.h"
+
+// Shared Program Images
+// Nodes spawned from the same file share one immutable, linked program
+// (code, labels, string pool). Only registers/IP/mailbox are per node.
+// Images are keyed by canonical path and refcounted; hot reload marks an
+// image stale so new nodes load the new version while running ones keep
+// the code they started with. Each image watches its source file: one
+// inotify watch per image, all on a single fd the scheduler polls.
+
+typedef struct PufuProgram {
+  char *path;         // Canonical path (realpath), the registry key
+  PufuParser *parser; // Linked + optimized, read-only once published
+  int type;           // PufuNodeType detected at load
+  int refs;           // Nodes using this image
+  int stale;          // Source changed: no longer handed out
+  int watch;          // inotify watch on `path`, -1 if none (or stale)
+  struct PufuProgram *next;
+} PufuProgram;
+
+// Get the image for `filename` (shared if already loaded). `type` is the
+// node type, or -1 to detect it. Returns NULL on parse/link errors.
+PufuProgram *pufu_program_acquire(const char *filename, int type);
+
+// Drop a reference; the image is freed with its last node
+void pufu_program_release(PufuProgram *program);
+
+// Hot reload: stop sharing this image (running nodes keep it)
+void pufu_program_invalidate(PufuProgram *program);
+
+// Non-blocking inotify fd carrying every image's watch (readable when a
+// source changed), or -1 if inotify is unavailable. Lives as long as the
+// process.
+int pufu_program_watch_fd(void);
+
+// Drain pufu_program_watch_fd: each image whose source was modified,
+// replaced or removed is invalidated, then passed to `changed` (may be
+// NULL). Returns the number of images invalidated.
+int pufu_program_check(void (*changed)(PufuProgram *program, void *arg),
+                       void *arg);
+
+// Images currently loaded (for stats / tests)
+int pufu_program_count(void);
+
+#endif // PUFU_PROGRAM_H
@@ -0,0 +1,37 @@
+#ifndef PUFU_PUFUB_H
+#define PUFU_PUFUB_H
+
+#include "pufu/parser.h"
+
+// Precompiled programs (.pufub): the linked + optimized instructions,
+// debug table, labels and string pool of a .pufu file, stored in
+// PUFU_CACHE_DIR and loaded back with a single mmap.
+//
+// A cache file is named after a hash of the source path and records the
+// source mtime/size, the node type, PUFU_PUFUB_VERSION and the digest of
+// tools/pufu_names.txt (PUFU_NAMES_HASH). Any mismatch means the source is
+// parsed again and the cache rewritten.
+
+#define PUFU_CACHE_DIR ".pufu_cache"
+
+// Bump whenever the file layout, PufuInstruction, operand decoding or the
+// numbering in opcode.h/syscall_ids.h change. Adding or renaming names in
+// tools/pufu_names.txt is caught by PUFU_NAMES_HASH without a bump.
+#define PUFU_PUFUB_VERSION 4
+
+// Enable/disable the cache (pufu_os --no-cache). Enabled by default.
+void pufu_pufub_set_enabled(int enabled);
+int pufu_pufub_enabled(void);
+
+// Cache file path for a source file
+int pufu_pufub_path(const char *source, char *out, int size);
+
+// Load a fresh .pufub for `source`. Returns an mmap-backed, read-only
+// program (free with pufu_parser_cleanup) and its node type, or NULL.
+PufuParser *pufu_pufub_load(const char *source, int *node_type);
+
+// Save a linked program for `source`. Returns 0 on success.
+int pufu_pufub_store(const PufuParser *parser, const char *source,
+                     int node_type);
+
+#endif // PUFU_PUFUB_H
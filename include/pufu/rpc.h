@@ -0,0 +1,55 @@
+#ifndef PUFU_RPC_H
+#define PUFU_RPC_H
+
+// Request/Response Calls
+// (call) mails the InputBuffer to a server as "rpc <id> <pid> <body>"
+// (type 6) under a new correlation id and parks the caller until the reply
+// or its deadline, whichever comes first. The server takes requests with
+// (rpc_accept), which keeps {id, caller} in the server's PufuRpcAccepted,
+// and answers with (reply): the text goes straight into the parked
+// caller's InputBuffer. A reply that comes after the deadline no longer
+// matches the caller's call id and is dropped as late. If a server exits,
+// the calls it accepted fail at once instead of waiting for the deadline.
+// Main thread only (syscalls).
+
+#define PUFU_RPC_DEFAULT_TIMEOUT_MS 1000
+#define PUFU_RPC_ACCEPT_MAX 256 // Unanswered requests one server may hold
+
+// node->call_state while node->call_id is set
+enum { PUFU_CALL_PENDING = 1, PUFU_CALL_REPLIED, PUFU_CALL_FAILED };
+
+typedef struct {
+  int id;
+  int caller; // PID
+} PufuRpcRequest;
+
+// Grows on demand: nodes that never serve a call allocate nothing
+typedef struct {
+  PufuRpcRequest *requests;
+  int count;
+  int capacity;
+} PufuRpcAccepted;
+
+typedef struct {
+  long long calls;    // Requests sent
+  long long replies;  // Reached a waiting caller
+  long long timeouts; // Deadline passed first
+  long long failed;   // Server exited with the request accepted
+  long long late;     // Replies to a call that was already over
+} PufuRpcStats;
+
+// New correlation id (> 0, never 0)
+int pufu_rpc_next_id(void);
+
+// Remember an accepted request: 0, or -1 (PUFU_RPC_ACCEPT_MAX held, no
+// memory)
+int pufu_rpc_accept(PufuRpcAccepted *accepted, int id, int caller);
+
+// Forget request `id` and return its caller, or -1 if it is not held
+int pufu_rpc_take(PufuRpcAccepted *accepted, int id);
+
+void pufu_rpc_accepted_clear(PufuRpcAccepted *accepted);
+
+int pufu_rpc_format_stats(const PufuRpcStats *stats, char *buf, int size);
+
+#endif // PUFU_RPC_H
@@ -0,0 +1,72 @@
+#ifndef PUFU_SCHEDULER_H
+#define PUFU_SCHEDULER_H
+
+#include "pufu/executor.h"
+#include "pufu/node.h"
+#include "pufu/timer_wheel.h"
+
+// Event-Driven Scheduler
+// Each pass runs the nodes in the run queues (system->ready) once, by
+// class: interactive nodes first in deadline order, then normal ones, then
+// batch ones if nothing else was ready (or the oldest waited
+// PUFU_BATCH_MAX_WAIT_MS). Between turns the scheduler polls for input and
+// runs interactive nodes woken in the meantime, so a busy pass does not
+// delay the UI by more than one turn.
+// Sleeping nodes live in a timer wheel keyed by wake_time; nodes that
+// yielded on input, IPC or Trinity events are parked until one of those
+// can make progress. Exited nodes are reaped at the end of the pass. When
+// nothing is runnable the process blocks in one epoll_wait (stdin,
+// hot-reload inotify fds, backend fds) until the next timer or I/O event,
+// so an idle system uses no CPU.
+//
+// With worker threads, an assembler node whose turns run out of quantum
+// (compute-bound) moves to the executor; it comes back to the main thread
+// as soon as a turn reaches a syscall, which then runs on the next inline
+// turn. Mostly-syscall nodes therefore never pay the thread hop.
+
+// Crystal nodes have no blocking syscalls: they are clocked instead
+#define PUFU_CRYSTAL_TICK_MS 10
+
+// Input poll between turns (for interactive nodes) at most this often
+#define PUFU_INPUT_POLL_US 1000
+
+typedef struct {
+  long long passes;     // Scheduler passes over the node list
+  long long waits;      // Passes that ended blocked in epoll_wait
+  long long timer_wakeups;
+  long long io_wakeups; // epoll events delivered
+  long long handbacks;  // Nodes the workers gave back to the main thread
+  long long preemptions; // Interactive turns run between two other turns
+  long long batch_deferrals; // Passes that left the batch queue waiting
+  long long fast_forwards;   // Virtual clock jumps to the next timer
+} PufuSchedulerStats;
+
+typedef struct PufuScheduler {
+  PufuNodeSystem *system;
+  PufuTimerWheel wheel;
+  PufuExecutor *exec; // NULL: every turn runs on the main thread
+  int epoll_fd;
+  int io_ready;  // An fd fired since the last pass: wake parked nodes
+  int reloads;   // Hot-reload changes seen in the last pass
+  long long polled_us; // Last input poll (run_interactive)
+  PufuSchedulerStats stats;
+} PufuScheduler;
+
+// Create a scheduler for `system` (stdin is watched when it can be polled).
+// `workers`: 0 runs everything on the main thread, -1 one worker per CPU.
+PufuScheduler *pufu_scheduler_init(PufuNodeSystem *system, int workers);
+
+// Wake the scheduler whenever `fd` becomes readable (backend sockets).
+// Edge-triggered: the owner drains it from its syscalls, not the scheduler.
+int pufu_scheduler_watch_fd(PufuScheduler *sched, int fd);
+
+// One pass: fire due timers, run every runnable node for a turn, then
+// block until the next timer or I/O event if nothing is left to run.
+// Returns the number of active nodes (0 = the system is done).
+int pufu_scheduler_run_once(PufuScheduler *sched);
+
+// Stop the workers and close the epoll set (nodes are owned by the node
+// system)
+void pufu_scheduler_cleanup(PufuScheduler *sched);
+
+#endif // PUFU_SCHEDULER_H
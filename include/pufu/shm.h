@@ -0,0 +1,44 @@
+#ifndef PUFU_SHM_H
+#define PUFU_SHM_H
+
+// Shared Buffers
+// Bulk data between nodes without copying: a buffer is created once and
+// referenced by an integer handle (slot index + generation, so a stale
+// handle never reaches a reused slot). Every node that holds the handle
+// keeps a reference in its PufuShmRefs; sending a handle adds the target's
+// reference, giving it also drops the sender's, and a node's references
+// are released when it exits. The memory is freed with the last one.
+// Main thread only (syscalls).
+
+#define PUFU_SHM_MAX_BUFFERS 1024 // Live buffers (power of two)
+#define PUFU_SHM_MAX_SIZE (64 * 1024 * 1024)
+#define PUFU_SHM_NODE_MAX 256 // Handles one node may hold
+
+// Grows on demand: nodes that never touch a buffer allocate nothing
+typedef struct {
+  int *handles;
+  int count;
+  int capacity;
+} PufuShmRefs;
+
+// New zeroed buffer with one reference (not yet held by any node).
+// Returns the handle, or -1 (bad size, table full, no memory).
+int pufu_shm_create(int size);
+
+// Data and size of a live buffer; NULL if the handle is stale
+void *pufu_shm_data(int handle, int *size);
+
+int pufu_shm_retain(int handle);     // -1 if stale
+void pufu_shm_release(int handle);   // Frees on the last reference
+
+// Per-node references. add: retain unless already held; -1 if the handle
+// is stale, 1 if the node already holds PUFU_SHM_NODE_MAX (or no memory).
+// drop: release, -1 if not held. clear: release all and free the table.
+int pufu_shm_refs_add(PufuShmRefs *refs, int handle);
+int pufu_shm_refs_has(const PufuShmRefs *refs, int handle);
+int pufu_shm_refs_drop(PufuShmRefs *refs, int handle);
+void pufu_shm_refs_clear(PufuShmRefs *refs);
+
+int pufu_shm_format_stats(char *buf, int size);
+
+#endif // PUFU_SHM_H
@@ -0,0 +1,41 @@
+#ifndef PUFU_SLAB_H
+#define PUFU_SLAB_H
+
+#include <stddef.h>
+
+// Slab Allocator
+// Fixed-size objects carved out of cache-line aligned chunks. Freed objects
+// go on an intrusive free list and are handed out again before a new chunk
+// is allocated, so steady spawn/exit churn touches malloc only when the
+// peak grows. Chunks are kept until pufu_slab_release. Not thread safe:
+// main thread only.
+
+#define PUFU_SLAB_ALIGN 64 // Objects never share a cache line
+
+typedef struct {
+  size_t size;     // Object size, rounded up to PUFU_SLAB_ALIGN
+  int per_chunk;   // Objects per chunk
+  void *free_list; // Linked through the first word of each free object
+  void *chunks;    // Linked through the first word of each chunk
+  int chunk_count;
+  int in_use;        // Objects handed out
+  long long allocs;  // pufu_slab_alloc calls (stats)
+} PufuSlab;
+
+// Static initializer: PufuSlab s = PUFU_SLAB_INIT(sizeof(T), 32);
+#define PUFU_SLAB_INIT(obj_size, count)                                       \
+  {((obj_size) + PUFU_SLAB_ALIGN - 1) / PUFU_SLAB_ALIGN * PUFU_SLAB_ALIGN,    \
+   (count), NULL, NULL, 0, 0, 0}
+
+// Uninitialized object (NULL if a new chunk cannot be allocated)
+void *pufu_slab_alloc(PufuSlab *slab);
+
+void pufu_slab_free(PufuSlab *slab, void *obj);
+
+// Free every chunk. Only when nothing is in use; returns -1 otherwise.
+int pufu_slab_release(PufuSlab *slab);
+
+// Objects the chunks allocated so far can hold
+int pufu_slab_capacity(const PufuSlab *slab);
+
+#endif // PUFU_SLAB_H
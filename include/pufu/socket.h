@@ -42,9 +42,17 @@ typedef struct {
   int (*save_state)(void *buffer, size_t size);
   int (*restore_state)(const void *buffer, size_t size);
 
+  // --- v2 ---
+  uint32_t caps; // PUFU_SOCKET_CAP_* flags
+
 } PufuSocket;
 
-#define PUFU_SOCKET_API_VERSION 1
+#define PUFU_SOCKET_API_VERSION 2
+
+// alu_add/sub/cmp are plain 32-bit integer math with no side effects,
+// so the JIT may inline them. Sockets that log, offload or saturate
+// must leave it unset and keep going through the function pointers.
+#define PUFU_SOCKET_CAP_NATIVE_ALU (1u << 0)
 
 // Función para obtener el socket actual
 PufuSocket *pufu_get_current_socket(void);
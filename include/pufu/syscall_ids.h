@@ -33,6 +33,12 @@ typedef enum {
   SYS_IPC_SEND = 30, // (ipc_send_from_buffer)
   SYS_IPC_READ = 31,
   SYS_IPC_BROADCAST = 32,
+  SYS_BUS_SUBSCRIBE = 33, // VirtualBus signal id -> own mailbox
+  SYS_BUS_SEND = 34,      // "0xID nibbles" onto the VirtualBus (r0 = 0/-1)
+  SYS_IPC_CAPACITY = 35,  // Own mailbox capacity in messages
+  SYS_TOPIC_SUBSCRIBE = 36,   // Topic mail -> own mailbox
+  SYS_TOPIC_UNSUBSCRIBE = 37,
+  SYS_TOPIC_PUBLISH = 38,     // InputBuffer to subscribers (r1 = deliveries)
 
   // Config
   SYS_CONFIG_GET = 40,
@@ -66,7 +72,30 @@ typedef enum {
   SYS_GET_VERSION = 82,         // Get Pufu Version String
   SYS_TRINITY_LOAD_MEOW = 83,   // Load Meow UI File
   SYS_SYSTEM_UPDATE = 99,       // Hot Swap Update
-  SYS_DOWNLOAD_UPDATE = 100
+  SYS_DOWNLOAD_UPDATE = 100,
+
+  // Scheduler
+  SYS_SET_QUANTUM = 110, // Set instructions [and us] per turn
+  SYS_NODE_STATS = 111,  // Node stats line (InputBuffer)
+  SYS_SYSTEM_STATS = 112, // Live/parked/zombie/reaped counters (InputBuffer)
+  SYS_SET_CLASS = 113,    // Scheduling class [and deadline us]
+  SYS_SCHED_STATS = 114,  // Per-class latency report (InputBuffer)
+  SYS_WAIT = 115,         // Park until IPC/input/event/timeout (r0 = source)
+
+  // Shared buffers (handle in a register)
+  SYS_SHM_CREATE = 120,  // Zeroed buffer (r0 = handle)
+  SYS_SHM_LOAD = 121,    // Buffer with a file's contents
+  SYS_SHM_WRITE = 122,   // InputBuffer -> buffer at offset r1
+  SYS_SHM_READ = 123,    // r2 bytes at offset r1 -> InputBuffer
+  SYS_SHM_SEND = 124,    // Share with the InputBuffer target
+  SYS_SHM_GIVE = 125,    // Transfer to the InputBuffer target
+  SYS_SHM_ACCEPT = 126,  // Handle from a "shm <handle> <size>" mail
+  SYS_SHM_RELEASE = 127, // Drop own reference
+
+  // Request/response calls
+  SYS_CALL = 130,       // InputBuffer to a server, park for the reply
+  SYS_RPC_ACCEPT = 131, // Next request: id in a register, body in buffer
+  SYS_REPLY = 132       // InputBuffer answers an accepted request
 
 } PufuSyscallID;
 
@@ -13,9 +13,19 @@ void pufu_terminal_init(void);
 // Restore terminal to original settings
 void pufu_terminal_restore(void);
 
+// Batch mode (pufu_os --batch): no prompt redraw; pufu_tws_output goes to
+// out_fd, logs stay on stdout
+void pufu_terminal_set_batch(int out_fd);
+
 // Non-blocking character read (returns 0 if no input)
 int pufu_terminal_get_key(void);
 
+// 1 if a key is waiting; it stays there for pufu_terminal_get_key
+int pufu_terminal_key_ready(void);
+
+// 1 if pufu_terminal_key_ready already pulled a key off stdin (no read)
+int pufu_terminal_key_buffered(void);
+
 // Log a message cleanly without breaking the input line
 void pufu_log(const char *fmt, ...);
 
@@ -56,4 +66,9 @@ int pufu_tws_get_active(void);
 // Log to a specific TWS (or active)
 void pufu_tws_log(int tws_id, const char *fmt, ...);
 
+// Program output ((write), (log_buffer), (cat), (print_char)): a TWS log
+// line / raw char on the terminal, or the batch output stream
+void pufu_tws_output(int tws_id, const char *fmt, ...);
+void pufu_terminal_put_char(int ch);
+
 #endif // PUFU_TERMINAL_H
@@ -0,0 +1,46 @@
+#ifndef PUFU_TIMER_WHEEL_H
+#define PUFU_TIMER_WHEEL_H
+
+// Hierarchical Timer Wheel (1 ms ticks)
+// Four levels of 64 slots cover ~4.6 hours; longer timers park in the last
+// level and are re-filed as they cascade. Add, cancel and fire are O(1);
+// advancing costs one slot check per elapsed tick.
+
+#define PUFU_WHEEL_BITS 6
+#define PUFU_WHEEL_SLOTS (1 << PUFU_WHEEL_BITS)
+#define PUFU_WHEEL_LEVELS 4
+
+// Intrusive timer: embed it in the object that sleeps
+typedef struct PufuTimer {
+  struct PufuTimer *next;
+  struct PufuTimer *prev;
+  long long expires; // Absolute time (ms)
+  int armed;         // Linked into a wheel slot
+} PufuTimer;
+
+typedef struct {
+  long long now; // Last tick processed (ms)
+  int count;     // Armed timers
+  PufuTimer slots[PUFU_WHEEL_LEVELS][PUFU_WHEEL_SLOTS]; // List heads
+} PufuTimerWheel;
+
+// Start an empty wheel at time `now` (ms)
+void pufu_timer_wheel_init(PufuTimerWheel *wheel, long long now);
+
+// Arm `timer` to fire at `expires`. Past deadlines fire on the next tick.
+void pufu_timer_add(PufuTimerWheel *wheel, PufuTimer *timer,
+                    long long expires);
+
+// Disarm `timer` (no-op if it is not armed)
+void pufu_timer_cancel(PufuTimerWheel *wheel, PufuTimer *timer);
+
+// Process every tick up to `now`, calling fire() for each expired timer
+// (already disarmed, so fire() may re-add it). Returns the number fired.
+int pufu_timer_wheel_advance(PufuTimerWheel *wheel, long long now,
+                             void (*fire)(PufuTimer *timer, void *arg),
+                             void *arg);
+
+// Earliest armed deadline (ms), or -1 if the wheel is empty
+long long pufu_timer_wheel_next(const PufuTimerWheel *wheel);
+
+#endif // PUFU_TIMER_WHEEL_H
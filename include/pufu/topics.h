@@ -0,0 +1,54 @@
+#ifndef PUFU_TOPICS_H
+#define PUFU_TOPICS_H
+
+// Topics
+// Named publish/subscribe channels. Each topic keeps the PIDs of its
+// subscribers, so a publish reaches only them instead of every node
+// (ipc_broadcast_from_buffer). The table is a hash of names chained per
+// bucket; a topic is created by its first subscriber and freed with the
+// last one. Delivery lives in the node system (pufu_node_publish): a PID
+// that no longer exists is removed there, so exits need no hook here.
+// Main thread only (syscalls).
+
+#define PUFU_TOPIC_BUCKETS 64
+#define PUFU_TOPIC_NAME_MAX 47 // ':' is not allowed (mail is "topic:msg")
+
+typedef struct PufuTopic {
+  char name[PUFU_TOPIC_NAME_MAX + 1];
+  unsigned hash;
+  int *pids; // Subscribers, in subscription order
+  int count;
+  int capacity;
+  struct PufuTopic *next;
+} PufuTopic;
+
+typedef struct {
+  PufuTopic *buckets[PUFU_TOPIC_BUCKETS];
+  int count;         // Topics with at least one subscriber
+  int subscriptions; // Sum of every topic's count
+  long long published;
+  long long delivered;
+  long long refused; // Held back: a subscriber mailbox was full
+  long long unheard; // Published to a topic nobody subscribes to
+} PufuTopicTable;
+
+// 1 if `name` can be a topic (non-empty, short enough, no ':')
+int pufu_topic_valid(const char *name);
+
+// Add `pid` to the topic (created on demand). 0, or -1 (bad name, no
+// memory). Subscribing twice is a no-op.
+int pufu_topic_subscribe(PufuTopicTable *table, const char *name, int pid);
+
+// 0, or -1 if `pid` was not subscribed
+int pufu_topic_unsubscribe(PufuTopicTable *table, const char *name, int pid);
+
+PufuTopic *pufu_topic_find(const PufuTopicTable *table, const char *name);
+
+// Drop subscriber `index` (its PID is gone); the next one moves into
+// `index`. Returns 1 if that was the last and the topic was freed.
+int pufu_topic_remove_at(PufuTopicTable *table, PufuTopic *topic, int index);
+
+void pufu_topic_table_cleanup(PufuTopicTable *table);
+int pufu_topic_format_stats(const PufuTopicTable *table, char *buf, int size);
+
+#endif // PUFU_TOPICS_H
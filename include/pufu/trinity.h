@@ -95,6 +95,7 @@ typedef struct {
 
 void trinity_queue_event(int type, int x, int y, NodeID target);
 bool trinity_dequeue_event(TrinityEvent *out_event);
+int trinity_pending_events(void); // Queued, not yet dequeued
 
 // --- Backend Renderer API ---
 bool trinity_renderer_init(int width, int height, bool headless);
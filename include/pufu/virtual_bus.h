@@ -3,29 +3,114 @@
 
 #include <stdint.h>
 
+// VirtualBus
+// Signals (id + nibble train) travel through a bounded lock-free MPMC ring:
+// one sequence number per slot, producer and consumer cursors on their own
+// cache lines, so any thread may send without a lock. The payload is copied
+// into the slot. pufu_virtual_bus_process (main thread, once per scheduler
+// pass) takes up to PUFU_BUS_BATCH signals and hands each to every route
+// registered for its id: a native handler, or a subscriber node's mailbox
+// (pufu_node_subscribe). A full ring rejects the signal (counted as
+// dropped) instead of blocking the sender.
+
+#define PUFU_BUS_CAPACITY 1024 // Ring slots (power of two)
+#define PUFU_BUS_BATCH 64      // Signals delivered per process call
+#define PUFU_BUS_ROUTE_BUCKETS 64
+#define PUFU_SIGNAL_MAX_BYTES 52 // Slot payload (one cache line per slot)
+#define PUFU_SIGNAL_MAX_NIBBLES (PUFU_SIGNAL_MAX_BYTES * 2)
+
 // Estructura de una Señal (Signal)
 typedef struct {
   uint16_t id;   // ID del tipo de señal (ej. 0x1100 para Red)
   uint16_t size; // Tamaño de los datos en nibbles
-  uint8_t *data; // Datos crudos (nibble train)
+  uint8_t *data; // Datos crudos (nibble train, high nibble first)
 } PufuSignal;
 
+// Route target. `signal->data` is only valid during the call. Returns 0
+// when delivered, 1 when the target refused it (full), -1 when the target
+// is gone: the route is then removed.
+typedef int (*PufuBusHandler)(void *ctx, int key, const PufuSignal *signal);
+
+typedef struct PufuBusRoute {
+  uint16_t id;
+  PufuBusHandler handler;
+  void *ctx;
+  int key; // Handler argument (node routes: the subscriber's PID)
+  struct PufuBusRoute *next;
+} PufuBusRoute;
+
+typedef struct {
+  uint64_t seq; // == position: free for it; == position + 1: filled
+  uint16_t id;
+  uint16_t size;
+  uint8_t data[PUFU_SIGNAL_MAX_BYTES];
+} PufuBusSlot;
+
+typedef struct {
+  long long sent;      // Accepted into the ring
+  long long processed; // Taken off the ring
+  long long delivered; // Handler deliveries
+  long long rejected;  // Refused by a handler (mailbox full)
+  long long dropped;   // Ring full or payload too large
+  long long unrouted;  // Processed with no route for the id
+  int depth;           // Signals in the ring now
+  int max_depth;       // Deepest seen by pufu_virtual_bus_process
+} PufuBusStats;
+
 // Estructura de VirtualBus (Bus de Mensajes)
 typedef struct {
-  // Cola de señales (simplificada por ahora)
-  PufuSignal *signal_queue;
-  int queue_size;
+  PufuBusSlot *slots; // PUFU_BUS_CAPACITY
+  uint64_t enqueue_pos __attribute__((aligned(64))); // Total sent
+  uint64_t dequeue_pos __attribute__((aligned(64))); // Total processed
+  long long dropped __attribute__((aligned(64)));    // Atomic
+  int waiting; // Main thread about to block: the next send kicks wake_fd
+  int wake_fd; // eventfd
+
+  // Main thread only
+  PufuBusRoute *routes[PUFU_BUS_ROUTE_BUCKETS];
+  long long delivered;
+  long long rejected;
+  long long unrouted;
+  int max_depth;
 } PufuVirtualBus;
 
 // Inicializar VirtualBus
 PufuVirtualBus *pufu_virtual_bus_init(void);
 
-// Enviar una señal al bus
+// Enviar una señal al bus (any thread). `size` in nibbles, at most
+// PUFU_SIGNAL_MAX_NIBBLES. Returns 0, or -1 if it was dropped.
 int pufu_virtual_bus_send(PufuVirtualBus *bus, uint16_t id, uint8_t *data,
                           uint16_t size);
 
-// Procesar señales pendientes
-void pufu_virtual_bus_process(PufuVirtualBus *bus);
+// Procesar señales pendientes: deliver up to PUFU_BUS_BATCH of them.
+// Returns how many were taken off the ring.
+int pufu_virtual_bus_process(PufuVirtualBus *bus);
+
+// Deliver signals with `id` to handler(ctx, key, ...) (main thread).
+// Routing the same (id, handler, ctx, key) again is a no-op.
+int pufu_virtual_bus_route(PufuVirtualBus *bus, uint16_t id,
+                           PufuBusHandler handler, void *ctx, int key);
+void pufu_virtual_bus_unroute(PufuVirtualBus *bus, uint16_t id,
+                              PufuBusHandler handler, void *ctx, int key);
+
+// Before blocking: ask senders to kick the wake fd. Returns the depth; if
+// it is not 0 there is work and the caller should not block.
+int pufu_virtual_bus_arm(PufuVirtualBus *bus);
+
+// Readable after a kick; pufu_virtual_bus_ack drains it
+int pufu_virtual_bus_fd(const PufuVirtualBus *bus);
+void pufu_virtual_bus_ack(PufuVirtualBus *bus);
+
+int pufu_virtual_bus_depth(const PufuVirtualBus *bus);
+void pufu_virtual_bus_stats(const PufuVirtualBus *bus, PufuBusStats *out);
+int pufu_virtual_bus_format_stats(const PufuVirtualBus *bus, char *buf,
+                                  int size);
+
+// Text form "0xID nibbles" (e.g. "0x1100 a1b"), as nodes see signals
+int pufu_signal_format(const PufuSignal *signal, char *buf, int size);
+// Parse the text form into `data` (PUFU_SIGNAL_MAX_BYTES); -1 if invalid
+int pufu_signal_parse(const char *text, uint16_t *id, uint8_t *data,
+                      uint16_t *size);
 
 // Liberar VirtualBus
 void pufu_virtual_bus_cleanup(PufuVirtualBus *bus);
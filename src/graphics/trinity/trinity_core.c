@@ -1,4 +1,5 @@
 #include "pufu/graphics.h"
+#include "pufu/boot_trace.h"
 // #include "../renderer/opengl_es_backend.h" -> Moved to backend, but we should
 // use abstractions if possible. For now, let's fix path relative to include or
 // just use "pufu/graphics.h" if it exposes backend? Actually, let's look for
@@ -25,6 +26,7 @@ void trinity_init() {
   // Font loading delegated to render module init?
   // Or just do it here as part of global init.
   // We need file access.
+  long long t0 = pufu_boot_trace_now();
   FILE *f = fopen("media/fonts/static/Merriweather_24pt-Regular.ttf", "rb");
   if (f) {
     fseek(f, 0, SEEK_END);
@@ -41,6 +43,7 @@ void trinity_init() {
   } else {
     printf("[TRINITY] ERROR: Font not found.\n");
   }
+  pufu_boot_trace_span("trinity_font", t0);
 }
 
 void trinity_shutdown() {
@@ -98,6 +98,8 @@ bool trinity_dequeue_event(TrinityEvent *out_event) {
   return true;
 }
 
+int trinity_pending_events(void) { return g_event_count; }
+
 // --- Interaction Logic (Extract from Step) ---
 void trinity_update_interaction(void) {
   // Logic from old trinity_step
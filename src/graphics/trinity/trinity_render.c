@@ -1,4 +1,5 @@
 // #include "../../graphics/backend/opengl_es_backend.h"
+#include "pufu/boot_trace.h"
 #include "pufu/graphics.h"
 #include "pufu/trinity.h"
 #include "trinity_internal.h"
@@ -228,6 +229,18 @@ void trinity_render_frame(void) {
   }
 
   trinity_renderer_frame_end();
+
+  // Boot trace: first frame of each window, until the boot is over
+  if (pufu_boot_trace_done())
+    return;
+  for (int i = 0; i < node_count; i++) {
+    Node *n = &node_pool[i];
+    if ((n->data_type == DATA_WINDOW || n->data_type == DATA_FRAME) &&
+        (n->flags & NODE_FLAG_VISIBLE) && !(n->flags & NODE_FLAG_PRESENTED)) {
+      n->flags |= NODE_FLAG_PRESENTED;
+      pufu_boot_trace_frame(n->name);
+    }
+  }
 }
 
 // --- Lifecycle Support ---
@@ -250,8 +263,10 @@ void trinity_prepare(void) {
 
   // 2. Init Backend
   if (!renderer_active) {
+    long long t0 = pufu_boot_trace_now();
     renderer_active = trinity_renderer_init(
         win_w > 0 ? win_w : 800, win_h > 0 ? win_h : 600, !found_window);
+    pufu_boot_trace_span("renderer_init", t0);
   } else {
     if (found_window) {
       trinity_renderer_restore();
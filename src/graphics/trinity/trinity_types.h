@@ -13,7 +13,8 @@ typedef enum {
   NODE_FLAG_NONE = 0,
   NODE_FLAG_VISIBLE = 1 << 0,
   NODE_FLAG_PERSIST = 1 << 1,       // Se guarda al hibernar
-  NODE_FLAG_HIGH_PRECISION = 1 << 2 // Usa double en lógica (si aplica)
+  NODE_FLAG_HIGH_PRECISION = 1 << 2, // Usa double en lógica (si aplica)
+  NODE_FLAG_PRESENTED = 1 << 3       // Window already in a finished frame
 } NodeFlags;
 
 // Definición de como interpretar el 'data_ptr'
@@ -242,7 +242,8 @@ static PufuSocket arm_socket = {.init = arm_init,
                                 .syscall = NULL,
                                 .get_state_size = NULL,
                                 .save_state = NULL,
-                                .restore_state = NULL};
+                                .restore_state = NULL,
+                                .caps = PUFU_SOCKET_CAP_NATIVE_ALU};
 
 // -- Simple State Persistence Implementation --
 static int socket_counter = 0;
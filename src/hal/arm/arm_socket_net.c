@@ -87,7 +87,8 @@ static PufuSocket v2_socket = {.init = socket_init_net,
                                .syscall = NULL,
                                .get_state_size = NULL,
                                .save_state = NULL,
-                               .restore_state = NULL};
+                               .restore_state = NULL,
+                               .caps = 0}; // Cloud ALU: never inlined
 
 // -- V2 State Persistence --
 static int socket_counter = -1; // New default
@@ -7,6 +7,7 @@
 // Estado del loader
 static void *current_handle = NULL;
 static PufuSocket *current_socket = NULL;
+static void (*quiesce)(void) = NULL;
 
 // Backup para rollback (Futura implementación Watchdog)
 // static void *backup_handle = NULL;
@@ -83,6 +84,10 @@ static void rollback_swap(void) {
   }
 }
 
+void pufu_loader_set_quiesce(void (*quiesce_func)(void)) {
+  quiesce = quiesce_func;
+}
+
 int pufu_reload_socket(const char *path) {
   printf("[Loader] Iniciando Hot Swap con: %s\n", path);
 
@@ -160,7 +165,9 @@ int pufu_reload_socket(const char *path) {
     free(state_buffer);
   }
 
-  // 5. Swap
+  // 5. Swap (worker threads may still be inside the old ALU)
+  if (quiesce)
+    quiesce();
   if (current_socket) {
     current_socket->cleanup();
     dlclose(current_handle);
@@ -0,0 +1,178 @@
+#include "pufu/mailbox.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Record header; sender and content follow without terminators. A shared
+// record carries a PufuMailPayload pointer instead of the content.
+typedef struct {
+  uint8_t type;
+  uint8_t sender_len;
+  uint16_t content_len; // SHARED_RECORD: a payload pointer follows
+} MailRecord;
+
+#define SHARED_RECORD 0xffff
+
+int pufu_mailbox_init(PufuMailbox *mailbox, int capacity) {
+  memset(mailbox, 0, sizeof(PufuMailbox));
+  mailbox->arena = malloc(PUFU_MAILBOX_ARENA_MIN);
+  if (!mailbox->arena)
+    return -1;
+  mailbox->arena_size = PUFU_MAILBOX_ARENA_MIN;
+  pufu_mailbox_set_capacity(mailbox, capacity);
+  return 0;
+}
+
+int pufu_mailbox_set_capacity(PufuMailbox *mailbox, int capacity) {
+  if (capacity < 1)
+    capacity = 1;
+  if (capacity > PUFU_MAILBOX_MAX_CAPACITY)
+    capacity = PUFU_MAILBOX_MAX_CAPACITY;
+  mailbox->capacity = capacity;
+  return capacity;
+}
+
+// Ring copies: a record may wrap around the end of the arena
+static int copy_in(PufuMailbox *mailbox, int pos, const void *src, int n) {
+  int first = mailbox->arena_size - pos;
+  if (first > n)
+    first = n;
+  memcpy(mailbox->arena + pos, src, first);
+  memcpy(mailbox->arena, (const char *)src + first, n - first);
+  return (pos + n) % mailbox->arena_size;
+}
+
+static int copy_out(const PufuMailbox *mailbox, int pos, void *dst, int n) {
+  int first = mailbox->arena_size - pos;
+  if (first > n)
+    first = n;
+  memcpy(dst, mailbox->arena + pos, first);
+  memcpy((char *)dst + first, mailbox->arena, n - first);
+  return (pos + n) % mailbox->arena_size;
+}
+
+// Double the arena until `need` more bytes fit; records are moved to the
+// start of the new one (tail = 0)
+static int grow(PufuMailbox *mailbox, int need) {
+  int size = mailbox->arena_size;
+  while (size - mailbox->used < need)
+    size *= 2;
+  char *arena = malloc(size);
+  if (!arena)
+    return -1;
+  copy_out(mailbox, mailbox->tail, arena, mailbox->used);
+  free(mailbox->arena);
+  mailbox->arena = arena;
+  mailbox->arena_size = size;
+  mailbox->tail = 0;
+  mailbox->head = mailbox->used % size;
+  return 0;
+}
+
+// Either `content` or `payload` (shared record)
+static int append(PufuMailbox *mailbox, const char *sender,
+                  const char *content, PufuMailPayload *payload, int type) {
+  if (mailbox->count >= mailbox->capacity) {
+    mailbox->dropped++;
+    return PUFU_MAIL_FULL;
+  }
+  MailRecord record;
+  size_t sender_len = strlen(sender);
+  record.type = (uint8_t)type;
+  record.sender_len = sender_len > PUFU_MAIL_SENDER_MAX ? PUFU_MAIL_SENDER_MAX
+                                                        : sender_len;
+  int body = sizeof(payload);
+  if (payload) {
+    record.content_len = SHARED_RECORD;
+  } else {
+    size_t content_len = strlen(content);
+    record.content_len = content_len > PUFU_MAIL_CONTENT_MAX
+                             ? PUFU_MAIL_CONTENT_MAX
+                             : content_len;
+    body = record.content_len;
+  }
+
+  int need = sizeof(record) + record.sender_len + body;
+  if (mailbox->arena_size - mailbox->used < need && grow(mailbox, need) < 0) {
+    mailbox->dropped++;
+    return PUFU_MAIL_NO_MEMORY;
+  }
+  int pos = copy_in(mailbox, mailbox->head, &record, sizeof(record));
+  pos = copy_in(mailbox, pos, sender, record.sender_len);
+  if (payload) {
+    payload->refs++;
+    mailbox->head = copy_in(mailbox, pos, &payload, sizeof(payload));
+  } else {
+    mailbox->head = copy_in(mailbox, pos, content, record.content_len);
+  }
+  mailbox->used += need;
+  mailbox->posted++;
+  if (++mailbox->count > mailbox->max_count)
+    mailbox->max_count = mailbox->count;
+  return PUFU_MAIL_OK;
+}
+
+int pufu_mailbox_post(PufuMailbox *mailbox, const char *sender,
+                      const char *content, int type) {
+  return append(mailbox, sender, content, NULL, type);
+}
+
+int pufu_mailbox_post_shared(PufuMailbox *mailbox, const char *sender,
+                             PufuMailPayload *payload, int type) {
+  return append(mailbox, sender, NULL, payload, type);
+}
+
+PufuMailPayload *pufu_mail_payload_create(const char *content) {
+  size_t len = strlen(content);
+  if (len > PUFU_MAIL_CONTENT_MAX)
+    len = PUFU_MAIL_CONTENT_MAX;
+  PufuMailPayload *payload = malloc(sizeof(PufuMailPayload) + len + 1);
+  if (!payload)
+    return NULL;
+  payload->refs = 1;
+  payload->len = (int)len;
+  memcpy(payload->data, content, len);
+  payload->data[len] = '\0';
+  return payload;
+}
+
+void pufu_mail_payload_release(PufuMailPayload *payload) {
+  if (payload && --payload->refs == 0)
+    free(payload);
+}
+
+int pufu_mailbox_take(PufuMailbox *mailbox, PufuMessage *out) {
+  if (!mailbox || mailbox->count == 0)
+    return 0;
+  MailRecord record;
+  int pos = copy_out(mailbox, mailbox->tail, &record, sizeof(record));
+  pos = copy_out(mailbox, pos, out->sender, record.sender_len);
+  out->sender[record.sender_len] = '\0';
+  int body = record.content_len;
+  if (record.content_len == SHARED_RECORD) {
+    PufuMailPayload *payload;
+    body = sizeof(payload);
+    mailbox->tail = copy_out(mailbox, pos, &payload, body);
+    memcpy(out->content, payload->data, payload->len + 1);
+    pufu_mail_payload_release(payload);
+  } else {
+    mailbox->tail = copy_out(mailbox, pos, out->content, body);
+    out->content[body] = '\0';
+  }
+  out->type = record.type;
+  mailbox->used -= sizeof(record) + record.sender_len + body;
+  mailbox->count--;
+  if (mailbox->count == 0)
+    mailbox->head = mailbox->tail = 0; // Keep records contiguous
+  return 1;
+}
+
+void pufu_mailbox_cleanup(PufuMailbox *mailbox) {
+  if (!mailbox)
+    return;
+  PufuMessage unread; // Drops the references of shared records
+  while (pufu_mailbox_take(mailbox, &unread))
+    ;
+  free(mailbox->arena);
+  mailbox->arena = NULL;
+}
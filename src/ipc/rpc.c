@@ -0,0 +1,56 @@
+#include "pufu/rpc.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static int next_id = 0;
+
+int pufu_rpc_next_id(void) {
+  if (++next_id <= 0) // Wrapped
+    next_id = 1;
+  return next_id;
+}
+
+int pufu_rpc_accept(PufuRpcAccepted *accepted, int id, int caller) {
+  if (accepted->count == accepted->capacity) {
+    int capacity = accepted->capacity ? accepted->capacity * 2 : 8;
+    if (capacity > PUFU_RPC_ACCEPT_MAX)
+      return -1;
+    PufuRpcRequest *requests =
+        realloc(accepted->requests, capacity * sizeof(PufuRpcRequest));
+    if (!requests)
+      return -1;
+    accepted->requests = requests;
+    accepted->capacity = capacity;
+  }
+  accepted->requests[accepted->count].id = id;
+  accepted->requests[accepted->count].caller = caller;
+  accepted->count++;
+  return 0;
+}
+
+int pufu_rpc_take(PufuRpcAccepted *accepted, int id) {
+  // Newest first: a server usually answers what it just accepted
+  for (int i = accepted->count - 1; i >= 0; i--) {
+    if (accepted->requests[i].id == id) {
+      int caller = accepted->requests[i].caller;
+      accepted->requests[i] = accepted->requests[--accepted->count];
+      return caller;
+    }
+  }
+  return -1;
+}
+
+void pufu_rpc_accepted_clear(PufuRpcAccepted *accepted) {
+  free(accepted->requests);
+  accepted->requests = NULL;
+  accepted->count = 0;
+  accepted->capacity = 0;
+}
+
+int pufu_rpc_format_stats(const PufuRpcStats *stats, char *buf, int size) {
+  return snprintf(buf, size,
+                  "rpc: calls=%lld replies=%lld timeouts=%lld failed=%lld "
+                  "late=%lld",
+                  stats->calls, stats->replies, stats->timeouts,
+                  stats->failed, stats->late);
+}
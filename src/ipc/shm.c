@@ -0,0 +1,135 @@
+#include "pufu/shm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#define SLOT_BITS 10 // log2(PUFU_SHM_MAX_BUFFERS)
+#define SLOT_MASK (PUFU_SHM_MAX_BUFFERS - 1)
+#define GENERATION_MAX (0x7fffffff >> SLOT_BITS)
+
+typedef struct {
+  void *data; // NULL: free slot
+  int size;
+  int refs;
+  int generation; // Bumped on every reuse, part of the handle
+} ShmSlot;
+
+static ShmSlot slots[PUFU_SHM_MAX_BUFFERS];
+static int live_count = 0;
+static long long live_bytes = 0;
+static long long created = 0;
+static int next_slot = 0; // Where the search for a free slot starts
+
+static ShmSlot *lookup(int handle) {
+  if (handle <= 0)
+    return NULL;
+  ShmSlot *slot = &slots[handle & SLOT_MASK];
+  if (!slot->data || slot->generation != handle >> SLOT_BITS)
+    return NULL;
+  return slot;
+}
+
+int pufu_shm_create(int size) {
+  if (size <= 0 || size > PUFU_SHM_MAX_SIZE ||
+      live_count >= PUFU_SHM_MAX_BUFFERS)
+    return -1;
+  int index = next_slot;
+  while (slots[index].data)
+    index = (index + 1) & SLOT_MASK;
+  ShmSlot *slot = &slots[index];
+  // Own mapping: zero pages arrive on first touch, so creating a large
+  // buffer costs nothing until it is written (calloc would clear it)
+  void *data = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED)
+    return -1;
+  slot->data = data;
+  slot->size = size;
+  slot->refs = 1;
+  if (++slot->generation > GENERATION_MAX)
+    slot->generation = 1;
+  next_slot = (index + 1) & SLOT_MASK;
+  live_count++;
+  live_bytes += size;
+  created++;
+  return (slot->generation << SLOT_BITS) | index;
+}
+
+void *pufu_shm_data(int handle, int *size) {
+  ShmSlot *slot = lookup(handle);
+  if (!slot)
+    return NULL;
+  if (size)
+    *size = slot->size;
+  return slot->data;
+}
+
+int pufu_shm_retain(int handle) {
+  ShmSlot *slot = lookup(handle);
+  if (!slot)
+    return -1;
+  slot->refs++;
+  return 0;
+}
+
+void pufu_shm_release(int handle) {
+  ShmSlot *slot = lookup(handle);
+  if (!slot || --slot->refs > 0)
+    return;
+  munmap(slot->data, slot->size);
+  slot->data = NULL;
+  live_count--;
+  live_bytes -= slot->size;
+}
+
+int pufu_shm_refs_has(const PufuShmRefs *refs, int handle) {
+  for (int i = 0; i < refs->count; i++) {
+    if (refs->handles[i] == handle)
+      return 1;
+  }
+  return 0;
+}
+
+int pufu_shm_refs_add(PufuShmRefs *refs, int handle) {
+  if (!lookup(handle))
+    return -1;
+  if (pufu_shm_refs_has(refs, handle))
+    return 0;
+  if (refs->count == refs->capacity) {
+    int capacity = refs->capacity ? refs->capacity * 2 : 8;
+    if (capacity > PUFU_SHM_NODE_MAX)
+      return 1;
+    int *handles = realloc(refs->handles, capacity * sizeof(int));
+    if (!handles)
+      return 1;
+    refs->handles = handles;
+    refs->capacity = capacity;
+  }
+  pufu_shm_retain(handle);
+  refs->handles[refs->count++] = handle;
+  return 0;
+}
+
+int pufu_shm_refs_drop(PufuShmRefs *refs, int handle) {
+  for (int i = 0; i < refs->count; i++) {
+    if (refs->handles[i] == handle) {
+      refs->handles[i] = refs->handles[--refs->count];
+      pufu_shm_release(handle);
+      return 0;
+    }
+  }
+  return -1;
+}
+
+void pufu_shm_refs_clear(PufuShmRefs *refs) {
+  while (refs->count > 0)
+    pufu_shm_release(refs->handles[--refs->count]);
+  free(refs->handles);
+  refs->handles = NULL;
+  refs->capacity = 0;
+}
+
+int pufu_shm_format_stats(char *buf, int size) {
+  return snprintf(buf, size, "shm: live=%d/%d bytes=%lld created=%lld",
+                  live_count, PUFU_SHM_MAX_BUFFERS, live_bytes, created);
+}
@@ -0,0 +1,123 @@
+#include "pufu/topics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// FNV-1a
+static unsigned hash_name(const char *name) {
+  unsigned h = 2166136261u;
+  for (const unsigned char *p = (const unsigned char *)name; *p; p++)
+    h = (h ^ *p) * 16777619u;
+  return h;
+}
+
+static PufuTopic **bucket_of(PufuTopicTable *table, unsigned hash) {
+  return &table->buckets[hash & (PUFU_TOPIC_BUCKETS - 1)];
+}
+
+int pufu_topic_valid(const char *name) {
+  size_t len = strlen(name);
+  return len > 0 && len <= PUFU_TOPIC_NAME_MAX && !strchr(name, ':');
+}
+
+PufuTopic *pufu_topic_find(const PufuTopicTable *table, const char *name) {
+  unsigned hash = hash_name(name);
+  PufuTopic *topic = table->buckets[hash & (PUFU_TOPIC_BUCKETS - 1)];
+  while (topic && (topic->hash != hash || strcmp(topic->name, name) != 0))
+    topic = topic->next;
+  return topic;
+}
+
+static PufuTopic *create_topic(PufuTopicTable *table, const char *name) {
+  PufuTopic *topic = calloc(1, sizeof(PufuTopic));
+  if (!topic)
+    return NULL;
+  strcpy(topic->name, name);
+  topic->hash = hash_name(name);
+  PufuTopic **head = bucket_of(table, topic->hash);
+  topic->next = *head;
+  *head = topic;
+  table->count++;
+  return topic;
+}
+
+static void free_topic(PufuTopicTable *table, PufuTopic *topic) {
+  PufuTopic **link = bucket_of(table, topic->hash);
+  while (*link != topic)
+    link = &(*link)->next;
+  *link = topic->next;
+  table->count--;
+  free(topic->pids);
+  free(topic);
+}
+
+int pufu_topic_subscribe(PufuTopicTable *table, const char *name, int pid) {
+  if (!pufu_topic_valid(name))
+    return -1;
+  PufuTopic *topic = pufu_topic_find(table, name);
+  if (!topic && !(topic = create_topic(table, name)))
+    return -1;
+  for (int i = 0; i < topic->count; i++) {
+    if (topic->pids[i] == pid)
+      return 0;
+  }
+  if (topic->count == topic->capacity) {
+    int capacity = topic->capacity ? topic->capacity * 2 : 4;
+    int *pids = realloc(topic->pids, capacity * sizeof(int));
+    if (!pids) {
+      if (topic->count == 0)
+        free_topic(table, topic);
+      return -1;
+    }
+    topic->pids = pids;
+    topic->capacity = capacity;
+  }
+  topic->pids[topic->count++] = pid;
+  table->subscriptions++;
+  return 0;
+}
+
+int pufu_topic_remove_at(PufuTopicTable *table, PufuTopic *topic, int index) {
+  memmove(&topic->pids[index], &topic->pids[index + 1],
+          (topic->count - index - 1) * sizeof(int));
+  topic->count--;
+  table->subscriptions--;
+  if (topic->count > 0)
+    return 0;
+  free_topic(table, topic);
+  return 1;
+}
+
+int pufu_topic_unsubscribe(PufuTopicTable *table, const char *name, int pid) {
+  PufuTopic *topic = pufu_topic_find(table, name);
+  for (int i = 0; topic && i < topic->count; i++) {
+    if (topic->pids[i] == pid) {
+      pufu_topic_remove_at(table, topic, i);
+      return 0;
+    }
+  }
+  return -1;
+}
+
+void pufu_topic_table_cleanup(PufuTopicTable *table) {
+  for (int b = 0; b < PUFU_TOPIC_BUCKETS; b++) {
+    PufuTopic *topic = table->buckets[b];
+    while (topic) {
+      PufuTopic *next = topic->next;
+      free(topic->pids);
+      free(topic);
+      topic = next;
+    }
+    table->buckets[b] = NULL;
+  }
+  table->count = 0;
+  table->subscriptions = 0;
+}
+
+int pufu_topic_format_stats(const PufuTopicTable *table, char *buf, int size) {
+  return snprintf(buf, size,
+                  "topics: live=%d subs=%d published=%lld delivered=%lld "
+                  "refused=%lld unheard=%lld",
+                  table->count, table->subscriptions, table->published,
+                  table->delivered, table->refused, table->unheard);
+}
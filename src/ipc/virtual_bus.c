@@ -1,15 +1,29 @@
 #include "pufu/virtual_bus.h"
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#define RING_MASK (PUFU_BUS_CAPACITY - 1)
 
 PufuVirtualBus *pufu_virtual_bus_init(void) {
-  PufuVirtualBus *bus = malloc(sizeof(PufuVirtualBus));
+  PufuVirtualBus *bus = aligned_alloc(64, sizeof(PufuVirtualBus));
   if (!bus)
     return NULL;
-
-  bus->signal_queue = NULL; // Por ahora sin cola real
-  bus->queue_size = 0;
+  memset(bus, 0, sizeof(PufuVirtualBus));
+  bus->slots = aligned_alloc(64, PUFU_BUS_CAPACITY * sizeof(PufuBusSlot));
+  bus->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (!bus->slots || bus->wake_fd < 0) {
+    if (bus->wake_fd >= 0)
+      close(bus->wake_fd);
+    free(bus->slots);
+    free(bus);
+    return NULL;
+  }
+  for (int i = 0; i < PUFU_BUS_CAPACITY; i++)
+    bus->slots[i].seq = i;
 
   printf("VirtualBus (IPC) Initialized.\n");
   return bus;
@@ -17,27 +31,266 @@ PufuVirtualBus *pufu_virtual_bus_init(void) {
 
 int pufu_virtual_bus_send(PufuVirtualBus *bus, uint16_t id, uint8_t *data,
                           uint16_t size) {
-  (void)data; // Unused for now
   if (!bus)
     return -1;
+  if (size > PUFU_SIGNAL_MAX_NIBBLES) {
+    __atomic_fetch_add(&bus->dropped, 1, __ATOMIC_RELAXED);
+    return -1;
+  }
 
-  // En una implementación real, esto encolaría la señal.
-  // Por ahora, la procesamos inmediatamente (modo síncrono).
-  printf("VirtualBus: Signal Received [ID: 0x%04X, Size: %d]\n", id, size);
+  // Claim a slot: its seq equals our position once the consumer freed it
+  uint64_t pos = __atomic_load_n(&bus->enqueue_pos, __ATOMIC_RELAXED);
+  PufuBusSlot *slot;
+  for (;;) {
+    slot = &bus->slots[pos & RING_MASK];
+    uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    int64_t diff = (int64_t)(seq - pos);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&bus->enqueue_pos, &pos, pos + 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        break;
+    } else if (diff < 0) { // Still holds a signal from one lap ago: full
+      __atomic_fetch_add(&bus->dropped, 1, __ATOMIC_RELAXED);
+      return -1;
+    } else {
+      pos = __atomic_load_n(&bus->enqueue_pos, __ATOMIC_RELAXED);
+    }
+  }
+  slot->id = id;
+  slot->size = size;
+  if (size)
+    memcpy(slot->data, data, (size + 1) / 2);
+  __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
 
-  // Aquí iría la lógica de enrutamiento (Routing Table)
-  // Ej: Si ID == 0x1100 -> Enviar a Node_Net
+  // Pairs with pufu_virtual_bus_arm: either it sees this signal or we see
+  // `waiting` and wake it up
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&bus->waiting, __ATOMIC_RELAXED) &&
+      __atomic_exchange_n(&bus->waiting, 0, __ATOMIC_RELAXED)) {
+    uint64_t one = 1;
+    if (write(bus->wake_fd, &one, sizeof(one)) < 0) {
+      // Counter saturated: the fd is readable anyway
+    }
+  }
+  return 0;
+}
+
+// Take the oldest signal (copied into `out`/`data`); 0 if the ring is empty
+static int take(PufuVirtualBus *bus, PufuSignal *out, uint8_t *data) {
+  uint64_t pos = __atomic_load_n(&bus->dequeue_pos, __ATOMIC_RELAXED);
+  PufuBusSlot *slot;
+  for (;;) {
+    slot = &bus->slots[pos & RING_MASK];
+    uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    int64_t diff = (int64_t)(seq - (pos + 1));
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&bus->dequeue_pos, &pos, pos + 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        break;
+    } else if (diff < 0) { // Not filled yet
+      return 0;
+    } else {
+      pos = __atomic_load_n(&bus->dequeue_pos, __ATOMIC_RELAXED);
+    }
+  }
+  out->id = slot->id;
+  out->size = slot->size;
+  out->data = data;
+  if (slot->size)
+    memcpy(data, slot->data, (slot->size + 1) / 2);
+  __atomic_store_n(&slot->seq, pos + PUFU_BUS_CAPACITY, __ATOMIC_RELEASE);
+  return 1;
+}
+
+// Fibonacci hash: ids tend to differ in the high byte (0x1100, 0x1200)
+static unsigned bucket_of(uint16_t id) {
+  return ((uint16_t)(id * 40503u) >> 10) & (PUFU_BUS_ROUTE_BUCKETS - 1);
+}
+
+static void dispatch(PufuVirtualBus *bus, const PufuSignal *signal) {
+  int routed = 0;
+  PufuBusRoute **link = &bus->routes[bucket_of(signal->id)];
+  while (*link) {
+    PufuBusRoute *route = *link;
+    if (route->id != signal->id) {
+      link = &route->next;
+      continue;
+    }
+    routed = 1;
+    int result = route->handler(route->ctx, route->key, signal);
+    if (result < 0) { // Target gone
+      *link = route->next;
+      free(route);
+      continue;
+    }
+    if (result > 0)
+      bus->rejected++;
+    else
+      bus->delivered++;
+    link = &route->next;
+  }
+  if (!routed)
+    bus->unrouted++;
+}
+
+int pufu_virtual_bus_process(PufuVirtualBus *bus) {
+  if (!bus)
+    return 0;
+  __atomic_store_n(&bus->waiting, 0, __ATOMIC_RELAXED); // Awake now
+  int depth = pufu_virtual_bus_depth(bus);
+  if (depth > bus->max_depth)
+    bus->max_depth = depth;
+
+  PufuSignal signal;
+  uint8_t data[PUFU_SIGNAL_MAX_BYTES];
+  int taken = 0;
+  while (taken < PUFU_BUS_BATCH && take(bus, &signal, data)) {
+    dispatch(bus, &signal);
+    taken++;
+  }
+  return taken;
+}
+
+int pufu_virtual_bus_route(PufuVirtualBus *bus, uint16_t id,
+                           PufuBusHandler handler, void *ctx, int key) {
+  if (!bus || !handler)
+    return -1;
+  // At the tail: routes fire in subscription order. The walk also finds
+  // an identical route, which is kept as is (one delivery per signal).
+  PufuBusRoute **link = &bus->routes[bucket_of(id)];
+  for (; *link; link = &(*link)->next) {
+    const PufuBusRoute *other = *link;
+    if (other->id == id && other->handler == handler && other->ctx == ctx &&
+        other->key == key)
+      return 0;
+  }
 
+  PufuBusRoute *route = malloc(sizeof(PufuBusRoute));
+  if (!route)
+    return -1;
+  route->id = id;
+  route->handler = handler;
+  route->ctx = ctx;
+  route->key = key;
+  route->next = NULL;
+  *link = route;
   return 0;
 }
 
-void pufu_virtual_bus_process(PufuVirtualBus *bus) {
-  // Procesar cola de señales
-  (void)bus;
+void pufu_virtual_bus_unroute(PufuVirtualBus *bus, uint16_t id,
+                              PufuBusHandler handler, void *ctx, int key) {
+  if (!bus)
+    return;
+  PufuBusRoute **link = &bus->routes[bucket_of(id)];
+  while (*link) {
+    PufuBusRoute *route = *link;
+    if (route->id == id && route->handler == handler && route->ctx == ctx &&
+        route->key == key) {
+      *link = route->next;
+      free(route);
+      return;
+    }
+    link = &route->next;
+  }
+}
+
+int pufu_virtual_bus_arm(PufuVirtualBus *bus) {
+  if (!bus)
+    return 0;
+  __atomic_store_n(&bus->waiting, 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  return pufu_virtual_bus_depth(bus);
+}
+
+int pufu_virtual_bus_fd(const PufuVirtualBus *bus) {
+  return bus ? bus->wake_fd : -1;
+}
+
+void pufu_virtual_bus_ack(PufuVirtualBus *bus) {
+  uint64_t count;
+  if (read(bus->wake_fd, &count, sizeof(count)) < 0) {
+    // EAGAIN: already drained
+  }
+}
+
+int pufu_virtual_bus_depth(const PufuVirtualBus *bus) {
+  uint64_t head = __atomic_load_n(&bus->dequeue_pos, __ATOMIC_RELAXED);
+  uint64_t tail = __atomic_load_n(&bus->enqueue_pos, __ATOMIC_RELAXED);
+  return tail > head ? (int)(tail - head) : 0;
+}
+
+void pufu_virtual_bus_stats(const PufuVirtualBus *bus, PufuBusStats *out) {
+  out->sent = (long long)__atomic_load_n(&bus->enqueue_pos, __ATOMIC_RELAXED);
+  out->processed =
+      (long long)__atomic_load_n(&bus->dequeue_pos, __ATOMIC_RELAXED);
+  out->delivered = bus->delivered;
+  out->rejected = bus->rejected;
+  out->dropped = __atomic_load_n(&bus->dropped, __ATOMIC_RELAXED);
+  out->unrouted = bus->unrouted;
+  out->depth = pufu_virtual_bus_depth(bus);
+  out->max_depth = bus->max_depth;
+}
+
+int pufu_virtual_bus_format_stats(const PufuVirtualBus *bus, char *buf,
+                                  int size) {
+  PufuBusStats s;
+  pufu_virtual_bus_stats(bus, &s);
+  return snprintf(buf, size,
+                  "bus: sent=%lld delivered=%lld rejected=%lld dropped=%lld "
+                  "unrouted=%lld depth=%d/%d max=%d",
+                  s.sent, s.delivered, s.rejected, s.dropped, s.unrouted,
+                  s.depth, PUFU_BUS_CAPACITY, s.max_depth);
+}
+
+int pufu_signal_format(const PufuSignal *signal, char *buf, int size) {
+  static const char hex[] = "0123456789abcdef";
+  int len = snprintf(buf, size, "0x%04X ", signal->id);
+  for (int i = 0; i < signal->size && len < size - 1; i++) {
+    uint8_t byte = signal->data[i / 2];
+    buf[len++] = hex[(i & 1) ? byte & 0xf : byte >> 4];
+  }
+  if (len < size)
+    buf[len] = '\0';
+  return len;
+}
+
+int pufu_signal_parse(const char *text, uint16_t *id, uint8_t *data,
+                      uint16_t *size) {
+  char *end;
+  long value = strtol(text, &end, 0);
+  if (end == text || value < 0 || value > 0xffff)
+    return -1;
+  *id = (uint16_t)value;
+  *size = 0;
+  while (*end == ' ')
+    end++;
+  for (; *end && !isspace((unsigned char)*end); end++) {
+    if (!isxdigit((unsigned char)*end) || *size >= PUFU_SIGNAL_MAX_NIBBLES)
+      return -1;
+    int nibble = isdigit((unsigned char)*end)
+                     ? *end - '0'
+                     : tolower((unsigned char)*end) - 'a' + 10;
+    if (*size & 1)
+      data[*size / 2] |= nibble;
+    else
+      data[*size / 2] = nibble << 4;
+    (*size)++;
+  }
+  return 0;
 }
 
 void pufu_virtual_bus_cleanup(PufuVirtualBus *bus) {
-  if (bus) {
-    free(bus);
+  if (!bus)
+    return;
+  for (int b = 0; b < PUFU_BUS_ROUTE_BUCKETS; b++) {
+    PufuBusRoute *route = bus->routes[b];
+    while (route) {
+      PufuBusRoute *next = route->next;
+      free(route);
+      route = next;
+    }
   }
+  close(bus->wake_fd);
+  free(bus->slots);
+  free(bus);
 }
@@ -4,6 +4,8 @@
 #include "syscalls/sys_core.h"
 #include "syscalls/sys_ipc.h"
 #include "syscalls/sys_process.h"
+#include "syscalls/sys_rpc.h"
+#include "syscalls/sys_shm.h"
 #include "syscalls/sys_trinity.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -40,17 +42,29 @@ int pufu_syscall_dispatch(PufuNodeSystem *sys, PufuNode *node,
   case SYS_KILL:
     return sys_kill(sys, node, inst);
   case SYS_EXIT:
-    return sys_exit(node);
+    return sys_exit(node, inst);
   case SYS_SHUTDOWN:
     return sys_shutdown(node);
   case SYS_SLEEP:
     return sys_sleep(node, inst);
+  case SYS_WAIT:
+    return sys_wait(node, inst);
   case SYS_SPAWN_FROM_BUFFER:
     return sys_spawn_from_buffer(sys, node);
   case SYS_KILL_FROM_BUFFER:
     return sys_kill_from_buffer(sys, node);
   case SYS_PARSE_COMMAND:
     return sys_parse_command(node, inst);
+  case SYS_SET_QUANTUM:
+    return sys_set_quantum(node, inst);
+  case SYS_NODE_STATS:
+    return sys_node_stats(node);
+  case SYS_SYSTEM_STATS:
+    return sys_system_stats(sys, node);
+  case SYS_SET_CLASS:
+    return sys_set_class(sys, node, inst);
+  case SYS_SCHED_STATS:
+    return sys_sched_stats(sys, node);
 
   // --- TRINITY ---
   case SYS_TRINITY_INIT:
@@ -89,8 +103,8 @@ int pufu_syscall_dispatch(PufuNodeSystem *sys, PufuNode *node,
     // Keep legacy TWS logic here or move to sys_tws.c?
     // User requested split. I'll keep it short here or move if creating
     // sys_tws.c. For 2 calls, let's keep inline.
-    int id =
-        (strlen(inst->reg1) > 0) ? atoi(inst->reg1) : atoi(node->input_buffer);
+    const char *arg = get_string_arg(node, inst);
+    int id = (strlen(arg) > 0) ? atoi(arg) : atoi(node->input_buffer);
     pufu_tws_switch(id);
     node->ip++;
     return 1;
@@ -107,6 +121,44 @@ int pufu_syscall_dispatch(PufuNodeSystem *sys, PufuNode *node,
     return sys_ipc_read(node, inst);
   case SYS_IPC_BROADCAST:
     return sys_ipc_broadcast(sys, node);
+  case SYS_IPC_CAPACITY:
+    return sys_ipc_capacity(node, inst);
+  case SYS_TOPIC_SUBSCRIBE:
+    return sys_topic_subscribe(sys, node, inst);
+  case SYS_TOPIC_UNSUBSCRIBE:
+    return sys_topic_unsubscribe(sys, node, inst);
+  case SYS_TOPIC_PUBLISH:
+    return sys_topic_publish(sys, node, inst);
+  case SYS_BUS_SUBSCRIBE:
+    return sys_bus_subscribe(sys, node, inst);
+  case SYS_BUS_SEND:
+    return sys_bus_send(sys, node, inst);
+
+  // --- Shared buffers ---
+  case SYS_SHM_CREATE:
+    return sys_shm_create(node, inst);
+  case SYS_SHM_LOAD:
+    return sys_shm_load(node, inst);
+  case SYS_SHM_WRITE:
+    return sys_shm_write(node, inst);
+  case SYS_SHM_READ:
+    return sys_shm_read(node, inst);
+  case SYS_SHM_SEND:
+    return sys_shm_send(sys, node, inst, 0);
+  case SYS_SHM_GIVE:
+    return sys_shm_send(sys, node, inst, 1);
+  case SYS_SHM_ACCEPT:
+    return sys_shm_accept(node, inst);
+  case SYS_SHM_RELEASE:
+    return sys_shm_release(node, inst);
+
+  // --- Request/response calls ---
+  case SYS_CALL:
+    return sys_call(sys, node, inst);
+  case SYS_RPC_ACCEPT:
+    return sys_rpc_accept(node, inst);
+  case SYS_REPLY:
+    return sys_reply(sys, node, inst);
 
   default:
     return 0; // Unknown
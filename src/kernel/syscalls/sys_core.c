@@ -20,6 +20,14 @@ void clean_string_arg(char *dest, const char *src) {
   }
 }
 
+int int_arg(PufuNode *node, PufuInstruction *inst) {
+  if (inst->a_kind == PUFU_OPERAND_REG || inst->a_kind == PUFU_OPERAND_IMM)
+    return get_operand_value(node, inst->a_kind, inst->a);
+  char arg[256];
+  clean_string_arg(arg, get_string_arg(node, inst));
+  return atoi(arg);
+}
+
 // Forward Declaration for external deps if needed
 // Assuming node->tws_id, pufu_tws_log, etc are available via headers.
 // We need headers for process management? pufu/engine.h usually covers
@@ -27,38 +35,31 @@ void clean_string_arg(char *dest, const char *src) {
 
 int sys_write(PufuNode *node, PufuInstruction *inst) {
   char temp_msg[256];
-  clean_string_arg(temp_msg, inst->reg1);
-  pufu_tws_log(node->tws_id, "%s", temp_msg);
+  clean_string_arg(temp_msg, get_string_arg(node, inst));
+  pufu_tws_output(node->tws_id, "%s", temp_msg);
   node->ip++;
   return 1;
 }
 
 int sys_read_char(PufuNode *node, PufuInstruction *inst) {
-  // Requires get_reg_index (Assuming it's available or we rewrite it)
-  // dispatch.c didn't export it. We might need to copy/move it or include
-  // internal. For now, let's implement get_reg_index logic locally or making it
-  // shared. Actually, get_reg_index is static in dispatch.c. We should move it
-  // to a shared utils. Let's assume we copy functionality for now.
-
-  // Simplified logic: strict parsing "r0"..."r8"
-  int reg = -1;
-  if (inst->reg1[0] == 'r' && inst->reg1[1] >= '0' && inst->reg1[1] <= '9') {
-    reg = inst->reg1[1] - '0';
-  }
+  int reg = get_operand_reg(inst->a_kind, inst->a);
 
   if (reg >= 0) {
     int ch = pufu_terminal_get_key();
     node->registers[reg] = (ch > 0) ? ch : 0;
+    if (ch <= 0)
+      node->yielded = PUFU_YIELD_INPUT; // No key: give the turn away
   }
   node->ip++;
   return 1;
 }
 
 // ... sys_console_input is huge. I'll condense or move verbatim.
-// get_reg_index is provided by node.h/node_exec.c
 
 int sys_console_input(PufuNode *node, PufuInstruction *inst) {
-  int reg = (inst->reg1[0]) ? get_reg_index(inst->reg1) : 0;
+  int reg = (inst->a_kind != PUFU_OPERAND_NONE)
+                ? get_operand_reg(inst->a_kind, inst->a)
+                : 0;
   int ch = pufu_terminal_get_key();
   if (ch > 0) {
     if (ch == 10 || ch == 13) {
@@ -93,18 +94,15 @@ int sys_console_input(PufuNode *node, PufuInstruction *inst) {
   } else {
     if (reg >= 0)
       node->registers[reg] = 0;
+    node->yielded = PUFU_YIELD_INPUT; // No key: give the turn away
   }
   node->ip++;
   return 1;
 }
 
-// Helper
-// get_reg_index is provided by node.h/node_exec.c
-
 int sys_print_char(PufuNode *node, PufuInstruction *inst) {
-  int val = get_value(node, inst->reg1);
-  putchar(val);
-  fflush(stdout);
+  int val = get_operand_value(node, inst->a_kind, inst->a);
+  pufu_terminal_put_char(val);
   node->ip++;
   return 1;
 }
@@ -118,7 +116,7 @@ int sys_clear_buffer(PufuNode *node) {
 
 int sys_set_buffer(PufuNode *node, PufuInstruction *inst) {
   char val[256];
-  clean_string_arg(val, inst->reg1);
+  clean_string_arg(val, get_string_arg(node, inst));
   // Debug
   // printf("[KERNEL] SYS_SET_BUFFER: '%s'\n", val);
   strncpy(node->input_buffer, val, 255);
@@ -128,14 +126,14 @@ int sys_set_buffer(PufuNode *node, PufuInstruction *inst) {
 }
 
 int sys_log_buffer(PufuNode *node) {
-  pufu_tws_log(node->tws_id, "%s", node->input_buffer);
+  pufu_tws_output(node->tws_id, "%s", node->input_buffer);
   node->ip++;
   return 1;
 }
 
 int sys_string_cmp(PufuNode *node, PufuInstruction *inst) {
   char target[256];
-  clean_string_arg(target, inst->reg1);
+  clean_string_arg(target, get_string_arg(node, inst));
 
   // Trim newlines
   char *newline = strchr(node->input_buffer, '\n');
@@ -162,7 +160,7 @@ int sys_console_clear(PufuNode *node) {
 
 int sys_set_prompt(PufuNode *node, PufuInstruction *inst) {
   char p[256];
-  clean_string_arg(p, inst->reg1);
+  clean_string_arg(p, get_string_arg(node, inst));
   pufu_terminal_set_prompt(p);
   node->ip++;
   return 1;
@@ -170,13 +168,13 @@ int sys_set_prompt(PufuNode *node, PufuInstruction *inst) {
 
 int sys_cat(PufuNode *node, PufuInstruction *inst) {
   char filename[256];
-  clean_string_arg(filename, inst->reg1);
+  clean_string_arg(filename, get_string_arg(node, inst));
   FILE *f = fopen(filename, "r");
   if (f) {
     char line[256];
     while (fgets(line, sizeof(line), f)) {
       line[strcspn(line, "\n")] = 0;
-      pufu_log("%s", line);
+      pufu_tws_output(node->tws_id, "%s", line);
     }
     fclose(f);
   } else {
@@ -188,7 +186,7 @@ int sys_cat(PufuNode *node, PufuInstruction *inst) {
 
 int sys_config_get(PufuNode *node, PufuInstruction *inst) {
   char key[256]; // Was 64, caused stack smash via clean_string_arg (255 bytes)
-  clean_string_arg(key, inst->reg1);
+  clean_string_arg(key, get_string_arg(node, inst));
   printf("[DEBUG] sys_config_get: Key='%s'\n", key);
   node->input_buffer[0] = 0;
   FILE *f = fopen("user_config.pufu", "r");
@@ -225,7 +223,7 @@ int sys_config_get(PufuNode *node, PufuInstruction *inst) {
 
 int sys_prepend_string(PufuNode *node, PufuInstruction *inst) {
   char prefix[256];
-  clean_string_arg(prefix, inst->reg1);
+  clean_string_arg(prefix, get_string_arg(node, inst));
   char temp[512];
   snprintf(temp, sizeof(temp), "%s%s", prefix, node->input_buffer);
   strncpy(node->input_buffer, temp, 255);
@@ -235,7 +233,7 @@ int sys_prepend_string(PufuNode *node, PufuInstruction *inst) {
 
 int sys_append_string(PufuNode *node, PufuInstruction *inst) {
   char suffix[256];
-  clean_string_arg(suffix, inst->reg1);
+  clean_string_arg(suffix, get_string_arg(node, inst));
   char temp[512];
   snprintf(temp, sizeof(temp), "%s%s", node->input_buffer, suffix);
   strncpy(node->input_buffer, temp, 255);
@@ -263,7 +261,7 @@ int sys_get_version(PufuNode *node) {
 
 int sys_system_update(PufuNode *node, PufuInstruction *inst) {
   char path[256];
-  clean_string_arg(path, inst->reg1);
+  clean_string_arg(path, get_string_arg(node, inst));
   printf("[KERNEL] Requesting System Update -> %s\n", path);
 
   if (pufu_reload_socket(path) < 0) {
@@ -277,7 +275,7 @@ int sys_system_update(PufuNode *node, PufuInstruction *inst) {
 
 int sys_download_update(PufuNode *node, PufuInstruction *inst) {
   char url[256];
-  clean_string_arg(url, inst->reg1);
+  clean_string_arg(url, get_string_arg(node, inst));
   char dest[256] = "/tmp/pufu_update.so"; // Default temp path
 
   // Optional: Allow reg2 to specify dest, but for now fixed.
@@ -7,6 +7,8 @@
 
 // Helper for strings
 void clean_string_arg(char *dest, const char *src);
+// Number given as an immediate, a register or a (quoted) string; 0 if none
+int int_arg(PufuNode *node, PufuInstruction *inst);
 
 int sys_write(PufuNode *node, PufuInstruction *inst);
 int sys_read_char(PufuNode *node, PufuInstruction *inst);
@@ -1,16 +1,23 @@
 #include "sys_ipc.h"
 #include "pufu/engine.h"
+#include "sys_core.h" // clean_string_arg
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-// Assuming PUFU_IPC_QUEUE_SIZE is defined in engine.h or similar?
-// Usually defined in `virtual_bus.h` or `engine.h`
-// Let's assume it's 32 or check header.
+// Mailboxes (pufu/mailbox.h) are allocated on the first delivery and hold
+// node->mailbox_capacity messages; a sender to a full one gets
+// PUFU_MAIL_FULL back instead of losing the message silently.
 
-// Helper for get_reg_index (local)
-// get_reg_index is provided by node.h/node_exec.c
+// Register operands are decoded by the parser (get_operand_reg in
+// node_exec.c)
 
+// "target:message" from the InputBuffer. r0 = 0 (queued), 1 (target
+// mailbox full: the sender gives its turn away so the target can drain it,
+// then retries if it wants) or -1 (no such target, bad format)
 int sys_ipc_send(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst) {
   (void)inst;
+  node->registers[0] = -1;
   char *colon = strchr(node->input_buffer, ':');
   if (colon) {
     *colon = 0;
@@ -19,20 +26,16 @@ int sys_ipc_send(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst) {
     while (*message == ' ')
       message++;
 
-    PufuNode *t = sys->nodes;
-    while (t) {
-      if (strcmp(t->filename, target_name) == 0) {
-        if (t->ipc_count < 32) { // Use default size
-          int h = t->ipc_head;
-          strncpy(t->ipc_queue[h].sender, node->filename, 63);
-          strncpy(t->ipc_queue[h].content, message, 191);
-          t->ipc_queue[h].type = 0;
-          t->ipc_head = (h + 1) % 32;
-          t->ipc_count++;
-        }
-        break;
-      }
-      t = t->next;
+    // Target: PID or filename (pufu_node_find)
+    PufuNode *t = pufu_node_find(sys, target_name);
+    int result = t ? pufu_node_post(t, node->filename, message, 0)
+                   : PUFU_MAIL_NO_MEMORY;
+    if (result == PUFU_MAIL_OK) {
+      pufu_node_wake(sys, t);
+      node->registers[0] = 0;
+    } else if (result == PUFU_MAIL_FULL) {
+      node->registers[0] = 1;
+      node->yielded = PUFU_YIELD_TURN;
     }
   }
   node->ip++;
@@ -40,38 +43,118 @@ int sys_ipc_send(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst) {
 }
 
 int sys_ipc_read(PufuNode *node, PufuInstruction *inst) {
-  int reg = get_reg_index(inst->reg1);
-  if (node->ipc_count > 0) {
-    int t = node->ipc_tail;
-    strncpy(node->input_buffer, node->ipc_queue[t].content, 255);
-    node->ipc_tail = (t + 1) % 32;
-    node->ipc_count--;
+  int reg = get_operand_reg(inst->a_kind, inst->a);
+  PufuMessage msg;
+  if (pufu_mailbox_take(node->mailbox, &msg)) {
+    snprintf(node->input_buffer, sizeof(node->input_buffer), "%s",
+             msg.content);
     if (reg >= 0)
       node->registers[reg] = 1;
   } else {
     if (reg >= 0)
       node->registers[reg] = 0;
+    node->yielded = PUFU_YIELD_IPC; // Empty mailbox: give the turn away
   }
   node->ip++;
   return 1;
 }
 
+// Every other node gets the InputBuffer (type 2), one shared copy.
+// r0 = nodes whose mailbox refused the message (0: everyone got it)
 int sys_ipc_broadcast(PufuNodeSystem *sys, PufuNode *node) {
-  char *msg = node->input_buffer;
-  PufuNode *t = sys->nodes;
-  while (t) {
-    if (t != node && t->active) {
-      if (t->ipc_count < 32) {
-        int h = t->ipc_head;
-        strncpy(t->ipc_queue[h].sender, node->filename, 63);
-        strncpy(t->ipc_queue[h].content, msg, 191);
-        t->ipc_queue[h].type = 2; // Broadcast Type
-        t->ipc_head = (h + 1) % 32;
-        t->ipc_count++;
-      }
-    }
-    t = t->next;
+  node->registers[0] = pufu_node_broadcast(sys, node, node->input_buffer);
+  node->ip++;
+  return 1;
+}
+
+// (subscribe) "sensors": mail published to that topic arrives as
+// "sensors:message" (type 5). r0 = 0, or -1 (bad name, no memory)
+int sys_topic_subscribe(PufuNodeSystem *sys, PufuNode *node,
+                        PufuInstruction *inst) {
+  char name[256];
+  clean_string_arg(name, get_string_arg(node, inst));
+  node->registers[0] = pufu_topic_subscribe(&sys->topics, name, node->pid);
+  node->ip++;
+  return 1;
+}
+
+// (unsubscribe) "sensors". r0 = 0, or -1 if not subscribed
+int sys_topic_unsubscribe(PufuNodeSystem *sys, PufuNode *node,
+                          PufuInstruction *inst) {
+  char name[256];
+  clean_string_arg(name, get_string_arg(node, inst));
+  node->registers[0] = pufu_topic_unsubscribe(&sys->topics, name, node->pid);
+  node->ip++;
+  return 1;
+}
+
+// (publish) "sensors": the InputBuffer to the topic's subscribers only.
+// r0 = 0 (r1 = deliveries, 0 without subscribers), 1 (a subscriber mailbox
+// is full: nobody got it and the turn is given away, as
+// (ipc_send_from_buffer)) or -1 (bad name, no memory)
+int sys_topic_publish(PufuNodeSystem *sys, PufuNode *node,
+                      PufuInstruction *inst) {
+  char name[256];
+  clean_string_arg(name, get_string_arg(node, inst));
+  int delivered = 0;
+  int result = pufu_topic_valid(name)
+                   ? pufu_node_publish(sys, node, name, node->input_buffer,
+                                       &delivered)
+                   : PUFU_MAIL_NO_MEMORY;
+  node->registers[0] = -1;
+  if (result == PUFU_MAIL_OK) {
+    node->registers[0] = 0;
+    node->registers[1] = delivered;
+  } else if (result == PUFU_MAIL_FULL) {
+    node->registers[0] = 1;
+    node->yielded = PUFU_YIELD_TURN;
   }
   node->ip++;
   return 1;
 }
+
+// (ipc_capacity) "64": messages the own mailbox accepts before senders get
+// PUFU_MAIL_FULL (1..PUFU_MAILBOX_MAX_CAPACITY). r0 = the capacity set
+int sys_ipc_capacity(PufuNode *node, PufuInstruction *inst) {
+  int capacity = atoi(get_string_arg(node, inst));
+  if (capacity < 1)
+    capacity = 1;
+  if (capacity > PUFU_MAILBOX_MAX_CAPACITY)
+    capacity = PUFU_MAILBOX_MAX_CAPACITY;
+  node->mailbox_capacity = capacity;
+  if (node->mailbox)
+    pufu_mailbox_set_capacity(node->mailbox, capacity);
+  node->registers[0] = capacity;
+  node->ip++;
+  return 1;
+}
+
+// (bus_subscribe) "0x1100": signals with that id arrive as mail ("0xID
+// nibbles", read with (ipc_read))
+int sys_bus_subscribe(PufuNodeSystem *sys, PufuNode *node,
+                      PufuInstruction *inst) {
+  char arg[256];
+  clean_string_arg(arg, get_string_arg(node, inst));
+  char *end;
+  long id = strtol(arg, &end, 0);
+  node->registers[0] = -1;
+  if (end != arg && id >= 0 && id <= 0xffff)
+    node->registers[0] = pufu_node_subscribe(sys, node, (uint16_t)id);
+  node->ip++;
+  return 1;
+}
+
+// (bus_send) "0x1100 a1b2" (or the InputBuffer without an argument).
+// r0 = 0, or -1 if the bus dropped it (full, bad format)
+int sys_bus_send(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst) {
+  char arg[256];
+  clean_string_arg(arg, get_string_arg(node, inst));
+  const char *text = arg[0] ? arg : node->input_buffer;
+  uint16_t id, size;
+  uint8_t data[PUFU_SIGNAL_MAX_BYTES];
+  node->registers[0] = -1;
+  if (pufu_signal_parse(text, &id, data, &size) == 0)
+    node->registers[0] = pufu_virtual_bus_send(sys->bus, id, data, size);
+  node->ip++;
+  return 1;
+}
@@ -8,5 +8,15 @@
 int sys_ipc_send(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst);
 int sys_ipc_read(PufuNode *node, PufuInstruction *inst);
 int sys_ipc_broadcast(PufuNodeSystem *sys, PufuNode *node);
+int sys_ipc_capacity(PufuNode *node, PufuInstruction *inst);
+int sys_topic_subscribe(PufuNodeSystem *sys, PufuNode *node,
+                        PufuInstruction *inst);
+int sys_topic_unsubscribe(PufuNodeSystem *sys, PufuNode *node,
+                          PufuInstruction *inst);
+int sys_topic_publish(PufuNodeSystem *sys, PufuNode *node,
+                      PufuInstruction *inst);
+int sys_bus_subscribe(PufuNodeSystem *sys, PufuNode *node,
+                      PufuInstruction *inst);
+int sys_bus_send(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst);
 
 #endif // SYS_IPC_H
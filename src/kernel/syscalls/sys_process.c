@@ -1,31 +1,67 @@
 #include "sys_process.h"
 #include "pufu/terminal.h"
 #include "pufu/trinity.h" // For logs?
-#include "sys_core.h"     // For clean_string_arg
+#include "sys_core.h"     // For clean_string_arg, int_arg
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
 // Helper functions provided by node.h/node_exec.c or terminal.h
 
-int sys_spawn(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst) {
+// Stop a PID, or every instance of a filename
+static void kill_target(PufuNodeSystem *sys, const char *target) {
+  int pid = pufu_node_parse_pid(target);
+  if (pid > 0) {
+    PufuNode *victim = pufu_proc_find(&sys->procs, pid);
+    if (victim)
+      pufu_node_stop(sys, victim);
+    return;
+  }
+  for (PufuNode *victim = pufu_proc_find_named(&sys->procs, target); victim;
+       victim = pufu_proc_next_named(victim))
+    pufu_node_stop(sys, victim);
+}
+
+// Spawn "file [class]": the child runs in the named scheduling class, or
+// in its parent's. Returns the child (NULL if it did not load).
+static PufuNode *spawn_child(PufuNodeSystem *sys, PufuNode *parent,
+                             const char *spec) {
   char filename[256];
-  clean_string_arg(filename, inst->reg1);
-  pufu_tws_log(node->tws_id, "Syscall (spawn): Starting %s...", filename);
+  snprintf(filename, sizeof(filename), "%s", spec);
+  int sched_class = parent->sched_class;
+  char *space = strrchr(filename, ' ');
+  if (space && pufu_node_parse_class(space + 1) >= 0) {
+    sched_class = pufu_node_parse_class(space + 1);
+    *space = '\0';
+  }
+  pufu_tws_log(parent->tws_id, "Syscall (spawn): Starting %s...", filename);
   PufuNode *child = pufu_node_load(sys, filename);
-  if (child)
-    child->tws_id = node->tws_id;
+  if (child) {
+    child->tws_id = parent->tws_id;
+    pufu_node_set_class(sys, child, sched_class);
+  }
+  return child;
+}
+
+int sys_spawn(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst) {
+  char spec[256];
+  clean_string_arg(spec, get_string_arg(node, inst));
+  PufuNode *child = spawn_child(sys, node, spec);
+  node->registers[0] = child ? child->pid : -1; // Child PID in r0
   node->ip++;
   return 1;
 }
 
 int sys_exec(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst) {
   char filename[256];
-  clean_string_arg(filename, inst->reg1);
+  clean_string_arg(filename, get_string_arg(node, inst));
   pufu_tws_log(node->tws_id, "Syscall (exec): Chain loading %s...", filename);
   PufuNode *child = pufu_node_load(sys, filename);
-  if (child)
+  if (child) {
     child->tws_id = node->tws_id;
+    pufu_node_set_class(sys, child, node->sched_class);
+  }
 
   // Reset Prompt/Buffer if switching apps
   // Assuming pufu_terminal_set_prompt exists globally or included
@@ -37,23 +73,25 @@ int sys_exec(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst) {
   return 1;
 }
 
+// (kill) "name" | "pid" | rN (PID in a register)
 int sys_kill(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst) {
-  char filename[256];
-  clean_string_arg(filename, inst->reg1);
-  pufu_tws_log(node->tws_id, "Syscall (kill): Stopping %s...", filename);
-  PufuNode *target = sys->nodes;
-  while (target) {
-    if (strcmp(target->filename, filename) == 0) {
-      target->active = 0;
-    }
-    target = target->next;
-  }
+  char target[256];
+  int reg = get_operand_reg(inst->a_kind, inst->a);
+  if (reg >= 0)
+    snprintf(target, sizeof(target), "%d", node->registers[reg]);
+  else
+    clean_string_arg(target, get_string_arg(node, inst));
+  pufu_tws_log(node->tws_id, "Syscall (kill): Stopping %s...", target);
+  kill_target(sys, target);
   node->ip++;
   return 1;
 }
 
-int sys_exit(PufuNode *node) {
+// (exit) [code | "code" | rN]: the arbiter's code is pufu_os --batch's exit
+// status
+int sys_exit(PufuNode *node, PufuInstruction *inst) {
   pufu_tws_log(node->tws_id, "Syscall (exit): Terminating.");
+  node->exit_code = int_arg(node, inst);
   node->active = 0;
   node->ip++;
   return 1;
@@ -66,46 +104,79 @@ int sys_shutdown(PufuNode *node) {
 }
 
 int sys_sleep(PufuNode *node, PufuInstruction *inst) {
-  int ms = atoi(inst->reg1);
+  int ms = atoi(get_string_arg(node, inst));
   node->wake_time = get_time_ms() + ms;
   node->ip++;
   return 1;
 }
 
+// Sources of a (wait) that are ready now, in PUFU_WAIT_* order
+static int ready_source(PufuNode *node) {
+  if ((node->wait_sources & PUFU_WAIT_IPC) && pufu_mailbox_count(node->mailbox) > 0)
+    return PUFU_WAIT_IPC;
+  if ((node->wait_sources & PUFU_WAIT_INPUT) && pufu_terminal_key_ready())
+    return PUFU_WAIT_INPUT;
+  if ((node->wait_sources & PUFU_WAIT_EVENT) && trinity_pending_events())
+    return PUFU_WAIT_EVENT;
+  return PUFU_WAIT_TIMEOUT;
+}
+
+// (wait) "ipc input event [timeout_ms]": park until one of the sources is
+// ready (all three if neither a source nor a timeout is named) or the
+// timeout expires. r0 = the PUFU_WAIT_* source that fired, or 0 on
+// timeout. Nothing is consumed: the node reads it with ipc_read /
+// read_char / poll_event. A parked node executes (wait) again when it
+// wakes.
+int sys_wait(PufuNode *node, PufuInstruction *inst) {
+  if (!node->wait_sources) {
+    char spec[256];
+    clean_string_arg(spec, get_string_arg(node, inst));
+    int sources = 0, timeout = -1;
+    for (char *word = strtok(spec, " "); word; word = strtok(NULL, " ")) {
+      if (strcmp(word, "ipc") == 0)
+        sources |= PUFU_WAIT_IPC;
+      else if (strcmp(word, "input") == 0)
+        sources |= PUFU_WAIT_INPUT;
+      else if (strcmp(word, "event") == 0)
+        sources |= PUFU_WAIT_EVENT;
+      else if (*word >= '0' && *word <= '9')
+        timeout = atoi(word);
+    }
+    if (!sources && timeout < 0)
+      sources = PUFU_WAIT_IPC | PUFU_WAIT_INPUT | PUFU_WAIT_EVENT;
+    node->wait_sources = sources | PUFU_WAIT_PENDING;
+    node->wait_deadline = (timeout >= 0) ? get_time_ms() + timeout : 0;
+  }
+
+  int fired = ready_source(node);
+  if (fired == PUFU_WAIT_TIMEOUT &&
+      (node->wait_deadline == 0 || get_time_ms() < node->wait_deadline)) {
+    node->yielded = PUFU_YIELD_WAIT; // Parked; the scheduler arms the timer
+    return 1;
+  }
+  node->registers[0] = fired;
+  node->wait_sources = 0;
+  node->wait_deadline = 0;
+  node->ip++;
+  return 1;
+}
+
 int sys_spawn_from_buffer(PufuNodeSystem *sys, PufuNode *node) {
-  pufu_tws_log(node->tws_id, "Syscall (spawn): Starting %s...",
-               node->input_buffer);
-  PufuNode *child = pufu_node_load(sys, node->input_buffer);
-  if (child)
-    child->tws_id = node->tws_id;
+  PufuNode *child = spawn_child(sys, node, node->input_buffer);
+  node->registers[0] = child ? child->pid : -1; // Child PID in r0
   node->ip++;
   return 1;
 }
 
 int sys_kill_from_buffer(PufuNodeSystem *sys, PufuNode *node) {
   pufu_log("Syscall (kill): Stopping %s...", node->input_buffer);
-  PufuNode *target = sys->nodes;
-  while (target) {
-    if (strcmp(target->filename, node->input_buffer) == 0) {
-      target->active = 0;
-    }
-    target = target->next;
-  }
+  kill_target(sys, node->input_buffer);
   node->ip++;
   return 1;
 }
 
-// Helper needed? get_reg_index should be available.
-// I'll inline a static one here or move to common utils later.
-static int get_reg_index_local(const char *r) {
-  if (r[0] == 'r' && r[1] >= '0' && r[1] <= '7') {
-    return r[1] - '0';
-  }
-  return -1;
-}
-
 int sys_parse_command(PufuNode *node, PufuInstruction *inst) {
-  int reg = get_reg_index_local(inst->reg1);
+  int reg = get_operand_reg(inst->a_kind, inst->a);
   if (reg >= 0) {
     if (strncmp(node->input_buffer, "init ", 5) == 0) {
       memmove(node->input_buffer, node->input_buffer + 5, 256 - 5);
@@ -130,3 +201,52 @@ int sys_parse_command(PufuNode *node, PufuInstruction *inst) {
   node->ip++;
   return 1;
 }
+
+// (set_quantum) "insns [us]": time slice for this node
+int sys_set_quantum(PufuNode *node, PufuInstruction *inst) {
+  int insns = 0, us = node->quantum_us;
+  if (sscanf(get_string_arg(node, inst), "%d %d", &insns, &us) >= 1 &&
+      insns > 0) {
+    node->quantum = insns;
+    node->quantum_us = (us >= 0) ? us : 0;
+  }
+  node->ip++;
+  return 1;
+}
+
+// (set_class) "interactive [deadline_us]" | "normal" | "batch"
+int sys_set_class(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst) {
+  char name[32];
+  int budget = 0;
+  int fields = sscanf(get_string_arg(node, inst), "%31s %d", name, &budget);
+  int sched_class = (fields >= 1) ? pufu_node_parse_class(name) : -1;
+  if (sched_class < 0) {
+    pufu_tws_log(node->tws_id, "Syscall (set_class): unknown class");
+  } else {
+    if (fields == 2 && budget > 0)
+      node->deadline_budget_us = budget;
+    pufu_node_set_class(sys, node, sched_class);
+  }
+  node->ip++;
+  return 1;
+}
+
+int sys_sched_stats(PufuNodeSystem *sys, PufuNode *node) {
+  pufu_node_system_format_class_stats(sys, node->input_buffer,
+                                      sizeof(node->input_buffer));
+  node->ip++;
+  return 1;
+}
+
+int sys_node_stats(PufuNode *node) {
+  pufu_node_format_stats(node, node->input_buffer, sizeof(node->input_buffer));
+  node->ip++;
+  return 1;
+}
+
+int sys_system_stats(PufuNodeSystem *sys, PufuNode *node) {
+  pufu_node_system_format_stats(sys, node->input_buffer,
+                                sizeof(node->input_buffer));
+  node->ip++;
+  return 1;
+}
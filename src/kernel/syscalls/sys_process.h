@@ -8,11 +8,17 @@
 int sys_spawn(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst);
 int sys_exec(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst);
 int sys_kill(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst);
-int sys_exit(PufuNode *node);
+int sys_exit(PufuNode *node, PufuInstruction *inst);
 int sys_shutdown(PufuNode *node);
 int sys_sleep(PufuNode *node, PufuInstruction *inst);
+int sys_wait(PufuNode *node, PufuInstruction *inst);
 int sys_spawn_from_buffer(PufuNodeSystem *sys, PufuNode *node);
 int sys_kill_from_buffer(PufuNodeSystem *sys, PufuNode *node);
 int sys_parse_command(PufuNode *node, PufuInstruction *inst);
+int sys_set_quantum(PufuNode *node, PufuInstruction *inst);
+int sys_node_stats(PufuNode *node);
+int sys_system_stats(PufuNodeSystem *sys, PufuNode *node);
+int sys_set_class(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst);
+int sys_sched_stats(PufuNodeSystem *sys, PufuNode *node);
 
 #endif // SYS_PROCESS_H
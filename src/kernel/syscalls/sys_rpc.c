@@ -0,0 +1,135 @@
+#include "sys_rpc.h"
+#include "sys_core.h" // clean_string_arg
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Request/response calls (pufu/rpc.h). The caller stays on its (call)
+// instruction while parked, as (wait) does: every wakeup runs it again and
+// it only moves on once the call is over.
+
+// Server named by the operand: "target [timeout_ms]" (PID or filename), or
+// a register holding the PID (default timeout)
+static PufuNode *call_target(PufuNodeSystem *sys, PufuNode *node,
+                             PufuInstruction *inst, int *timeout) {
+  *timeout = PUFU_RPC_DEFAULT_TIMEOUT_MS;
+  if (inst->a_kind == PUFU_OPERAND_REG)
+    return pufu_proc_find(&sys->procs,
+                          get_operand_value(node, inst->a_kind, inst->a));
+  char arg[256], target[256];
+  clean_string_arg(arg, get_string_arg(node, inst));
+  if (sscanf(arg, "%255s %d", target, timeout) < 1)
+    return NULL;
+  return pufu_node_find(sys, target);
+}
+
+// (call) "server [timeout_ms]": send the InputBuffer as a request and park
+// until the reply is in the InputBuffer. r0 = 0 (replied), 1 (server
+// mailbox full: nothing sent, turn given away as (ipc_send_from_buffer)),
+// -1 (no such server, or it exited with the request) or -2 (timed out)
+int sys_call(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst) {
+  if (!node->call_id) {
+    int timeout;
+    PufuNode *server = call_target(sys, node, inst, &timeout);
+    int id = pufu_rpc_next_id();
+    char request[PUFU_MAIL_CONTENT_MAX + 1];
+    int room = PUFU_MAIL_CONTENT_MAX - 26; // Longest "rpc <id> <pid> "
+    snprintf(request, sizeof(request), "rpc %d %d %.*s", id, node->pid, room,
+             node->input_buffer);
+    int result = (server && server != node && pufu_node_live(server))
+                     ? pufu_node_post(server, node->filename, request, 6)
+                     : PUFU_MAIL_NO_MEMORY;
+    if (result != PUFU_MAIL_OK) {
+      node->registers[0] = -1;
+      if (result == PUFU_MAIL_FULL) {
+        node->registers[0] = 1;
+        node->yielded = PUFU_YIELD_TURN;
+      }
+      node->ip++;
+      return 1;
+    }
+    pufu_node_wake(sys, server);
+    sys->rpc.calls++;
+    node->call_id = id;
+    node->call_state = PUFU_CALL_PENDING;
+    // A (wait) on nothing but the deadline: the scheduler arms the timer
+    // and cancels it when the reply wakes the node first
+    node->wait_sources = PUFU_WAIT_PENDING;
+    node->wait_deadline = get_time_ms() + (timeout > 0 ? timeout : 0);
+  }
+
+  if (node->call_state == PUFU_CALL_PENDING &&
+      get_time_ms() < node->wait_deadline) {
+    node->yielded = PUFU_YIELD_WAIT;
+    return 1;
+  }
+  if (node->call_state == PUFU_CALL_REPLIED) {
+    node->registers[0] = 0;
+  } else if (node->call_state == PUFU_CALL_FAILED) {
+    node->registers[0] = -1;
+  } else {
+    node->registers[0] = -2;
+    sys->rpc.timeouts++;
+  }
+  node->call_id = 0;
+  node->call_state = 0;
+  node->wait_sources = 0;
+  node->wait_deadline = 0;
+  node->ip++;
+  return 1;
+}
+
+// (rpc_accept) rN: next mail off the own mailbox. A request: rN = its
+// correlation id, r0 = the caller's PID and the InputBuffer = the request
+// body. Other mail: rN = -1, InputBuffer = its content (as (ipc_read)).
+// Empty: rN = 0 and the turn ends. A server drains every queued request
+// in one turn by looping until rN is 0.
+int sys_rpc_accept(PufuNode *node, PufuInstruction *inst) {
+  int reg = get_operand_reg(inst->a_kind, inst->a);
+  int id = 0;
+  PufuMessage msg;
+  if (pufu_mailbox_take(node->mailbox, &msg)) {
+    int caller, body = 0;
+    id = -1;
+    if (msg.type == 6 &&
+        sscanf(msg.content, "rpc %d %d %n", &id, &caller, &body) == 2 &&
+        pufu_rpc_accept(&node->accepted, id, caller) == 0) {
+      node->registers[0] = caller;
+    } else {
+      id = -1;
+      body = 0;
+    }
+    snprintf(node->input_buffer, sizeof(node->input_buffer), "%s",
+             msg.content + body);
+  } else {
+    node->yielded = PUFU_YIELD_IPC; // Empty mailbox: give the turn away
+  }
+  if (reg >= 0)
+    node->registers[reg] = id;
+  node->ip++;
+  return 1;
+}
+
+// (reply) rN: the InputBuffer answers accepted request rN and wakes its
+// caller. r0 = 0, -1 (not an accepted request, or already answered) or -2
+// (the call is over: timed out, or the caller exited)
+int sys_reply(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst) {
+  int id = get_operand_value(node, inst->a_kind, inst->a);
+  int pid = pufu_rpc_take(&node->accepted, id);
+  PufuNode *caller = pid > 0 ? pufu_proc_find(&sys->procs, pid) : NULL;
+  node->registers[0] = -1;
+  if (caller && caller->call_id == id &&
+      caller->call_state == PUFU_CALL_PENDING) {
+    memcpy(caller->input_buffer, node->input_buffer,
+           sizeof(caller->input_buffer));
+    caller->call_state = PUFU_CALL_REPLIED;
+    pufu_node_wake(sys, caller);
+    sys->rpc.replies++;
+    node->registers[0] = 0;
+  } else if (pid > 0) {
+    sys->rpc.late++;
+    node->registers[0] = -2;
+  }
+  node->ip++;
+  return 1;
+}
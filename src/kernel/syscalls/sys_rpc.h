@@ -0,0 +1,12 @@
+#ifndef SYS_RPC_H
+#define SYS_RPC_H
+
+#include "pufu/engine.h"
+#include "pufu/node.h"
+#include "pufu/syscall_ids.h"
+
+int sys_call(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst);
+int sys_rpc_accept(PufuNode *node, PufuInstruction *inst);
+int sys_reply(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst);
+
+#endif // SYS_RPC_H
@@ -0,0 +1,162 @@
+#include "sys_shm.h"
+#include "sys_core.h" // int_arg
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Shared buffers (pufu/shm.h). The handle goes in the syscall's register
+// operand; offsets and lengths come from r1/r2 (as (trinity_update_rect)
+// takes its rect), so keep the handle in another register.
+
+// Handle in the operand register, held by this node; NULL otherwise
+static char *held_data(PufuNode *node, PufuInstruction *inst, int *handle,
+                       int *size) {
+  *handle = get_operand_value(node, inst->a_kind, inst->a);
+  if (!pufu_shm_refs_has(&node->shm, *handle))
+    return NULL;
+  return pufu_shm_data(*handle, size);
+}
+
+// A new buffer held by `node`: the creation reference becomes the node's
+static int adopt(PufuNode *node, int handle) {
+  if (handle < 0)
+    return -1;
+  int held = pufu_shm_refs_add(&node->shm, handle);
+  pufu_shm_release(handle);
+  return held == 0 ? handle : -1;
+}
+
+// (shm_create) 65536: zeroed buffer. r0 = handle, or -1
+int sys_shm_create(PufuNode *node, PufuInstruction *inst) {
+  node->registers[0] = adopt(node, pufu_shm_create(int_arg(node, inst)));
+  node->ip++;
+  return 1;
+}
+
+// (shm_load) "path": buffer with the file's contents. r0 = handle (or -1),
+// r1 = size
+int sys_shm_load(PufuNode *node, PufuInstruction *inst) {
+  char path[256];
+  clean_string_arg(path, get_string_arg(node, inst));
+  node->registers[0] = -1;
+  FILE *f = fopen(path, "rb");
+  if (f) {
+    long size = (fseek(f, 0, SEEK_END) == 0) ? ftell(f) : -1;
+    rewind(f);
+    int handle = (size > 0 && size <= PUFU_SHM_MAX_SIZE)
+                     ? pufu_shm_create((int)size)
+                     : -1;
+    char *data = pufu_shm_data(handle, NULL);
+    if (data && fread(data, 1, size, f) == (size_t)size) {
+      node->registers[0] = adopt(node, handle);
+      node->registers[1] = (int)size;
+    } else if (handle >= 0) {
+      pufu_shm_release(handle);
+    }
+    fclose(f);
+  }
+  node->ip++;
+  return 1;
+}
+
+// (shm_write) rH: the InputBuffer at offset r1 (clipped to the buffer).
+// r0 = bytes written, or -1
+int sys_shm_write(PufuNode *node, PufuInstruction *inst) {
+  int handle, size;
+  char *data = held_data(node, inst, &handle, &size);
+  int offset = node->registers[1];
+  node->registers[0] = -1;
+  if (data && offset >= 0 && offset <= size) {
+    int len = strlen(node->input_buffer);
+    if (len > size - offset)
+      len = size - offset;
+    memcpy(data + offset, node->input_buffer, len);
+    node->registers[0] = len;
+  }
+  node->ip++;
+  return 1;
+}
+
+// (shm_read) rH: r2 bytes from offset r1 into the InputBuffer (at most
+// 255). r0 = bytes read, or -1
+int sys_shm_read(PufuNode *node, PufuInstruction *inst) {
+  int handle, size;
+  char *data = held_data(node, inst, &handle, &size);
+  int offset = node->registers[1];
+  int len = node->registers[2];
+  node->registers[0] = -1;
+  if (data && offset >= 0 && offset <= size && len >= 0) {
+    if (len > size - offset)
+      len = size - offset;
+    if (len > (int)sizeof(node->input_buffer) - 1)
+      len = sizeof(node->input_buffer) - 1;
+    memcpy(node->input_buffer, data + offset, len);
+    node->input_buffer[len] = '\0';
+    node->registers[0] = len;
+  }
+  node->ip++;
+  return 1;
+}
+
+// (shm_send) rH / (shm_give) rH: hand the buffer to the node named in the
+// InputBuffer (PID or filename). It gets a reference and the mail
+// "shm <handle> <size>" (type 4); give also drops ours, share keeps it.
+// r0 = 0, 1 (target mailbox or handle table full: backpressure, as
+// (ipc_send_from_buffer)) or -1
+int sys_shm_send(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst,
+                 int give) {
+  int handle, size;
+  char *data = held_data(node, inst, &handle, &size);
+  PufuNode *target = data ? pufu_node_find(sys, node->input_buffer) : NULL;
+  node->registers[0] = -1;
+  if (target && target != node && pufu_node_live(target)) {
+    int had = pufu_shm_refs_has(&target->shm, handle);
+    int result = pufu_shm_refs_add(&target->shm, handle) == 0
+                     ? PUFU_MAIL_OK
+                     : PUFU_MAIL_FULL;
+    if (result == PUFU_MAIL_OK) {
+      char mail[64];
+      snprintf(mail, sizeof(mail), "shm %d %d", handle, size);
+      result = pufu_node_post(target, node->filename, mail, 4);
+      if (result != PUFU_MAIL_OK && !had)
+        pufu_shm_refs_drop(&target->shm, handle);
+    }
+    if (result == PUFU_MAIL_OK) {
+      pufu_node_wake(sys, target);
+      if (give)
+        pufu_shm_refs_drop(&node->shm, handle);
+      node->registers[0] = 0;
+    } else if (result == PUFU_MAIL_FULL) {
+      node->registers[0] = 1;
+      node->yielded = PUFU_YIELD_TURN;
+    }
+  }
+  node->ip++;
+  return 1;
+}
+
+// (shm_accept) rN: after (ipc_read) took a "shm <handle> <size>" mail,
+// rN = the handle (-1 if this node does not hold it) and r0 = the size
+int sys_shm_accept(PufuNode *node, PufuInstruction *inst) {
+  int reg = get_operand_reg(inst->a_kind, inst->a);
+  int handle = -1, size = -1;
+  if (sscanf(node->input_buffer, "shm %d %d", &handle, &size) != 2 ||
+      !pufu_shm_refs_has(&node->shm, handle) ||
+      !pufu_shm_data(handle, &size)) {
+    handle = -1;
+    size = -1;
+  }
+  node->registers[0] = size;
+  if (reg >= 0)
+    node->registers[reg] = handle;
+  node->ip++;
+  return 1;
+}
+
+// (shm_release) rH: drop this node's reference. r0 = 0, or -1 if not held
+int sys_shm_release(PufuNode *node, PufuInstruction *inst) {
+  int handle = get_operand_value(node, inst->a_kind, inst->a);
+  node->registers[0] = pufu_shm_refs_drop(&node->shm, handle);
+  node->ip++;
+  return 1;
+}
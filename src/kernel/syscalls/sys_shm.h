@@ -0,0 +1,17 @@
+#ifndef SYS_SHM_H
+#define SYS_SHM_H
+
+#include "pufu/engine.h"
+#include "pufu/node.h"
+#include "pufu/syscall_ids.h"
+
+int sys_shm_create(PufuNode *node, PufuInstruction *inst);
+int sys_shm_load(PufuNode *node, PufuInstruction *inst);
+int sys_shm_write(PufuNode *node, PufuInstruction *inst);
+int sys_shm_read(PufuNode *node, PufuInstruction *inst);
+int sys_shm_send(PufuNodeSystem *sys, PufuNode *node, PufuInstruction *inst,
+                 int give);
+int sys_shm_accept(PufuNode *node, PufuInstruction *inst);
+int sys_shm_release(PufuNode *node, PufuInstruction *inst);
+
+#endif // SYS_SHM_H
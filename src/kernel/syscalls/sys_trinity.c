@@ -15,13 +15,14 @@ int sys_trinity_init(PufuNode *node) {
 int sys_trinity_step(PufuNode *node) {
   int status = trinity_step();
   node->registers[0] = status;
+  node->yielded = PUFU_YIELD_TURN; // One frame per turn
   node->ip++;
   return 1;
 }
 
 int sys_window_init(PufuNode *node, PufuInstruction *inst) {
   char title[256];
-  clean_string_arg(title, inst->reg1);
+  clean_string_arg(title, get_string_arg(node, inst));
   trinity_create_node(title, NODE_WINDOW);
   trinity_prepare();
   node->registers[0] = 1;
@@ -31,7 +32,7 @@ int sys_window_init(PufuNode *node, PufuInstruction *inst) {
 
 int sys_create_ui_button(PufuNode *node, PufuInstruction *inst) {
   char name[256];
-  clean_string_arg(name, inst->reg1);
+  clean_string_arg(name, get_string_arg(node, inst));
   float x, y, w, h;
   if (sscanf(node->input_buffer, "%f %f %f %f", &x, &y, &w, &h) != 4) {
     x = 10;
@@ -52,7 +53,7 @@ int sys_trinity_set_vec3(PufuNode *node, PufuInstruction *inst) {
   char prop_name[64];
   char arg_str[256];
 
-  clean_string_arg(arg_str, inst->reg1);
+  clean_string_arg(arg_str, get_string_arg(node, inst));
   if (sscanf(arg_str, "%s %s", first_token, prop_name) != 2)
     return 1;
 
@@ -83,7 +84,7 @@ int sys_trinity_set_string(PufuNode *node, PufuInstruction *inst) {
   char prop_name[64];
   char arg_str[256];
 
-  clean_string_arg(arg_str, inst->reg1);
+  clean_string_arg(arg_str, get_string_arg(node, inst));
   if (sscanf(arg_str, "%s %s", first_token, prop_name) != 2)
     return 1;
 
@@ -103,7 +104,7 @@ int sys_trinity_set_string(PufuNode *node, PufuInstruction *inst) {
 
 int sys_create_ui_image(PufuNode *node, PufuInstruction *inst) {
   char name[256];
-  clean_string_arg(name, inst->reg1);
+  clean_string_arg(name, get_string_arg(node, inst));
   float x, y, w, h;
   if (sscanf(node->input_buffer, "%f %f %f %f", &x, &y, &w, &h) != 4) {
     x = 0;
@@ -120,7 +121,7 @@ int sys_create_ui_image(PufuNode *node, PufuInstruction *inst) {
 
 int sys_create_ui_window(PufuNode *node, PufuInstruction *inst) {
   char name[256];
-  clean_string_arg(name, inst->reg1);
+  clean_string_arg(name, get_string_arg(node, inst));
   float x, y, w, h;
   if (sscanf(node->input_buffer, "%f %f %f %f", &x, &y, &w, &h) != 4) {
     x = 50;
@@ -141,7 +142,7 @@ int sys_trinity_set_vec4(PufuNode *node, PufuInstruction *inst) {
   char prop_name[64];
   char arg_str[256];
 
-  clean_string_arg(arg_str, inst->reg1);
+  clean_string_arg(arg_str, get_string_arg(node, inst));
   if (sscanf(arg_str, "%s %s", first_token, prop_name) != 2)
     return 1;
 
@@ -171,7 +172,7 @@ int sys_trinity_get_vec4(PufuNode *node, PufuInstruction *inst) {
   char prop_name[64];
   char arg_str[256];
 
-  clean_string_arg(arg_str, inst->reg1);
+  clean_string_arg(arg_str, get_string_arg(node, inst));
   if (sscanf(arg_str, "%s %s", first_token, prop_name) != 2)
     return 1;
 
@@ -199,7 +200,7 @@ int sys_trinity_get_vec4(PufuNode *node, PufuInstruction *inst) {
 int sys_trinity_update_rect(PufuNode *node, PufuInstruction *inst) {
   int id = -1;
   char arg_str[256];
-  clean_string_arg(arg_str, inst->reg1);
+  clean_string_arg(arg_str, get_string_arg(node, inst));
 
   if (arg_str[0] >= '0' && arg_str[0] <= '9') {
     id = atoi(arg_str);
@@ -228,6 +229,7 @@ int sys_trinity_poll_event(PufuNode *node) {
     node->registers[4] = e.target_id;
   } else {
     node->registers[1] = 0;
+    node->yielded = PUFU_YIELD_EVENT; // No events: give the turn away
   }
   node->ip++;
   return 1;
@@ -235,7 +237,7 @@ int sys_trinity_poll_event(PufuNode *node) {
 
 int sys_bind_event(PufuNode *node, PufuInstruction *inst) {
   char name[256];
-  clean_string_arg(name, inst->reg1);
+  clean_string_arg(name, get_string_arg(node, inst));
   NodeID id = -1;
   if (name[0] >= '0' && name[0] <= '9') {
     id = (NodeID)atoi(name);
@@ -270,7 +272,7 @@ int sys_exec_binding(PufuNodeSystem *sys, PufuNode *node,
 
 int sys_trinity_load_meow(PufuNode *node, PufuInstruction *inst) {
   char filename[256];
-  clean_string_arg(filename, inst->reg1);
+  clean_string_arg(filename, get_string_arg(node, inst));
 
   // Check if filename is relative or absolute?
   // Trinity Parser reads file using standard C fopen.
@@ -0,0 +1,116 @@
+#include "pufu/boot_trace.h"
+#include "pufu/terminal.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+  char name[48];
+  int frame;         // First frame of a window (a point, not a span)
+  int count;         // Spans merged into this record
+  long long start_us; // First start
+  long long total_us; // Sum of durations
+} BootRecord;
+
+static BootRecord records[PUFU_BOOT_TRACE_MAX];
+static int record_count = 0;
+static long long origin_us = 0; // 0: not started
+static long long done_us = 0;   // 0: still booting
+
+static long long mono_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int tracing(void) { return origin_us && !done_us; }
+
+void pufu_boot_trace_start(void) {
+  record_count = 0;
+  done_us = 0;
+  origin_us = mono_us() - 1; // now() is never 0 while tracing
+}
+
+long long pufu_boot_trace_now(void) {
+  return tracing() ? mono_us() - origin_us : 0;
+}
+
+static BootRecord *record(const char *name, int frame) {
+  for (int i = 0; i < record_count; i++) {
+    if (records[i].frame == frame && strcmp(records[i].name, name) == 0)
+      return &records[i];
+  }
+  if (record_count >= PUFU_BOOT_TRACE_MAX)
+    return NULL;
+  BootRecord *r = &records[record_count++];
+  snprintf(r->name, sizeof(r->name), "%s", name);
+  r->frame = frame;
+  r->count = 0;
+  r->total_us = 0;
+  return r;
+}
+
+void pufu_boot_trace_span(const char *name, long long start_us) {
+  if (!tracing() || start_us <= 0)
+    return;
+  BootRecord *r = record(name, 0);
+  if (!r)
+    return;
+  if (r->count++ == 0)
+    r->start_us = start_us;
+  r->total_us += pufu_boot_trace_now() - start_us;
+}
+
+void pufu_boot_trace_frame(const char *window) {
+  if (!tracing())
+    return;
+  BootRecord *r = record(window, 1);
+  if (r && r->count++ == 0)
+    r->start_us = pufu_boot_trace_now();
+}
+
+int pufu_boot_trace_done(void) { return done_us != 0; }
+
+// Milliseconds with microsecond digits, in integers (bounded width)
+#define MS(us) (us) / 1000, (us) % 1000
+
+int pufu_boot_trace_report(void (*emit)(const char *line)) {
+  // In start order (a span is recorded when it ends, after nested ones)
+  BootRecord *sorted[PUFU_BOOT_TRACE_MAX];
+  for (int i = 0; i < record_count; i++) {
+    int j = i;
+    while (j > 0 && sorted[j - 1]->start_us > records[i].start_us) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = &records[i];
+  }
+
+  char line[160];
+  for (int i = 0; i < record_count; i++) {
+    BootRecord *r = sorted[i];
+    if (r->frame) {
+      snprintf(line, sizeof(line),
+               "[Boot] first_frame window=\"%.47s\" at=%lld.%03lldms",
+               r->name, MS(r->start_us));
+    } else {
+      snprintf(line, sizeof(line),
+               "[Boot] phase=%.47s at=%lld.%03lldms took=%lld.%03lldms n=%d",
+               r->name, MS(r->start_us), MS(r->total_us), r->count);
+    }
+    emit(line);
+  }
+  long long total = done_us ? done_us : pufu_boot_trace_now();
+  snprintf(line, sizeof(line), "[Boot] total=%lld.%03lldms", MS(total));
+  emit(line);
+  return record_count + 1;
+}
+
+static void log_line(const char *line) { pufu_log("%s", line); }
+
+void pufu_boot_trace_finish(void) {
+  if (!tracing())
+    return;
+  done_us = mono_us() - origin_us;
+  pufu_boot_trace_report(log_line);
+}
@@ -13,6 +13,11 @@ char active_prompt[64] = "";
 char active_input_buffer[256] = "";
 static struct termios orig_termios;
 static int terminal_configured = 0;
+static FILE *batch_out = NULL; // pufu_os --batch: program output stream
+
+void pufu_terminal_set_batch(int out_fd) {
+  batch_out = fdopen(out_fd, "w");
+}
 
 void pufu_terminal_init(void) {
   if (terminal_configured)
@@ -54,7 +59,14 @@ void pufu_terminal_restore(void) {
   terminal_configured = 0;
 }
 
+static int peeked_key = 0; // Read by pufu_terminal_key_ready, not consumed
+
 int pufu_terminal_get_key(void) {
+  if (peeked_key) {
+    int ch = peeked_key;
+    peeked_key = 0;
+    return ch;
+  }
   unsigned char ch;
   if (read(STDIN_FILENO, &ch, 1) > 0) {
     return (int)ch;
@@ -62,6 +74,14 @@ int pufu_terminal_get_key(void) {
   return 0;
 }
 
+int pufu_terminal_key_ready(void) {
+  if (!peeked_key)
+    peeked_key = pufu_terminal_get_key();
+  return peeked_key != 0;
+}
+
+int pufu_terminal_key_buffered(void) { return peeked_key != 0; }
+
 // TWS State
 static PufuTerminalSpace workspaces[MAX_TWS];
 static int active_tws_id = 0;
@@ -110,9 +130,6 @@ static int boot_log_pos = 0;
 const char *pufu_get_boot_logs(void) { return boot_log_buffer; }
 
 void pufu_log(const char *fmt, ...) {
-  // 1. Clear current line
-  printf("\r\033[K");
-
   // Format the message
   char msg[1024];
   va_list args;
@@ -123,6 +140,14 @@ void pufu_log(const char *fmt, ...) {
   // 0. Append to Ring Buffer (Crash Log)
   pufu_logger_append(msg);
 
+  if (batch_out) { // No prompt to keep: plain lines
+    printf("%s\n", msg);
+    return;
+  }
+
+  // 1. Clear current line
+  printf("\r\033[K");
+
   // 1. Buffer the message (Retroactive Log & TWS History)
   // Boot Log (Legacy)
   int len = strlen(msg);
@@ -172,13 +197,11 @@ void pufu_terminal_clear_screen(void) {
 
 int pufu_tws_get_active(void) { return active_tws_id; }
 
-void pufu_tws_log(int tws_id, const char *fmt, ...) {
-  // Format the message
-  char msg[1024];
-  va_list args;
-  va_start(args, fmt);
-  vsnprintf(msg, sizeof(msg), fmt, args);
-  va_end(args);
+static void tws_print(int tws_id, const char *msg) {
+  if (batch_out) {
+    printf("%s\n", msg);
+    return;
+  }
 
   // Buffer the message to the specific TWS History
   if (tws_id >= 0 && tws_id < MAX_TWS) {
@@ -211,3 +234,33 @@ void pufu_tws_log(int tws_id, const char *fmt, ...) {
     fflush(stdout);
   }
 }
+
+void pufu_tws_log(int tws_id, const char *fmt, ...) {
+  char msg[1024];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(msg, sizeof(msg), fmt, args);
+  va_end(args);
+  tws_print(tws_id, msg);
+}
+
+void pufu_tws_output(int tws_id, const char *fmt, ...) {
+  char msg[1024];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(msg, sizeof(msg), fmt, args);
+  va_end(args);
+  if (batch_out)
+    fprintf(batch_out, "%s\n", msg);
+  else
+    tws_print(tws_id, msg);
+}
+
+void pufu_terminal_put_char(int ch) {
+  if (batch_out) {
+    fputc(ch, batch_out);
+    return;
+  }
+  putchar(ch);
+  fflush(stdout);
+}
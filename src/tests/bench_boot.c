@@ -0,0 +1,85 @@
+// Boot Timing Benchmark
+// Boots src/userspace/boot/bootloader.pufu the way pufu_os does, headless
+// (no terminal setup, no loading animation, output discarded), until boot
+// ends: the first node waits for user input or the system stops. Prints
+// the boot trace: time per phase, programs parsed or loaded from the
+// cache, first frame of each window. Userspace sleeps count towards the
+// total, as they do on a real boot.
+
+#include "pufu/boot_trace.h"
+#include "pufu/dyn_loader.h"
+#include "pufu/scheduler.h"
+#include "pufu/trinity.h"
+#include "pufu_test.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define BOOT_FILE "src/userspace/boot/bootloader.pufu"
+#define BOOT_TIMEOUT_MS 10000
+
+static void print_line(const char *line) { printf("%s\n", line); }
+
+int main(void) {
+  // The system's own output would bury the report; no input either (a
+  // node reading an idle stdin pipe would block the boot)
+  fflush(stdout);
+  int saved = dup(STDOUT_FILENO);
+  int null_fd = open("/dev/null", O_RDWR);
+  if (saved < 0 || null_fd < 0 || dup2(null_fd, STDOUT_FILENO) < 0 ||
+      dup2(null_fd, STDIN_FILENO) < 0) {
+    perror("bench_boot: redirect");
+    return 1;
+  }
+  close(null_fd);
+
+  pufu_boot_trace_start();
+  long long t0 = pufu_boot_trace_now();
+  pufu_dyn_loader_init();
+  int status = pufu_load_socket("bin/drivers/socket_arm.so") < 0;
+  pufu_boot_trace_span("socket", t0);
+
+  t0 = pufu_boot_trace_now();
+  PufuNodeSystem *sys = pufu_node_system_init();
+  pufu_boot_trace_span("node_system", t0);
+
+  t0 = pufu_boot_trace_now();
+  PufuNode *arbiter = sys ? pufu_node_load(sys, BOOT_FILE) : NULL;
+  pufu_boot_trace_span("arbiter_load", t0);
+
+  PufuScheduler *sched = NULL;
+  if (arbiter && pufu_node_set_arbiter(sys, arbiter) == 0 &&
+      pufu_node_execute(sys, arbiter) >= 0) {
+    t0 = pufu_boot_trace_now();
+    sched = pufu_scheduler_init(sys, 0);
+    pufu_boot_trace_span("scheduler_init", t0);
+  }
+  if (!sched)
+    status = 1;
+
+  long long deadline = get_time_ms() + BOOT_TIMEOUT_MS;
+  while (sched && !pufu_boot_trace_done() && get_time_ms() < deadline) {
+    if (pufu_scheduler_run_once(sched) == 0)
+      break;
+  }
+  if (!pufu_boot_trace_done() && get_time_ms() >= deadline)
+    status = 1;
+  pufu_boot_trace_finish();
+
+  if (sched)
+    pufu_scheduler_cleanup(sched);
+  if (sys)
+    pufu_node_system_cleanup(sys);
+  trinity_shutdown();
+
+  fflush(stdout);
+  dup2(saved, STDOUT_FILENO);
+  close(saved);
+
+  printf("\n=== bench_boot: %s, headless ===\n", BOOT_FILE);
+  if (status)
+    printf("bench_boot: boot failed or timed out\n");
+  pufu_boot_trace_report(print_line);
+  return status;
+}
@@ -0,0 +1,91 @@
+// Multi-core Executor Benchmark
+// Spawns CPU-bound nodes (a counting loop that runs off its end) and runs
+// them to completion through the scheduler, first on the main thread only
+// and then with 1, 2 and one-per-CPU workers. Reports wall time, speedup
+// over the inline run and per-worker turns/steals.
+
+#include "pufu/executor.h"
+#include "pufu/scheduler.h"
+#include "pufu_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_NODES 8
+#define BENCH_ITERATIONS 4000000
+
+// Same teardown as pufu_node_system_cleanup, minus the Trinity shutdown
+static void unload_all(PufuNodeSystem *sys) {
+  PufuNode *node = sys->nodes;
+  while (node) {
+    PufuNode *next = node->next;
+    pufu_node_destroy(node);
+    node = next;
+  }
+  memset(sys, 0, sizeof(*sys));
+}
+
+// Run BENCH_NODES loops to the end; -1 unless all of them were reaped
+static double run(const char *path, int workers, char *stats, int size) {
+  PufuNodeSystem sys;
+  memset(&sys, 0, sizeof(sys));
+  for (int i = 0; i < BENCH_NODES; i++) {
+    if (!pufu_node_load(&sys, path))
+      return -1;
+  }
+
+  PufuScheduler *sched = pufu_scheduler_init(&sys, workers);
+  if (!sched)
+    return -1;
+  double t0 = now_sec();
+  while (pufu_scheduler_run_once(sched) > 0)
+    ;
+  double secs = now_sec() - t0;
+
+  stats[0] = '\0';
+  if (sched->exec)
+    pufu_executor_format_stats(sched->exec, stats, size);
+  pufu_scheduler_cleanup(sched);
+
+  if (sys.reaped != BENCH_NODES || sys.nodes)
+    secs = -1;
+  unload_all(&sys);
+  return secs;
+}
+
+int main(void) {
+  char path[PUFU_TEST_PATH_MAX];
+  if (pufu_test_load_socket("bench_exec") < 0 ||
+      pufu_test_write_program(path,
+                              "    mov r1 0\nlabel loop\n    add r1 1\n"
+                              "    cmp r1 %d\n    bne loop\n",
+                              BENCH_ITERATIONS) < 0)
+    return 1;
+
+  int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  int configs[] = {0, 1, 2, cpus};
+  int config_count = (cpus > 2) ? 4 : 3;
+  char stats[1024];
+
+  printf("\n=== bench_exec: %d CPU-bound nodes x %d iterations, %d CPUs ===\n",
+         BENCH_NODES, BENCH_ITERATIONS, cpus);
+  double inline_secs = 0;
+  int status = 0;
+  for (int i = 0; i < config_count; i++) {
+    double secs = run(path, configs[i], stats, sizeof(stats));
+    if (secs < 0) {
+      printf("bench_exec: nodes left behind with %d workers\n", configs[i]);
+      status = 1;
+      break;
+    }
+    if (configs[i] == 0)
+      inline_secs = secs;
+    printf("%d worker(s)%-12s %8.1f ms  %5.2fx\n", configs[i],
+           configs[i] ? "" : " (inline)", secs * 1e3, inline_secs / secs);
+    fputs(stats, stdout);
+  }
+  unlink(path);
+  return status;
+}
@@ -0,0 +1,193 @@
+// IPC Throughput Benchmark
+// Paw nodes exchanging mail through the scheduler: senders loop on
+// (ipc_send_from_buffer), retrying when r0 says the target mailbox is full
+// (backpressure), receivers loop on (ipc_read) and park when theirs is
+// empty. Three patterns: 1 sender -> 1 receiver, BENCH_FANOUT senders ->
+// 1 receiver and 1 sender -> BENCH_FANOUT receivers. Reports messages per
+// second end to end (VM, syscalls, mailbox, wakeups) and the refused posts.
+// A 1:1 run hands over BENCH_BULK_BYTES shared buffers ((shm_give) /
+// (shm_accept)) instead of text: the payload is never copied or touched,
+// so it is reported per handoff, not as bandwidth. The last one
+// publishes to a topic BENCH_FANOUT receivers subscribe to: one (publish)
+// per round, one shared payload for all of them. The RPC runs make each
+// message a (call) round trip: the client parks until the server's
+// (reply), and with BENCH_FANOUT clients the server drains every queued
+// request in one turn.
+
+#include "pufu/scheduler.h"
+#include "pufu_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_MESSAGES 200000 // Per pattern
+#define BENCH_FANOUT 8
+#define BENCH_CAPACITY "64"   // Receiver mailboxes ((ipc_capacity))
+#define BENCH_BULK_BYTES (1024 * 1024)
+#define BENCH_BULK_MESSAGES 100000
+
+enum { MODE_TEXT, MODE_SHM, MODE_TOPIC, MODE_RPC };
+
+// Temporary program files, removed at the end of each pattern
+static char paths[2][PUFU_TEST_PATH_MAX];
+
+// Reads `count` messages (shm: accepts and releases each buffer; rpc:
+// accepts and answers each request), then exits
+static const char *write_receiver(int count, int mode) {
+  FILE *f = pufu_test_open_program(paths[0]);
+  if (!f)
+    return NULL;
+  fprintf(f, "    syscall (ipc_capacity) \"%s\"\n", BENCH_CAPACITY);
+  if (mode == MODE_TOPIC)
+    fprintf(f, "    syscall (subscribe) \"bench\"\n");
+  fprintf(f, "    mov r5 0\n"
+             "loop:\n"
+             "    syscall (%s) r1\n"
+             "    cmp r1 0\n"
+             "    beq loop\n",
+          mode == MODE_RPC ? "rpc_accept" : "ipc_read");
+  if (mode == MODE_RPC)
+    fprintf(f, "    syscall (reply) r1\n");
+  if (mode == MODE_SHM)
+    fprintf(f, "    syscall (shm_accept) r7\n"
+               "    syscall (shm_release) r7\n");
+  fprintf(f, "    add r5 1\n"
+             "    cmp r5 %d\n"
+             "    bne loop\n"
+             "    syscall (exit)\n",
+          count);
+  fclose(f);
+  return paths[0];
+}
+
+// Sends `count` rounds of one message to each target PID (shm: a new
+// shared buffer given away; topic: one publish reaches every target;
+// rpc: a call that waits for the reply)
+static const char *write_sender(const int *targets, int n, int count,
+                                int mode) {
+  FILE *f = pufu_test_open_program(paths[1]);
+  if (!f)
+    return NULL;
+  fprintf(f, "    mov r5 0\nloop:\n");
+  if (mode == MODE_TOPIC) {
+    fprintf(f, "publish:\n"
+               "    syscall (clear_buffer)\n"
+               "    syscall (prepend_string) \"ping\"\n"
+               "    syscall (publish) \"bench\"\n"
+               "    cmp r0 1\n"
+               "    beq publish\n");
+    n = 0;
+  }
+  for (int i = 0; i < n; i++) {
+    if (mode == MODE_SHM) {
+      fprintf(f, "    syscall (shm_create) %d\n"
+                 "    mov r7 r0\n"
+                 "send%d:\n"
+                 "    syscall (clear_buffer)\n"
+                 "    syscall (prepend_string) \"%d\"\n"
+                 "    syscall (shm_give) r7\n",
+              BENCH_BULK_BYTES, i, targets[i]);
+    } else if (mode == MODE_RPC) {
+      fprintf(f, "send%d:\n"
+                 "    syscall (clear_buffer)\n"
+                 "    syscall (prepend_string) \"ping\"\n"
+                 "    syscall (call) \"%d\"\n",
+              i, targets[i]);
+    } else {
+      fprintf(f, "send%d:\n"
+                 "    syscall (clear_buffer)\n"
+                 "    syscall (prepend_string) \"%d:ping %d\"\n"
+                 "    syscall (ipc_send_from_buffer)\n",
+              i, targets[i], i);
+    }
+    fprintf(f, "    cmp r0 1\n"
+               "    beq send%d\n",
+            i);
+  }
+  fprintf(f, "    add r5 1\n"
+             "    cmp r5 %d\n"
+             "    bne loop\n"
+             "    syscall (exit)\n",
+          count);
+  fclose(f);
+  return paths[1];
+}
+
+static int pattern(PufuScheduler *sched, const char *name, int senders,
+                   int receivers, int messages, int mode) {
+  PufuNodeSystem *sys = sched->system;
+  int per_pair = messages / (senders * receivers);
+  int total = per_pair * senders * receivers;
+  int targets[BENCH_FANOUT];
+
+  const char *rx = write_receiver(per_pair * senders, mode);
+  for (int i = 0; rx && i < receivers; i++) {
+    PufuNode *node = pufu_node_load(sys, rx);
+    if (!node)
+      return -1;
+    targets[i] = node->pid;
+  }
+  const char *tx = write_sender(targets, receivers, per_pair, mode);
+  if (!rx || !tx)
+    return -1;
+
+  double t0 = now_sec();
+  for (int i = 0; i < senders; i++) {
+    if (!pufu_node_load(sys, tx))
+      return -1;
+  }
+  while (pufu_scheduler_run_once(sched) > 0)
+    ;
+  double secs = now_sec() - t0;
+  unlink(paths[0]);
+  unlink(paths[1]);
+
+  char stats[512];
+  pufu_node_system_format_stats(sys, stats, sizeof(stats));
+  printf("%-22s %6.2f M msgs/s  (%.0f ns/msg, %d messages)\n", name,
+         total / secs / 1e6, secs * 1e9 / total, total);
+  // Neither side reads or writes the buffers, so this is the cost of a
+  // handoff, not a payload bandwidth
+  if (mode == MODE_SHM)
+    printf("  %.2f us per %d KB handoff, payload untouched\n",
+           secs * 1e6 / total, BENCH_BULK_BYTES / 1024);
+  printf("  %s\n", stats);
+  return sys->nodes ? -1 : 0;
+}
+
+int main(void) {
+  if (pufu_test_load_socket("bench_ipc") < 0)
+    return 1;
+  PufuNodeSystem *sys = pufu_node_system_init();
+  PufuScheduler *sched = sys ? pufu_scheduler_init(sys, 0) : NULL;
+  if (!sched) {
+    printf("bench_ipc: setup failed\n");
+    return 1;
+  }
+
+  printf("\n=== bench_ipc: %d messages per pattern, mailbox capacity %s ===\n",
+         BENCH_MESSAGES, BENCH_CAPACITY);
+  char fan_in[32], fan_out[32];
+  snprintf(fan_in, sizeof(fan_in), "%d:1 (fan-in)", BENCH_FANOUT);
+  snprintf(fan_out, sizeof(fan_out), "1:%d (fan-out)", BENCH_FANOUT);
+  int status = 0;
+  char topic[32], rpc_in[32];
+  snprintf(topic, sizeof(topic), "1:%d (topic)", BENCH_FANOUT);
+  snprintf(rpc_in, sizeof(rpc_in), "%d:1 (rpc)", BENCH_FANOUT);
+  if (pattern(sched, "1:1", 1, 1, BENCH_MESSAGES, MODE_TEXT) < 0 ||
+      pattern(sched, fan_in, BENCH_FANOUT, 1, BENCH_MESSAGES, MODE_TEXT) < 0 ||
+      pattern(sched, fan_out, 1, BENCH_FANOUT, BENCH_MESSAGES, MODE_TEXT) <
+          0 ||
+      pattern(sched, "1:1 (1 MB shm)", 1, 1, BENCH_BULK_MESSAGES, MODE_SHM) <
+          0 ||
+      pattern(sched, topic, 1, BENCH_FANOUT, BENCH_MESSAGES, MODE_TOPIC) < 0 ||
+      pattern(sched, "1:1 (rpc)", 1, 1, BENCH_MESSAGES, MODE_RPC) < 0 ||
+      pattern(sched, rpc_in, BENCH_FANOUT, 1, BENCH_MESSAGES, MODE_RPC) < 0) {
+    printf("bench_ipc: nodes left behind\n");
+    status = 1;
+  }
+  pufu_scheduler_cleanup(sched);
+  return status;
+}
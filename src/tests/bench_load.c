@@ -0,0 +1,111 @@
+// Program Load Benchmark
+// Loads every .pufu under src/userspace through pufu_node_load, first
+// parsing from source and then from the .pufub cache (one mmap each),
+// then respawns one file repeatedly to measure shared program images.
+
+#include "pufu/node.h"
+#include "pufu/program.h"
+#include "pufu/pufub.h"
+#include "pufu_test.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ROUNDS 200
+#define MAX_FILES 256
+
+static char *files[MAX_FILES];
+static int file_count = 0;
+
+static void collect(const char *dir) {
+  DIR *d = opendir(dir);
+  if (!d)
+    return;
+  struct dirent *entry;
+  while ((entry = readdir(d)) && file_count < MAX_FILES) {
+    if (entry->d_name[0] == '.')
+      continue;
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+    const char *dot = strrchr(entry->d_name, '.');
+    if (dot && strcmp(dot, ".pufu") == 0)
+      files[file_count++] = strdup(path);
+    else if (!dot)
+      collect(path);
+  }
+  closedir(d);
+}
+
+// Same teardown as pufu_node_system_cleanup, minus the Trinity shutdown
+static void unload_all(PufuNodeSystem *sys) {
+  PufuNode *node = sys->nodes;
+  while (node) {
+    PufuNode *next = node->next;
+    pufu_node_destroy(node);
+    node = next;
+  }
+  memset(sys, 0, sizeof(*sys));
+}
+
+static double load_rounds(PufuNodeSystem *sys, int *loaded) {
+  double t0 = now_sec();
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    *loaded = 0;
+    for (int i = 0; i < file_count; i++) {
+      if (pufu_node_load(sys, files[i]))
+        (*loaded)++;
+    }
+    unload_all(sys);
+  }
+  return now_sec() - t0;
+}
+
+static void report(const char *name, int loaded, double secs) {
+  printf("%-24s %3d files  %8.3f ms/boot  %8.2f us/file\n", name, loaded,
+         secs * 1e3 / BENCH_ROUNDS, secs * 1e6 / BENCH_ROUNDS / loaded);
+}
+
+int main(void) {
+  collect("src/userspace");
+  if (file_count == 0) {
+    printf("bench_load: run from the repository root\n");
+    return 1;
+  }
+
+  PufuNodeSystem sys;
+  memset(&sys, 0, sizeof(sys));
+  int loaded = 0;
+
+  printf("\n=== bench_load: %d userspace programs x %d rounds ===\n",
+         file_count, BENCH_ROUNDS);
+
+  pufu_pufub_set_enabled(0);
+  double secs = load_rounds(&sys, &loaded);
+  report("parse from source", loaded, secs);
+
+  // Warm the cache once, then measure cached loads only
+  pufu_pufub_set_enabled(1);
+  load_rounds(&sys, &loaded);
+  secs = load_rounds(&sys, &loaded);
+  report(".pufub cache (mmap)", loaded, secs);
+
+  // Same file spawned over and over (taskbar clicks): one shared image
+  pufu_pufub_set_enabled(0);
+  double t0 = now_sec();
+  int images = 0;
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    loaded = 0;
+    for (int i = 0; i < file_count; i++) {
+      if (pufu_node_load(&sys, files[0]))
+        loaded++;
+    }
+    images = pufu_program_count();
+    unload_all(&sys);
+  }
+  report("respawn, shared image", loaded, now_sec() - t0);
+  printf("  %d nodes of %s -> %d program image(s)\n", loaded, files[0],
+         images);
+  return 0;
+}
@@ -0,0 +1,150 @@
+// Parser Throughput Benchmark
+// Parses a large synthetic .pufu corpus (every syscall name) and
+// reports lines/sec, then compares name resolution through the generated
+// perfect hash against the old strcmp chain.
+
+#include "pufu/name_hash.h"
+#include "pufu/parser.h"
+#include "pufu_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CORPUS_LINES 200000
+#define LOOKUP_ROUNDS 200000
+
+#define TABLE_LEN(t) (int)(sizeof(t) / sizeof(t[0]))
+
+// Every table entry must resolve to itself, anything else to 0
+static int check_tables(void) {
+  int errors = 0;
+  for (int i = 0; i < TABLE_LEN(pufu_syscalls_table); i++) {
+    const PufuNameEntry *e = &pufu_syscalls_table[i];
+    if (e->name && pufu_syscall_lookup(e->name, e->len) != e->id) {
+      printf("bench_parser: syscall %s does not resolve\n", e->name);
+      errors++;
+    }
+  }
+  for (int i = 0; i < TABLE_LEN(pufu_opcodes_table); i++) {
+    const PufuNameEntry *e = &pufu_opcodes_table[i];
+    if (e->name && pufu_opcode_lookup(e->name, e->len) != e->id) {
+      printf("bench_parser: opcode %s does not resolve\n", e->name);
+      errors++;
+    }
+  }
+  if (pufu_syscall_lookup("(nope)", 6) != SYS_UNKNOWN ||
+      pufu_opcode_lookup("nope", 4) != OP_NOP) {
+    printf("bench_parser: unknown names must resolve to 0\n");
+    errors++;
+  }
+  return errors;
+}
+
+static int write_corpus(const char *path) {
+  FILE *f = fopen(path, "w");
+  if (!f)
+    return -1;
+
+  const char *syscalls[TABLE_LEN(pufu_syscalls_table)];
+  int syscall_count = 0;
+  for (int i = 0; i < TABLE_LEN(pufu_syscalls_table); i++) {
+    if (pufu_syscalls_table[i].name)
+      syscalls[syscall_count++] = pufu_syscalls_table[i].name;
+  }
+
+  // One label per 32 blocks: real programs have few labels, and label
+  // lookup at link time is a linear scan
+  int lines = 0, block = 0, label = 0;
+  while (lines < CORPUS_LINES) {
+    if (block % 32 == 0) {
+      label = block / 32;
+      fprintf(f, "label l%d\n", label);
+      lines++;
+    }
+    fprintf(f, "    mov r1 %d\n", lines);
+    fprintf(f, "    add r1 r2\n");
+    fprintf(f, "    sub r3 7\n");
+    fprintf(f, "    cmp r1 100\n");
+    fprintf(f, "    # comment line\n");
+    fprintf(f, "    syscall %s \"arg %d\"\n", syscalls[block % syscall_count],
+            block);
+    fprintf(f, "    bne l%d\n", label);
+    block++;
+    lines += 7;
+  }
+  fclose(f);
+  return lines;
+}
+
+// The old get_syscall_id: one strcmp per known name until a match
+static int strcmp_chain(const char **names, int count, const char *name) {
+  for (int i = 0; i < count; i++) {
+    if (strcmp(names[i], name) == 0)
+      return i;
+  }
+  return -1;
+}
+
+int main(void) {
+  if (check_tables() > 0)
+    return 1;
+
+  char path[] = "/tmp/pufu_bench_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0)
+    return 1;
+  close(fd);
+  int lines = write_corpus(path);
+
+  printf("\n=== bench_parser: %d line synthetic corpus ===\n", lines);
+
+  double best = 1e9;
+  int count = 0;
+  for (int run = 0; run < 3; run++) {
+    PufuParser *parser = pufu_parser_init();
+    double t0 = now_sec();
+    pufu_parse_file(parser, path);
+    pufu_parser_link(parser, path);
+    double secs = now_sec() - t0;
+    if (secs < best)
+      best = secs;
+    count = parser->count;
+    pufu_parser_cleanup(parser);
+  }
+  unlink(path);
+  printf("%-28s %8d insns  %8.3f ms  %8.2f M lines/s\n", "parse + link",
+         count, best * 1e3, lines / best / 1e6);
+
+  // Name resolution alone, over every syscall name
+  const char *names[TABLE_LEN(pufu_syscalls_table)];
+  int lens[TABLE_LEN(pufu_syscalls_table)];
+  int name_count = 0;
+  for (int i = 0; i < TABLE_LEN(pufu_syscalls_table); i++) {
+    if (pufu_syscalls_table[i].name) {
+      names[name_count] = pufu_syscalls_table[i].name;
+      lens[name_count++] = pufu_syscalls_table[i].len;
+    }
+  }
+
+  volatile long long sink = 0;
+  double t0 = now_sec();
+  for (int r = 0; r < LOOKUP_ROUNDS; r++)
+    for (int i = 0; i < name_count; i++)
+      sink += strcmp_chain(names, name_count, names[i]);
+  double chain = now_sec() - t0;
+
+  t0 = now_sec();
+  for (int r = 0; r < LOOKUP_ROUNDS; r++)
+    for (int i = 0; i < name_count; i++)
+      sink += pufu_syscall_lookup(names[i], lens[i]);
+  double hash = now_sec() - t0;
+
+  long long lookups = (long long)LOOKUP_ROUNDS * name_count;
+  printf("%-28s %8.1f ns/lookup\n", "syscall name, strcmp chain",
+         chain * 1e9 / lookups);
+  printf("%-28s %8.1f ns/lookup\n", "syscall name, perfect hash",
+         hash * 1e9 / lookups);
+  return 0;
+}
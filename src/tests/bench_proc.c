@@ -0,0 +1,87 @@
+// Process Table Benchmark
+// Loads a few hundred nodes (distinct files plus repeated instances) and
+// compares target lookup the old way (strcmp walk over the node list)
+// with the PID and name indexes of the process table.
+
+#include "pufu/node.h"
+#include "pufu_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_FILES 100
+#define BENCH_INSTANCES 4 // Nodes per file
+#define BENCH_LOOKUPS 1000000
+
+static PufuNode *find_linear(PufuNodeSystem *sys, const char *name) {
+  for (PufuNode *node = sys->nodes; node; node = node->next) {
+    if (strcmp(node->filename, name) == 0)
+      return node;
+  }
+  return NULL;
+}
+
+int main(void) {
+  char dir[] = "/tmp/bench_proc_XXXXXX";
+  if (!mkdtemp(dir)) {
+    perror("bench_proc: mkdtemp");
+    return 1;
+  }
+  static char names[BENCH_FILES][64];
+  for (int i = 0; i < BENCH_FILES; i++) {
+    snprintf(names[i], sizeof(names[i]), "%s/node_%03d.pufu", dir, i);
+    FILE *f = fopen(names[i], "w");
+    if (!f)
+      return 1;
+    fprintf(f, "    mov r1 %d\n", i);
+    fclose(f);
+  }
+
+  PufuNodeSystem *sys = pufu_node_system_init();
+  if (!sys)
+    return 1;
+  for (int n = 0; n < BENCH_INSTANCES; n++) {
+    for (int i = 0; i < BENCH_FILES; i++)
+      pufu_node_load(sys, names[i]);
+  }
+  int nodes = sys->procs.count;
+
+  printf("\n=== bench_proc: %d nodes (%d files x %d), %d lookups ===\n",
+         nodes, BENCH_FILES, BENCH_INSTANCES, BENCH_LOOKUPS);
+
+  int status = 0;
+  long long hits = 0;
+  double t0 = now_sec();
+  for (int i = 0; i < BENCH_LOOKUPS; i++)
+    hits += find_linear(sys, names[(i * 7) % BENCH_FILES]) != NULL;
+  double linear = now_sec() - t0;
+
+  t0 = now_sec();
+  for (int i = 0; i < BENCH_LOOKUPS; i++)
+    hits += pufu_node_find(sys, names[(i * 7) % BENCH_FILES]) != NULL;
+  double by_name = now_sec() - t0;
+
+  t0 = now_sec();
+  for (int i = 0; i < BENCH_LOOKUPS; i++)
+    hits += pufu_proc_find(&sys->procs, 1 + (i * 7) % nodes) != NULL;
+  double by_pid = now_sec() - t0;
+
+  if (hits != 3LL * BENCH_LOOKUPS) {
+    printf("bench_proc: %lld of %d lookups missed\n",
+           3LL * BENCH_LOOKUPS - hits, 3 * BENCH_LOOKUPS);
+    status = 1;
+  }
+  printf("strcmp walk (name)     %8.1f ns/lookup\n",
+         linear * 1e9 / BENCH_LOOKUPS);
+  printf("name index             %8.1f ns/lookup\n",
+         by_name * 1e9 / BENCH_LOOKUPS);
+  printf("pid index              %8.1f ns/lookup\n",
+         by_pid * 1e9 / BENCH_LOOKUPS);
+
+  for (int i = 0; i < BENCH_FILES; i++)
+    unlink(names[i]);
+  rmdir(dir);
+  return status;
+}
@@ -0,0 +1,117 @@
+// Spawn/Exit Churn Benchmark
+// Spawns a node that runs off its end, lets the scheduler run and reap it,
+// and repeats: first one node at a time, then in bursts of BENCH_BURST
+// live nodes. The program image stays loaded (as it does while any
+// instance runs), so this measures the node's own spawn cost: control
+// block, mailbox, process table. Reports spawn latency percentiles, the
+// cost of a full spawn+exit cycle and RSS before/after.
+
+#include "pufu/program.h"
+#include "pufu/scheduler.h"
+#include "pufu_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_CYCLES 100000
+#define BENCH_BURST 1000
+#define BENCH_WARMUP 1000
+
+static long long now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static long rss_kb(void) {
+  FILE *f = fopen("/proc/self/status", "r");
+  if (!f)
+    return -1;
+  char line[128];
+  long kb = -1;
+  while (fgets(line, sizeof(line), f)) {
+    if (sscanf(line, "VmRSS: %ld", &kb) == 1)
+      break;
+  }
+  fclose(f);
+  return kb;
+}
+
+static int cmp_ll(const void *a, const void *b) {
+  long long x = *(const long long *)a, y = *(const long long *)b;
+  return (x > y) - (x < y);
+}
+
+// Spawn `burst` nodes, run until all of them are reaped; repeat until
+// `cycles` nodes went through. Spawn latencies go to `lat`.
+static int churn(PufuScheduler *sched, const char *path, int cycles,
+                 int burst, long long *lat) {
+  PufuNodeSystem *sys = sched->system;
+  for (int done = 0; done < cycles; done += burst) {
+    for (int i = 0; i < burst; i++) {
+      long long t0 = now_ns();
+      PufuNode *node = pufu_node_load(sys, path);
+      if (lat)
+        lat[done + i] = now_ns() - t0;
+      if (!node)
+        return -1;
+    }
+    while (pufu_scheduler_run_once(sched) > 0)
+      ;
+  }
+  return sys->nodes ? -1 : 0;
+}
+
+static int report(PufuScheduler *sched, const char *path, int burst,
+                  long long *lat) {
+  if (churn(sched, path, BENCH_WARMUP, burst, NULL) < 0)
+    return -1;
+  long rss_before = rss_kb();
+  long long t0 = now_ns();
+  if (churn(sched, path, BENCH_CYCLES, burst, lat) < 0)
+    return -1;
+  double cycle_ns = (double)(now_ns() - t0) / BENCH_CYCLES;
+  long rss_after = rss_kb();
+
+  qsort(lat, BENCH_CYCLES, sizeof(lat[0]), cmp_ll);
+  char stats[256];
+  pufu_node_system_format_stats(sched->system, stats, sizeof(stats));
+  printf("burst %-5d spawn p50 %5lld ns  p99 %6lld ns  spawn+exit %7.0f ns"
+         "  RSS %ld -> %ld KB\n",
+         burst, lat[BENCH_CYCLES / 2], lat[BENCH_CYCLES * 99 / 100],
+         cycle_ns, rss_before, rss_after);
+  printf("  %s\n", stats);
+  return 0;
+}
+
+int main(void) {
+  char path[PUFU_TEST_PATH_MAX];
+  if (pufu_test_write_program(path, "    mov r1 1\n") < 0)
+    return 1;
+
+  PufuProgram *image = pufu_program_acquire(path, -1);
+  PufuNodeSystem *sys = pufu_node_system_init();
+  PufuScheduler *sched = sys ? pufu_scheduler_init(sys, 0) : NULL;
+  long long *lat = malloc(BENCH_CYCLES * sizeof(long long));
+  if (!image || !sched || !lat) {
+    printf("bench_spawn: setup failed\n");
+    return 1;
+  }
+  memset(lat, 0xff, BENCH_CYCLES * sizeof(long long)); // Out of the RSS delta
+
+  printf("\n=== bench_spawn: %d spawn+exit cycles ===\n", BENCH_CYCLES);
+  int status = 0;
+  if (report(sched, path, 1, lat) < 0 ||
+      report(sched, path, BENCH_BURST, lat) < 0) {
+    printf("bench_spawn: nodes left behind\n");
+    status = 1;
+  }
+
+  free(lat);
+  pufu_scheduler_cleanup(sched);
+  pufu_program_release(image);
+  unlink(path);
+  return status;
+}
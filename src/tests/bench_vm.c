@@ -0,0 +1,189 @@
+// VM Dispatch Micro-Benchmark
+// Runs a tight mov/add/cmp/bne loop and reports instructions/sec and
+// dispatch cost for the legacy string-operand path (atoi per step) and the
+// packed, decoded VM with and without superinstructions. Built once per
+// dispatch engine (bench_vm_switch, bench_vm_threaded, bench_vm_jit).
+
+#include "pufu/jit.h"
+#include "pufu/node.h"
+#include "pufu/socket.h"
+#include "pufu_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS 2000000
+
+static const char *loop_program[] = {
+    "    mov r1 0\n",    "label loop\n",  "    mov r2 3\n",
+    "    add r2 r1\n",   "    add r1 1\n", "    cmp r1 %d\n",
+    "    bne loop\n",
+};
+#define LOOP_LINES (int)(sizeof(loop_program) / sizeof(loop_program[0]))
+
+// --- Baseline: the pre-decoding step (string operands, atoi per step) ---
+
+// Same footprint as the old text-based PufuInstruction (~450 bytes)
+typedef struct {
+  PufuOpcode opcode;
+  char op[32];
+  char reg1[128];
+  char reg2[128];
+  char value[128];
+  int target;
+} LegacyInstruction;
+
+// Tokenize the loop the way the old parser did (labels resolved up front)
+static int legacy_load(char lines[][64], LegacyInstruction *code) {
+  char labels[LOOP_LINES][64];
+  int label_index[LOOP_LINES];
+  int count = 0, label_count = 0;
+
+  for (int i = 0; i < LOOP_LINES; i++) {
+    char op[32] = "", reg1[128] = "", reg2[128] = "";
+    sscanf(lines[i], "%31s %127s %127s", op, reg1, reg2);
+    if (strcmp(op, "label") == 0) {
+      strcpy(labels[label_count], reg1);
+      label_index[label_count++] = count;
+      continue;
+    }
+    LegacyInstruction *inst = &code[count++];
+    inst->opcode = strcmp(op, "mov") == 0   ? OP_MOV
+                   : strcmp(op, "add") == 0 ? OP_ADD
+                   : strcmp(op, "cmp") == 0 ? OP_CMP
+                   : strcmp(op, "bne") == 0 ? OP_BNE
+                                            : OP_NOP;
+    strcpy(inst->reg1, reg1);
+    strcpy(inst->reg2, reg2);
+  }
+  for (int i = 0; i < count; i++) {
+    for (int l = 0; l < label_count; l++) {
+      if (strcmp(code[i].reg1, labels[l]) == 0)
+        code[i].target = label_index[l];
+    }
+  }
+  return count;
+}
+
+static long long run_legacy(char lines[][64]) {
+  LegacyInstruction code[LOOP_LINES];
+  memset(code, 0, sizeof(code));
+  int count = legacy_load(lines, code);
+
+  PufuNode node;
+  memset(&node, 0, sizeof(node));
+  PufuSocket *socket = pufu_get_current_socket();
+  long long executed = 0;
+
+  while (node.ip < count) {
+    LegacyInstruction *inst = &code[node.ip];
+    executed++;
+    switch (inst->opcode) {
+    case OP_MOV: {
+      int reg = get_reg_index(inst->reg1);
+      if (reg >= 0)
+        node.registers[reg] = get_value(&node, inst->reg2);
+      node.ip++;
+      break;
+    }
+    case OP_ADD: {
+      int reg = get_reg_index(inst->reg1);
+      if (reg >= 0)
+        node.registers[reg] = socket->alu_add(node.registers[reg],
+                                              get_value(&node, inst->reg2));
+      node.ip++;
+      break;
+    }
+    case OP_CMP:
+      node.cmp_flag = socket->alu_cmp(get_value(&node, inst->reg1),
+                                      get_value(&node, inst->reg2));
+      node.ip++;
+      break;
+    case OP_BNE:
+      node.ip = (node.cmp_flag != 0) ? inst->target : node.ip + 1;
+      break;
+    default:
+      node.ip++;
+      break;
+    }
+  }
+
+  return executed;
+}
+
+// --- Decoded operands: the real pufu_node_execute ---
+
+static PufuParser *load_program(char lines[][64], int optimize) {
+  PufuParser *parser = pufu_parser_init();
+  for (int i = 0; i < LOOP_LINES; i++)
+    pufu_parse_line(parser, lines[i]);
+  pufu_parser_link(parser, "bench_loop.pufu");
+  if (optimize)
+    pufu_parser_optimize(parser);
+  return parser;
+}
+
+static long long run_vm(PufuNodeSystem *sys, PufuParser *parser) {
+  PufuNode *node = pufu_create_node("bench_loop.pufu", PUFU_NODE_ASSEMBLER);
+  pufu_parser_cleanup(node->parser);
+  node->parser = parser;
+
+  while (pufu_node_execute(sys, node))
+    ;
+  long long executed = node->stats.instructions;
+  if (node->registers[1] != BENCH_ITERATIONS ||
+      node->registers[2] != BENCH_ITERATIONS + 2) {
+    printf("bench_vm: wrong result r1=%d r2=%d\n", node->registers[1],
+           node->registers[2]);
+    exit(1);
+  }
+
+  if (node->jit) {
+    char stats[256];
+    pufu_jit_format_stats(node->jit, stats, sizeof(stats));
+    printf("  %s\n", stats);
+  }
+
+  node->parser = NULL; // Owned by the caller
+  pufu_node_destroy(node);
+  return executed;
+}
+
+static void report(const char *name, long long executed, double secs) {
+  printf("%-28s %10lld insns  %8.3f s  %8.2f M insn/s  %6.1f ns/insn\n",
+         name, executed, secs, executed / secs / 1e6, secs * 1e9 / executed);
+}
+
+int main(void) {
+  if (pufu_test_load_socket("bench_vm") < 0)
+    return 1;
+
+  char lines[LOOP_LINES][64];
+  for (int i = 0; i < LOOP_LINES; i++)
+    snprintf(lines[i], sizeof(lines[i]), loop_program[i], BENCH_ITERATIONS);
+
+  PufuNodeSystem sys;
+  memset(&sys, 0, sizeof(sys));
+
+  printf("\n=== bench_vm [%s engine]: mov/add/cmp/bne loop (%d "
+         "iterations) ===\n",
+         pufu_node_engine(), BENCH_ITERATIONS);
+
+  double t0 = now_sec();
+  long long legacy = run_legacy(lines);
+  report("string operands (legacy)", legacy, now_sec() - t0);
+
+  PufuParser *plain = load_program(lines, 0);
+  t0 = now_sec();
+  long long decoded = run_vm(&sys, plain);
+  report("decoded operands (VM)", decoded, now_sec() - t0);
+  pufu_parser_cleanup(plain);
+
+  PufuParser *fused = load_program(lines, 1);
+  t0 = now_sec();
+  decoded = run_vm(&sys, fused);
+  report("superinstructions (VM)", decoded, now_sec() - t0);
+  pufu_parser_cleanup(fused);
+  return 0;
+}
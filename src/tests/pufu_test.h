@@ -0,0 +1,66 @@
+#ifndef PUFU_TEST_H
+#define PUFU_TEST_H
+
+// Test and Benchmark Scaffolding
+// Each program under src/tests is a single .c file linked against the core
+// objects (without entry.c), so the helpers they share live here as static
+// functions. Include it from exactly one file per program.
+
+#include "pufu/dyn_loader.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PUFU_TEST_PATH_MAX 32 // "/tmp/pufu_test_XXXXXX.pufu"
+
+// entry.c is not linked into tests and benchmarks
+void pufu_os_shutdown(void) { exit(0); }
+
+static inline double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Load the ARM socket as pufu_os does (paw code needs it). 0, or -1 after
+// telling the user how to run `name`.
+static inline int pufu_test_load_socket(const char *name) {
+  pufu_dyn_loader_init();
+  if (pufu_load_socket("bin/drivers/socket_arm.so") == 0)
+    return 0;
+  printf("%s: run from the repository root after `make`\n", name);
+  return -1;
+}
+
+// New temporary program file, open for writing; its name goes in `path`
+// and the caller removes it. NULL on failure.
+static inline FILE *pufu_test_open_program(char path[PUFU_TEST_PATH_MAX]) {
+  snprintf(path, PUFU_TEST_PATH_MAX, "/tmp/pufu_test_XXXXXX.pufu");
+  int fd = mkstemps(path, 5);
+  FILE *f = fd >= 0 ? fdopen(fd, "w") : NULL;
+  if (!f) {
+    perror(path);
+    if (fd >= 0) {
+      close(fd);
+      unlink(path);
+    }
+  }
+  return f;
+}
+
+// Same, with the whole source given printf-style. 0, or -1.
+static inline int pufu_test_write_program(char path[PUFU_TEST_PATH_MAX],
+                                          const char *format, ...) {
+  FILE *f = pufu_test_open_program(path);
+  if (!f)
+    return -1;
+  va_list args;
+  va_start(args, format);
+  vfprintf(f, format, args);
+  va_end(args);
+  return fclose(f) == 0 ? 0 : -1;
+}
+
+#endif // PUFU_TEST_H
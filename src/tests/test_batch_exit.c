@@ -0,0 +1,45 @@
+// Batch Exit Status Test
+// pufu_os --batch exits with the code its program passed to (exit), in
+// every operand form: immediate, register, quoted text or none at all.
+// Runs bin/pufu_os (built by `make test`) from the repository root.
+
+#include "pufu_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+// Run `program` in batch mode and check the process exit status
+static void check(const char *program, int status) {
+  char path[PUFU_TEST_PATH_MAX];
+  if (pufu_test_write_program(path, "%s\n", program) < 0) {
+    failures++;
+    return;
+  }
+
+  char cmd[256];
+  snprintf(cmd, sizeof(cmd),
+           "timeout 20 bin/pufu_os --batch --virtual-time %s "
+           "</dev/null >/dev/null 2>&1",
+           path);
+  int raw = system(cmd);
+  int got = (raw != -1 && WIFEXITED(raw)) ? WEXITSTATUS(raw) : -1;
+  unlink(path);
+  if (got != status) {
+    printf("test_batch_exit: '%s' exited %d, expected %d\n", program, got,
+           status);
+    failures++;
+  }
+}
+
+int main(void) {
+  check("syscall (exit)", 0);
+  check("syscall (exit) 4", 4);
+  check("mov r3 7\nsyscall (exit) r3", 7);
+  check("syscall (exit) \"3\"", 3); // Quoted: a string operand
+  check("(exit) \"5\"", 5);
+  printf("test_batch_exit: %s\n", failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
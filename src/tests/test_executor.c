@@ -0,0 +1,88 @@
+// Multi-core Executor Test
+// Two CPU-bound nodes under two workers must both be run by the workers,
+// one each (run queue affinity), not serialized on one of them. While they
+// are in flight the main thread may still look them up as syscall targets
+// (pufu_node_find), which must not read what the workers write: build with
+// -fsanitize=thread to check that.
+
+#include "pufu/executor.h"
+#include "pufu/scheduler.h"
+#include "pufu_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_NODES 2
+#define TEST_ITERATIONS 20000000
+
+// Same teardown as pufu_node_system_cleanup, minus the Trinity shutdown
+static void unload_all(PufuNodeSystem *sys) {
+  PufuNode *node = sys->nodes;
+  while (node) {
+    PufuNode *next = node->next;
+    pufu_node_destroy(node);
+    node = next;
+  }
+  pufu_proc_table_cleanup(&sys->procs);
+  memset(sys, 0, sizeof(*sys));
+}
+
+int main(void) {
+  char path[PUFU_TEST_PATH_MAX];
+  if (pufu_test_load_socket("test_executor") < 0 ||
+      pufu_test_write_program(path,
+                              "    mov r1 0\nlabel loop\n    add r1 1\n"
+                              "    cmp r1 %d\n    bne loop\n",
+                              TEST_ITERATIONS) < 0)
+    return 1;
+
+  PufuNodeSystem sys;
+  memset(&sys, 0, sizeof(sys));
+  int failures = pufu_proc_table_init(&sys.procs) < 0;
+  for (int i = 0; i < TEST_NODES; i++) {
+    if (!pufu_node_load(&sys, path))
+      failures++;
+  }
+  PufuScheduler *sched = failures ? NULL : pufu_scheduler_init(&sys, 2);
+  if (!sched || !sched->exec) {
+    printf("test_executor: setup failed\n");
+    unlink(path);
+    return 1;
+  }
+
+  int found_in_flight = 0;
+  while (pufu_scheduler_run_once(sched) > 0) {
+    if (pufu_executor_in_flight(sched->exec) > 0 &&
+        pufu_node_find(&sys, path))
+      found_in_flight++;
+  }
+
+  char stats[256];
+  pufu_executor_format_stats(sched->exec, stats, sizeof(stats));
+  long long turns[2] = {0, 0};
+  char *line = stats;
+  for (int i = 0; i < 2 && line; i++) {
+    sscanf(line, "worker %*d: %lld turns", &turns[i]);
+    line = strchr(line, '\n');
+    line = line ? line + 1 : NULL;
+  }
+  pufu_scheduler_cleanup(sched);
+
+  if (sys.reaped != TEST_NODES || sys.nodes) {
+    printf("test_executor: nodes left behind\n");
+    failures++;
+  }
+  if (turns[0] == 0 || turns[1] == 0) {
+    printf("test_executor: one worker ran every turn\n%s", stats);
+    failures++;
+  }
+  if (found_in_flight == 0) {
+    printf("test_executor: nodes on the workers were not found\n");
+    failures++;
+  }
+  unload_all(&sys);
+  unlink(path);
+  printf("test_executor: %s\n", failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,222 @@
+// Mailbox Test
+// Records are variable-length and live in a byte ring, so the cases that
+// matter are the ones a fixed-slot queue never meets: a record (header,
+// sender or content) split across the end of the arena, the arena growing
+// while the ring is wrapped, and the capacity shrinking below the number
+// of pending messages. Every message taken must match, byte for byte and
+// in order, what a plain FIFO of the posted messages holds.
+
+#include "pufu/mailbox.h"
+#include "pufu_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define QUEUE_MAX 64 // Reference FIFO; soak capacity stays below it
+
+static int failures = 0;
+
+// What the mailbox should hold, oldest first
+static PufuMessage expected[QUEUE_MAX];
+static int exp_head = 0, exp_count = 0;
+
+static void fail(const char *what) {
+  printf("test_mailbox: %s\n", what);
+  failures++;
+}
+
+// `len` chars of a pattern that differs for each `seed`
+static void fill(char *buf, int len, int seed) {
+  for (int i = 0; i < len; i++)
+    buf[i] = 'a' + (seed + i) % 26;
+  buf[len] = '\0';
+}
+
+// Post a text (or shared) message and expect `result`; on PUFU_MAIL_OK it
+// joins the reference FIFO
+static void post(PufuMailbox *mb, int sender_len, int content_len, int seed,
+                 int shared, int result) {
+  PufuMessage msg;
+  fill(msg.sender, sender_len, seed);
+  fill(msg.content, content_len, seed + 7);
+  msg.type = seed % 7;
+
+  int got;
+  if (shared) {
+    PufuMailPayload *payload = pufu_mail_payload_create(msg.content);
+    got = pufu_mailbox_post_shared(mb, msg.sender, payload, msg.type);
+    pufu_mail_payload_release(payload); // The mailbox keeps its own ref
+  } else {
+    got = pufu_mailbox_post(mb, msg.sender, msg.content, msg.type);
+  }
+  if (got != result) {
+    printf("test_mailbox: post returned %d, expected %d (count %d, "
+           "capacity %d)\n",
+           got, result, mb->count, mb->capacity);
+    failures++;
+  }
+  if (got == PUFU_MAIL_OK)
+    expected[(exp_head + exp_count++) % QUEUE_MAX] = msg;
+}
+
+// Take one message; it must be the oldest one in the reference FIFO
+static void take(PufuMailbox *mb) {
+  PufuMessage got;
+  if (!pufu_mailbox_take(mb, &got)) {
+    fail(exp_count ? "take found the mailbox empty" : "take on empty");
+    return;
+  }
+  if (exp_count == 0) {
+    fail("take returned a message nothing posted");
+    return;
+  }
+  const PufuMessage *want = &expected[exp_head];
+  exp_head = (exp_head + 1) % QUEUE_MAX;
+  exp_count--;
+  if (strcmp(got.sender, want->sender) != 0 ||
+      strcmp(got.content, want->content) != 0 || got.type != want->type) {
+    printf("test_mailbox: took '%s'/'%.20s...'/%d, expected '%s'/'%.20s...'"
+           "/%d\n",
+           got.sender, got.content, got.type, want->sender, want->content,
+           want->type);
+    failures++;
+  }
+}
+
+static void drain(PufuMailbox *mb) {
+  while (exp_count > 0 && failures == 0)
+    take(mb);
+  PufuMessage extra;
+  if (pufu_mailbox_take(mb, &extra))
+    fail("mailbox holds more than was posted");
+  if (mb->count != 0 || mb->used != 0)
+    fail("drained mailbox still accounts for records");
+}
+
+// 100-byte records (4 header + 1 sender + 95 content) in the 512-byte
+// arena: the sixth post starts at 500 and wraps, then an overflow grows
+// the arena while head < tail
+static void check_wrap_and_grow(void) {
+  PufuMailbox mb;
+  pufu_mailbox_init(&mb, 16);
+  for (int i = 0; i < 5; i++)
+    post(&mb, 1, 95, i, 0, PUFU_MAIL_OK);
+  for (int i = 0; i < 3; i++)
+    take(&mb);
+  post(&mb, 1, 95, 5, 0, PUFU_MAIL_OK); // Header at 500, body wraps
+  if (mb.arena_size != PUFU_MAILBOX_ARENA_MIN || mb.head >= mb.tail)
+    fail("record across the arena end did not wrap in place");
+  post(&mb, 1, 95, 6, 0, PUFU_MAIL_OK);
+  post(&mb, 1, 95, 7, 0, PUFU_MAIL_OK); // 500 of 512 bytes used
+  if (mb.arena_size != PUFU_MAILBOX_ARENA_MIN || mb.head >= mb.tail)
+    fail("ring should still be wrapped and unresized");
+
+  post(&mb, 1, 95, 8, 0, PUFU_MAIL_OK); // Does not fit: grow while wrapped
+  if (mb.arena_size <= PUFU_MAILBOX_ARENA_MIN || mb.tail != 0)
+    fail("wrapped ring did not grow into a fresh arena");
+  if (mb.count != 6)
+    fail("grow lost or duplicated records");
+  drain(&mb);
+  pufu_mailbox_cleanup(&mb);
+}
+
+// A shared record whose payload pointer straddles the arena end: the
+// pointer must come back whole and the payload be released exactly once
+static void check_shared_wrap(void) {
+  PufuMailbox mb;
+  pufu_mailbox_init(&mb, 16);
+  post(&mb, 1, 250, 0, 0, PUFU_MAIL_OK); // 255 bytes
+  post(&mb, 1, 244, 1, 0, PUFU_MAIL_OK); // 249 bytes, head at 504
+  take(&mb);
+  // Header at 504, sender at 508, pointer at 510..517 (wraps)
+  post(&mb, 2, 0, 2, 1, PUFU_MAIL_OK);
+  if (mb.head >= mb.tail || mb.arena_size != PUFU_MAILBOX_ARENA_MIN)
+    fail("shared record did not wrap");
+
+  PufuMailPayload *payload = pufu_mail_payload_create("kept alive");
+  PufuMessage msg = {"s", "kept alive", 5};
+  if (pufu_mailbox_post_shared(&mb, msg.sender, payload, msg.type) ==
+      PUFU_MAIL_OK)
+    expected[(exp_head + exp_count++) % QUEUE_MAX] = msg;
+  if (payload->refs != 2)
+    fail("shared post did not take a reference");
+  drain(&mb);
+  if (payload->refs != 1)
+    fail("take did not release the shared reference");
+  pufu_mail_payload_release(payload);
+  pufu_mailbox_cleanup(&mb);
+}
+
+// Capacity below the pending count keeps the messages and refuses posts
+// until the reader is back under it
+static void check_shrink(void) {
+  PufuMailbox mb;
+  pufu_mailbox_init(&mb, 16);
+  for (int i = 0; i < 6; i++)
+    post(&mb, 3, 40, i, i % 2, PUFU_MAIL_OK);
+  if (pufu_mailbox_set_capacity(&mb, 2) != 2)
+    fail("set_capacity did not return the new capacity");
+  long long dropped = mb.dropped;
+  post(&mb, 3, 40, 6, 0, PUFU_MAIL_FULL);
+  post(&mb, 3, 40, 7, 1, PUFU_MAIL_FULL);
+  if (mb.dropped != dropped + 2 || mb.count != 6)
+    fail("refused posts were not counted as dropped");
+  for (int i = 0; i < 4; i++)
+    take(&mb);
+  post(&mb, 3, 40, 8, 0, PUFU_MAIL_FULL); // 2 pending, capacity 2
+  take(&mb);
+  post(&mb, 3, 40, 9, 0, PUFU_MAIL_OK);
+  post(&mb, 3, 40, 10, 0, PUFU_MAIL_FULL);
+  if (pufu_mailbox_set_capacity(&mb, 0) != 1 ||
+      pufu_mailbox_set_capacity(&mb, 1 << 20) != PUFU_MAILBOX_MAX_CAPACITY)
+    fail("capacity is not clamped");
+  drain(&mb);
+  pufu_mailbox_cleanup(&mb);
+}
+
+// Long truncated fields, then a random mix of posts, takes and capacity
+// changes checked against the reference FIFO
+static void check_soak(void) {
+  PufuMailbox mb;
+  pufu_mailbox_init(&mb, 8);
+  char sender[PUFU_MAIL_SENDER_MAX + 40], content[PUFU_MAIL_CONTENT_MAX + 40];
+  fill(sender, sizeof(sender) - 1, 3);
+  fill(content, sizeof(content) - 1, 4);
+  pufu_mailbox_post(&mb, sender, content, 1);
+  PufuMessage got;
+  if (!pufu_mailbox_take(&mb, &got) ||
+      strlen(got.sender) != PUFU_MAIL_SENDER_MAX ||
+      strlen(got.content) != PUFU_MAIL_CONTENT_MAX ||
+      strncmp(got.content, content, PUFU_MAIL_CONTENT_MAX) != 0)
+    fail("long sender/content not truncated to the limits");
+
+  unsigned seed = 12345;
+  int wraps = 0;
+  for (int i = 0; i < 20000 && failures == 0; i++) {
+    seed = seed * 1103515245u + 12345u;
+    unsigned r = seed >> 8;
+    if (r % 53 == 0) {
+      pufu_mailbox_set_capacity(&mb, 1 + r % (QUEUE_MAX - 1));
+    } else if (r % 5 < 3) {
+      int result = mb.count >= mb.capacity ? PUFU_MAIL_FULL : PUFU_MAIL_OK;
+      post(&mb, 1 + r % 20, r % 200, i, r % 4 == 0, result);
+    } else if (exp_count > 0) {
+      take(&mb);
+    }
+    if (mb.count > 0 && mb.head < mb.tail)
+      wraps++;
+  }
+  if (wraps == 0)
+    fail("soak never wrapped the ring");
+  drain(&mb);
+  pufu_mailbox_cleanup(&mb);
+}
+
+int main(void) {
+  check_wrap_and_grow();
+  check_shared_wrap();
+  check_shrink();
+  check_soak();
+  printf("test_mailbox: %s\n", failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
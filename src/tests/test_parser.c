@@ -0,0 +1,80 @@
+// Parser Operand Test
+// Register operands must decode to an index the VM can use (r0-r15), the
+// same rule the .pufub loader applies to cached images: anything else that
+// starts like a register ("r16", "r2x") is a parse error, not a silent
+// immediate. Branch targets are label names whatever they look like, so
+// "r2loop" and "1st" link.
+
+#include "pufu/parser.h"
+#include "pufu_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PARSE_ERROR -1 // Expected kind: the line must be rejected
+
+static int failures = 0;
+
+// Parse `line` into a fresh parser and check operand a of its instruction
+static void check(const char *line, int kind, int value) {
+  PufuParser *parser = pufu_parser_init();
+  int parsed = parser ? pufu_parse_line(parser, line) : -1;
+  if (kind == PARSE_ERROR) {
+    if (parsed >= 0) {
+      printf("test_parser: '%s' parsed, expected an error\n", line);
+      failures++;
+    }
+  } else if (parsed < 0 || parser->count != 1) {
+    printf("test_parser: '%s' did not parse\n", line);
+    failures++;
+  } else {
+    const PufuInstruction *inst = &parser->instructions[0];
+    // Text operands: only the kind matters (value = pool offset)
+    int got_value = (kind == PUFU_OPERAND_STR) ? value : inst->a;
+    if (inst->a_kind != kind || got_value != value) {
+      printf("test_parser: '%s': kind %d value %d, expected %d/%d\n", line,
+             inst->a_kind, inst->a, kind, value);
+      failures++;
+    }
+  }
+  pufu_parser_cleanup(parser);
+}
+
+// Parse and link `lines`; the branch (last line) must target `target`
+static void check_branch(const char *lines[], int count, int target) {
+  PufuParser *parser = pufu_parser_init();
+  int ok = parser != NULL;
+  for (int i = 0; ok && i < count; i++)
+    ok = pufu_parse_line(parser, lines[i]) == 0;
+  ok = ok && pufu_parser_link(parser, NULL) == 0;
+  const PufuInstruction *inst =
+      ok ? &parser->instructions[parser->count - 1] : NULL;
+  if (!inst || inst->a_kind != PUFU_OPERAND_LABEL || inst->a != target) {
+    printf("test_parser: '%s' did not link to %d\n", lines[count - 1],
+           target);
+    failures++;
+  }
+  pufu_parser_cleanup(parser);
+}
+
+int main(void) {
+  check("mov r0 1", PUFU_OPERAND_REG, 0);
+  check("mov r15 1", PUFU_OPERAND_REG, 15);
+  check("mov r-1 1", PUFU_OPERAND_STR, 0); // Not a number: text
+  check("mov r16 1", PARSE_ERROR, 0);
+  check("mov r1 r16", PARSE_ERROR, 0);
+  check("mov r2147483648 1", PARSE_ERROR, 0); // Would wrap to INT_MIN
+  check("mov r4294967311 1", PARSE_ERROR, 0); // Would wrap to 15
+  check("mov r2x 1", PARSE_ERROR, 0);         // Would read as r2
+  check("(exit) r16", PARSE_ERROR, 0);
+  check("bne r2loop", PUFU_OPERAND_STR, 0);
+  check("jmp 1st", PUFU_OPERAND_STR, 0);
+
+  const char *reg_like[] = {"r2loop:", "mov r1 1", "bne r2loop"};
+  check_branch(reg_like, 3, 0);
+  const char *digit_first[] = {"mov r1 1", "label 1st", "add r1 1",
+                               "jmp 1st"};
+  check_branch(digit_first, 4, 1);
+
+  printf("test_parser: %s\n", failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
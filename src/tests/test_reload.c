@@ -0,0 +1,119 @@
+// Hot Reload Test
+// Nodes spawned from one file share its program image. Editing the file
+// (in place, or by renaming a new version over it as editors do) must make
+// the scheduler invalidate that image, so the next spawn gets the new code
+// while the nodes already running keep the code they started with.
+
+#include "pufu/program.h"
+#include "pufu/pufub.h"
+#include "pufu/scheduler.h"
+#include "pufu_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_PASSES 20 // Scheduler passes (>= 100 ms each) to notice an edit
+
+static int failures = 0;
+
+// Version `n` of the program: n movs, then a sleep loop (n + 2
+// instructions, never exits on its own)
+static int write_version(const char *path, int n) {
+  FILE *f = fopen(path, "w");
+  if (!f)
+    return -1;
+  for (int i = 0; i < n; i++)
+    fprintf(f, "    mov r1 %d\n", i);
+  fprintf(f, "idle:\n"
+             "    syscall (sleep) \"100\"\n"
+             "    jmp idle\n");
+  return fclose(f);
+}
+
+// Run passes until the scheduler reports a reload. Every node sleeps, so
+// a pass blocks in epoll_wait until the inotify event (or a wakeup).
+static int wait_reload(PufuScheduler *sched) {
+  for (int i = 0; i < TEST_PASSES; i++) {
+    pufu_scheduler_run_once(sched);
+    if (sched->reloads > 0)
+      return 1;
+  }
+  return 0;
+}
+
+// Spawn from `path` after an edit to version `n`: new image with n + 2
+// instructions, `old` untouched
+static PufuNode *check_spawn(PufuNodeSystem *sys, const char *path,
+                             const char *what, PufuNode *old, int n) {
+  PufuNode *node = pufu_node_load(sys, path);
+  if (!node) {
+    printf("test_reload: %s: spawn failed\n", what);
+    failures++;
+    return NULL;
+  }
+  if (node->program == old->program || node->parser->count != n + 2) {
+    printf("test_reload: %s: spawn got %d instructions, expected %d\n", what,
+           node->parser->count, n + 2);
+    failures++;
+  }
+  if (!old->program->stale || old->parser->count == n + 2) {
+    printf("test_reload: %s: running node lost its image\n", what);
+    failures++;
+  }
+  return node;
+}
+
+int main(void) {
+  char path[PUFU_TEST_PATH_MAX], next[PUFU_TEST_PATH_MAX + 4];
+  if (pufu_test_load_socket("test_reload") < 0 ||
+      pufu_test_write_program(path, "") < 0)
+    return 1;
+  snprintf(next, sizeof(next), "%s.new", path);
+
+  pufu_pufub_set_enabled(0); // Sources only: no cache files left behind
+  PufuNodeSystem *sys = pufu_node_system_init();
+  PufuScheduler *sched = sys ? pufu_scheduler_init(sys, 0) : NULL;
+  PufuNode *first = NULL, *twin = NULL;
+  if (!sched || write_version(path, 1) < 0 ||
+      !(first = pufu_node_load(sys, path)) ||
+      !(twin = pufu_node_load(sys, path))) {
+    printf("test_reload: setup failed\n");
+    unlink(path);
+    return 1;
+  }
+  if (twin->program != first->program) {
+    printf("test_reload: unchanged file was loaded twice\n");
+    failures++;
+  }
+
+  // Saved in place
+  PufuNode *edited = NULL;
+  if (write_version(path, 2) < 0 || !wait_reload(sched)) {
+    printf("test_reload: in-place edit not noticed\n");
+    failures++;
+  } else {
+    edited = check_spawn(sys, path, "in-place edit", first, 2);
+  }
+
+  // Replaced by rename
+  if (edited && (write_version(next, 3) < 0 || rename(next, path) < 0 ||
+                 !wait_reload(sched))) {
+    printf("test_reload: replaced file not noticed\n");
+    failures++;
+  } else if (edited) {
+    check_spawn(sys, path, "rename", edited, 3);
+  }
+
+  // The images of live nodes stay loaded, stale or not
+  if (pufu_program_count() != 3 && failures == 0) {
+    printf("test_reload: %d images loaded, expected 3\n",
+           pufu_program_count());
+    failures++;
+  }
+  pufu_scheduler_cleanup(sched);
+  unlink(next);
+  unlink(path);
+  printf("test_reload: %s\n", failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
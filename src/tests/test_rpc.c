@@ -0,0 +1,139 @@
+// RPC Deadline Test
+// (call) leaves its outcome in r0: 0 for a reply, -2 when the deadline
+// passes first, -1 when the server is gone or exits holding the request.
+// A reply to a call that already timed out must be dropped and counted as
+// late, and a server that dies must fail its callers at once, not at their
+// deadline. Runs in virtual time, so the deadlines cost no real time and
+// every run interleaves the same way.
+
+#include "pufu/scheduler.h"
+#include "pufu_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+// Servers: take one request, then answer it, answer it 200 ms later or
+// exit without answering
+static const char *servers[] = {
+    "serve:\n"
+    "    syscall (rpc_accept) r7\n"
+    "    cmp r7 0\n"
+    "    beq serve\n"
+    "    syscall (prepend_string) \"echo \"\n"
+    "    syscall (reply) r7\n"
+    "    syscall (exit)\n",
+
+    "serve:\n"
+    "    syscall (rpc_accept) r7\n"
+    "    cmp r7 0\n"
+    "    beq serve\n"
+    "    syscall (sleep) \"200\"\n"
+    "    syscall (reply) r7\n"
+    "    syscall (exit)\n",
+
+    "serve:\n"
+    "    syscall (rpc_accept) r7\n"
+    "    cmp r7 0\n"
+    "    beq serve\n"
+    "    syscall (exit)\n",
+};
+enum { ECHO, SLOW, DOOMED, NO_SERVER };
+
+// One caller as the arbiter: (call) `server` with a `timeout_ms` deadline,
+// stay up 500 ms so a late reply can still arrive, then (exit) with r0.
+// Returns that status; `elapsed_ms` is the virtual time the run took.
+static int run_call(PufuScheduler *sched, int server, int timeout_ms,
+                    long long *elapsed_ms) {
+  PufuNodeSystem *sys = sched->system;
+  char server_path[PUFU_TEST_PATH_MAX], caller_path[PUFU_TEST_PATH_MAX];
+  int pid = 99999; // NO_SERVER: nobody has it
+  if (server != NO_SERVER) {
+    if (pufu_test_write_program(server_path, "%s", servers[server]) < 0)
+      return -100;
+    PufuNode *node = pufu_node_load(sys, server_path);
+    unlink(server_path);
+    if (!node)
+      return -100;
+    pid = node->pid;
+  }
+  if (pufu_test_write_program(caller_path,
+                              "    syscall (clear_buffer)\n"
+                              "    syscall (prepend_string) \"ping\"\n"
+                              "    syscall (call) \"%d %d\"\n"
+                              "    mov r1 r0\n"
+                              "    syscall (sleep) \"500\"\n"
+                              "    syscall (exit) r1\n",
+                              pid, timeout_ms) < 0)
+    return -100;
+  PufuNode *caller = pufu_node_load(sys, caller_path);
+  unlink(caller_path);
+  if (!caller || pufu_node_set_arbiter(sys, caller) < 0)
+    return -100;
+
+  long long t0 = get_time_ms();
+  while (pufu_scheduler_run_once(sched) > 0)
+    ;
+  *elapsed_ms = get_time_ms() - t0;
+  if (sys->nodes) {
+    printf("test_rpc: nodes left behind\n");
+    failures++;
+  }
+  return sys->exit_status;
+}
+
+// Run one call; r0 and the change in each RPC counter must match
+static void check(PufuScheduler *sched, const char *what, int server,
+                  int timeout_ms, int r0, const PufuRpcStats *delta) {
+  PufuRpcStats before = sched->system->rpc;
+  long long elapsed = 0;
+  int got = run_call(sched, server, timeout_ms, &elapsed);
+  const PufuRpcStats *after = &sched->system->rpc;
+  if (got != r0) {
+    printf("test_rpc: %s: r0 = %d, expected %d\n", what, got, r0);
+    failures++;
+  }
+  if (after->calls - before.calls != delta->calls ||
+      after->replies - before.replies != delta->replies ||
+      after->timeouts - before.timeouts != delta->timeouts ||
+      after->failed - before.failed != delta->failed ||
+      after->late - before.late != delta->late) {
+    char stats[256];
+    pufu_rpc_format_stats(after, stats, sizeof(stats));
+    printf("test_rpc: %s: unexpected counters (%s)\n", what, stats);
+    failures++;
+  }
+  // Only the caller's 500 ms stay: a failed call must not wait for its
+  // deadline
+  if (server == DOOMED && elapsed >= timeout_ms) {
+    printf("test_rpc: %s: took %lld ms, the deadline was %d\n", what,
+           elapsed, timeout_ms);
+    failures++;
+  }
+}
+
+int main(void) {
+  pufu_clock_set_virtual(1);
+  if (pufu_test_load_socket("test_rpc") < 0)
+    return 1;
+  PufuNodeSystem *sys = pufu_node_system_init();
+  PufuScheduler *sched = sys ? pufu_scheduler_init(sys, 0) : NULL;
+  if (!sched) {
+    printf("test_rpc: setup failed\n");
+    return 1;
+  }
+
+  // {calls, replies, timeouts, failed, late}
+  check(sched, "reply", ECHO, 50, 0, &(PufuRpcStats){1, 1, 0, 0, 0});
+  check(sched, "timeout", SLOW, 50, -2, &(PufuRpcStats){1, 0, 1, 0, 1});
+  check(sched, "server reaped", DOOMED, 5000, -1,
+        &(PufuRpcStats){1, 0, 0, 1, 0});
+  check(sched, "no server", NO_SERVER, 50, -1,
+        &(PufuRpcStats){0, 0, 0, 0, 0});
+
+  pufu_scheduler_cleanup(sched);
+  printf("test_rpc: %s\n", failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,52 @@
+// Timer Wheel Test
+// A timer must fire on the exact tick of its deadline whatever level it was
+// filed in, including deadlines that land on a level boundary (a multiple
+// of 64 or 4096 ticks), which reach level 0 through a cascade.
+
+#include "pufu/timer_wheel.h"
+#include "pufu_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static int failures = 0;
+
+static void record(PufuTimer *timer, void *arg) {
+  (void)timer;
+  *(long long *)arg = 1;
+}
+
+// Start at `start`, arm one timer for `expires` and advance one tick at a
+// time: it must fire on `expires` and not before
+static void check(long long start, long long expires) {
+  static PufuTimerWheel wheel; // 16 KB of list heads
+  PufuTimer timer = {0};
+  pufu_timer_wheel_init(&wheel, start);
+  pufu_timer_add(&wheel, &timer, expires);
+
+  long long fired_at = -1;
+  for (long long t = start + 1; t <= expires + 64 && fired_at < 0; t++) {
+    long long fired = 0;
+    pufu_timer_wheel_advance(&wheel, t, record, &fired);
+    if (fired)
+      fired_at = t;
+  }
+  if (fired_at != expires) {
+    printf("test_timer_wheel: start %lld, deadline %lld fired at %lld\n",
+           start, expires, fired_at);
+    failures++;
+  }
+}
+
+int main(void) {
+  check(0, 1);
+  check(0, 63);
+  check(0, 64);     // Level 1 boundary
+  check(10, 128);   // Level 1, cascades on its own tick
+  check(10, 229);   // Level 1, off the boundary
+  check(0, 4096);   // Level 2 boundary
+  check(100, 8192); // Level 2, cascades through level 1 slot 0
+  check(0, 4160);   // Level 2, then level 1
+  check(5, 262144); // Level 3 boundary
+  printf("test_timer_wheel: %s\n", failures ? "FAILED" : "OK");
+  return failures ? 1 : 0;
+}
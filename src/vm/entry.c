@@ -1,7 +1,10 @@
+#include "pufu/boot_trace.h"
 #include "pufu/dyn_loader.h"
 #include "pufu/loader.h"
 #include "pufu/logger.h"
 #include "pufu/node.h"
+#include "pufu/pufub.h"
+#include "pufu/scheduler.h"
 #include "pufu/terminal.h"
 #include "pufu/trinity.h"
 #include "pufu/version.h"
@@ -10,12 +13,15 @@
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #define PID_FILE "pufu.pid"
 static int running = 1;
+static int stop_signal = 0;
+static int batch_mode = 0; // --batch: headless, no PID file, exit status
 
 // Forward decl
 void pufu_node_system_cleanup(PufuNodeSystem *system);
@@ -25,11 +31,11 @@ void pufu_os_shutdown(void) {
   // Unsafe printf removed to prevent deadlock in signal handler
   // printf("\n=== Shutting down Pufu OS ===\n");
 
-  // Attempt to dump log before cleanup
-  pufu_logger_dump("system.log");
-
-  // Remove PID file
-  unlink(PID_FILE);
+  // Attempt to dump log before cleanup (batch runs leave no files behind)
+  if (!batch_mode) {
+    pufu_logger_dump("system.log");
+    unlink(PID_FILE);
+  }
 
   // Restore Terminal
   pufu_terminal_restore();
@@ -42,10 +48,10 @@ void pufu_os_shutdown(void) {
 }
 
 void handle_signal(int sig) {
-  (void)sig;
   // SAFE SHUTDOWN: set flag, let main loop exit.
   // printf is unsafe here if main loop is printing.
   running = 0;
+  stop_signal = sig;
 }
 
 void handle_crash(int sig) {
@@ -95,9 +101,66 @@ void show_loading_animation(void) {
   printf("\n\n");
 }
 
+// Imprimir el programa decodificado (pufu_os --disasm <file.pufu>)
+static int disassemble_file(const char *filename) {
+  PufuParser *parser = pufu_parser_init();
+  if (!parser)
+    return 1;
+  if (pufu_parse_file(parser, filename) < 0 ||
+      pufu_parser_link(parser, filename) < 0) {
+    printf("Error: No se pudo cargar %s\n", filename);
+    pufu_parser_cleanup(parser);
+    return 1;
+  }
+  pufu_parser_optimize(parser);
+  pufu_parser_disassemble(parser, stdout);
+  pufu_parser_cleanup(parser);
+  return 0;
+}
+
 int main(int argc, char **argv) {
+  pufu_boot_trace_start();
   if (argc < 2) {
-    printf("Uso: %s <bootloader.pufu>\n", argv[0]);
+    printf("Uso: %s [--no-cache] [--workers N|auto] [--virtual-time] "
+           "[--batch] <bootloader.pufu>\n",
+           argv[0]);
+    printf("     %s --disasm <file.pufu>\n", argv[0]);
+    return 1;
+  }
+
+  if (strcmp(argv[1], "--disasm") == 0) {
+    if (argc < 3) {
+      printf("Uso: %s --disasm <file.pufu>\n", argv[0]);
+      return 1;
+    }
+    return disassemble_file(argv[2]);
+  }
+
+  // --no-cache: parse every node from source, ignore .pufu_cache/
+  // --workers N|auto: run compute-bound nodes on N worker threads
+  // --virtual-time: simulated clock, sleeps fast-forward (tests)
+  // --batch: run a program to completion; its output on stdout, the
+  //   system's on stderr; exit status from (exit)
+  const char *boot_file = NULL;
+  int workers = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--no-cache") == 0) {
+      pufu_pufub_set_enabled(0);
+    } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+      i++;
+      workers = strcmp(argv[i], "auto") == 0 ? -1 : atoi(argv[i]);
+    } else if (strcmp(argv[i], "--virtual-time") == 0) {
+      pufu_clock_set_virtual(1);
+    } else if (strcmp(argv[i], "--batch") == 0) {
+      batch_mode = 1;
+    } else {
+      boot_file = argv[i];
+    }
+  }
+  if (!boot_file) {
+    printf("Uso: %s [--no-cache] [--workers N|auto] [--virtual-time] "
+           "[--batch] <bootloader.pufu>\n",
+           argv[0]);
     return 1;
   }
 
@@ -109,7 +172,16 @@ int main(int argc, char **argv) {
 
   pufu_logger_init();
 
-  // Disable stdout buffering for responsive terminal
+  // Batch: program output keeps the real stdout, everything else that
+  // prints goes to stderr
+  if (batch_mode) {
+    int out = dup(STDOUT_FILENO);
+    if (out < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+      perror("pufu_os: --batch");
+      return 1;
+    }
+    pufu_terminal_set_batch(out);
+  }
 
   // Disable stdout buffering for responsive terminal in Colab
   setvbuf(stdout, NULL, _IONBF, 0);
@@ -122,6 +194,7 @@ int main(int argc, char **argv) {
   pufu_watchdog_init();
 
   // Inicializar Loader
+  long long t0 = pufu_boot_trace_now();
   pufu_dyn_loader_init();
   const char *default_socket = "bin/drivers/socket_arm.so";
   if (pufu_load_socket(default_socket) < 0) {
@@ -131,30 +204,41 @@ int main(int argc, char **argv) {
       return 1;
     }
   }
+  pufu_boot_trace_span("socket", t0);
 
-  // Prevent multiple instances
-  check_pid_file();
+  // Prevent multiple instances (batch runs may overlap)
+  if (!batch_mode)
+    check_pid_file();
 
   // Inicializar sistema de nodos
+  t0 = pufu_boot_trace_now();
   PufuNodeSystem *system = pufu_node_system_init();
   if (!system) {
     pufu_log("Error: No se pudo inicializar el sistema de nodos");
     return 1;
   }
+  pufu_boot_trace_span("node_system", t0);
 
   // pufu_logger_init(); // Moved to top
 
-  // Configurar terminal en modo RAW (Global)
-  pufu_terminal_init();
-  atexit(pufu_terminal_restore); // Failsafe cleanup
+  // Configurar terminal en modo RAW (Global); batch leaves it alone
+  if (!batch_mode) {
+    pufu_terminal_init();
+    atexit(pufu_terminal_restore); // Failsafe cleanup
+  }
 
-  // Mostrar animación de carga
-  show_loading_animation();
+  // Mostrar animación de carga (not in batch or virtual-time runs)
+  if (!batch_mode && !pufu_clock_is_virtual()) {
+    t0 = pufu_boot_trace_now();
+    show_loading_animation();
+    pufu_boot_trace_span("loading_animation", t0);
+  }
 
   // Cargar nodo árbitro (so.pufu)
-  PufuNode *arbiter = pufu_node_load(system, argv[1]);
+  t0 = pufu_boot_trace_now();
+  PufuNode *arbiter = pufu_node_load(system, boot_file);
   if (!arbiter) {
-    printf("Error: No se pudo cargar el nodo inicial: %s\n", argv[1]);
+    printf("Error: No se pudo cargar el nodo inicial: %s\n", boot_file);
     pufu_terminal_restore();
     pufu_node_system_cleanup(system);
     return 1;
@@ -168,6 +252,7 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  pufu_boot_trace_span("arbiter_load", t0);
   pufu_log("Nodo inicial cargado: %s", arbiter->filename);
   pufu_log("Cediendo control al nodo inicial...\n");
 
@@ -179,27 +264,24 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  // Bucle principal
+  // Bucle principal: event-driven, sleeps until the next timer or I/O
+  t0 = pufu_boot_trace_now();
+  PufuScheduler *sched = pufu_scheduler_init(system, workers);
+  if (!sched) {
+    printf("Error: No se pudo iniciar el scheduler\n");
+    pufu_terminal_restore();
+    pufu_node_system_cleanup(system);
+    return 1;
+  }
+  pufu_boot_trace_span("scheduler_init", t0);
 
   while (running) {
-    // Verificar cambios en todos los nodos (hot-reload)
-    int changes = pufu_node_system_check(system);
+    int active_nodes = pufu_scheduler_run_once(sched);
 
-    if (changes > 0) {
+    if (sched->reloads > 0) {
       printf("Hot-reload detectado.\n");
     }
 
-    int active_nodes = 0;
-    PufuNode *current = system->nodes;
-    while (current) {
-      if (current->active) {
-        active_nodes++;
-        pufu_node_execute(system, current);
-      }
-      current = current->next;
-    }
-    fflush(stdout);
-
     // Si no hay nodos activos, el sistema murio
     if (active_nodes == 0) {
       if (running) { // Only print if not manually stopped
@@ -207,19 +289,25 @@ int main(int argc, char **argv) {
       }
       break;
     }
-
-    // Yield CPU briefly to allow OS to deliver signals and reduce CPU usage
-    if (active_nodes > 0) {
-      // En un sistema real esto seria un wait for interrupt o select/epoll
-      // Aqui usamos un sleep moderado (10ms) para bajar el uso de CPU.
-      usleep(10000);
-    }
   }
+  pufu_boot_trace_finish(); // Stopped before anything waited for input
+  if (pufu_clock_is_virtual())
+    printf("[Bootloader] Virtual time: %lld ms, %lld fast-forwards\n",
+           get_time_ms() - PUFU_VIRTUAL_EPOCH_MS,
+           sched->stats.fast_forwards);
+  pufu_scheduler_cleanup(sched);
+
+  // Batch exit status: the initial node's (exit) code, 128+N on a signal
+  int status = system->arbiter ? system->arbiter->exit_code
+                               : system->exit_status;
+  if (stop_signal)
+    status = 128 + stop_signal;
 
   // Cleanup on exit
   printf("\n=== Shutting down Pufu ===\n");
   printf("[Bootloader] Cleaning up Node System...\n");
-  pufu_logger_dump("system.log");
+  if (!batch_mode)
+    pufu_logger_dump("system.log");
   pufu_node_system_cleanup(system);
 
   // Ensure Window is closed
@@ -228,5 +316,5 @@ int main(int argc, char **argv) {
   printf("[Bootloader] Restoring Terminal...\n");
   pufu_terminal_restore();
   printf("[Bootloader] Bye!\n");
-  return 0;
+  return batch_mode ? status : 0;
 }
\ No newline at end of file
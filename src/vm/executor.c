@@ -0,0 +1,259 @@
+#include "pufu/executor.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+typedef struct {
+  PufuExecutor *exec;
+  int id;
+  pthread_t thread;
+  pthread_mutex_t lock; // Guards head/tail
+  PufuNode *head;
+  PufuNode *tail;
+  long long turns; // Relaxed atomics: read by the stats dump
+  long long steals;
+} PufuWorker;
+
+struct PufuExecutor {
+  PufuWorker *workers;
+  int count;
+  int next;      // Round robin for nodes without a worker yet
+  int in_flight; // Main thread only
+
+  pthread_mutex_t idle_lock; // Guards queued/stop and the idle wait
+  pthread_cond_t idle;
+  int queued; // Turns sitting in run queues (not running)
+  int stop;
+  int hold; // Draining: hand every turn back instead of requeueing
+
+  pthread_mutex_t done_lock; // Guards done/finished
+  pthread_cond_t drained;
+  PufuNode *done;
+  long long finished; // Turns completed by workers
+  long long submitted; // Main thread only
+  int event_fd;
+};
+
+static void queue_push(PufuWorker *w, PufuNode *node) {
+  node->exec_next = NULL;
+  pthread_mutex_lock(&w->lock);
+  if (w->tail)
+    w->tail->exec_next = node;
+  else
+    w->head = node;
+  w->tail = node;
+  pthread_mutex_unlock(&w->lock);
+}
+
+static PufuNode *queue_pop(PufuWorker *w) {
+  pthread_mutex_lock(&w->lock);
+  PufuNode *node = w->head;
+  if (node) {
+    w->head = node->exec_next;
+    if (!w->head)
+      w->tail = NULL;
+  }
+  pthread_mutex_unlock(&w->lock);
+  return node;
+}
+
+// Own queue first, then the others starting at the next worker
+static PufuNode *take(PufuWorker *self) {
+  PufuExecutor *exec = self->exec;
+  PufuNode *node = queue_pop(self);
+  for (int i = 1; !node && i < exec->count; i++) {
+    node = queue_pop(&exec->workers[(self->id + i) % exec->count]);
+    if (node)
+      __atomic_fetch_add(&self->steals, 1, __ATOMIC_RELAXED);
+  }
+  return node;
+}
+
+static void complete(PufuExecutor *exec, PufuNode *node) {
+  pthread_mutex_lock(&exec->done_lock);
+  node->exec_next = exec->done;
+  exec->done = node;
+  exec->finished++;
+  pthread_cond_signal(&exec->drained);
+  pthread_mutex_unlock(&exec->done_lock);
+
+  uint64_t one = 1;
+  if (write(exec->event_fd, &one, sizeof(one)) < 0)
+    perror("[Executor] eventfd");
+}
+
+// The turn ran out of quantum: the node needs nothing from the main thread
+static int still_computing(PufuExecutor *exec, PufuNode *node) {
+  return node->active && node->yielded == PUFU_YIELD_NONE &&
+         !__atomic_load_n(&node->stop_pending, __ATOMIC_ACQUIRE) &&
+         !__atomic_load_n(&exec->hold, __ATOMIC_ACQUIRE);
+}
+
+// Back of our own queue: nodes on the other queues get their turn first,
+// and idle workers can still steal it
+static void requeue(PufuExecutor *exec, PufuWorker *self, PufuNode *node) {
+  queue_push(self, node);
+  pthread_mutex_lock(&exec->idle_lock);
+  exec->queued++;
+  pthread_cond_signal(&exec->idle);
+  pthread_mutex_unlock(&exec->idle_lock);
+}
+
+static void *worker_main(void *arg) {
+  PufuWorker *self = arg;
+  PufuExecutor *exec = self->exec;
+
+  for (;;) {
+    pthread_mutex_lock(&exec->idle_lock);
+    while (!exec->stop && exec->queued == 0)
+      pthread_cond_wait(&exec->idle, &exec->idle_lock);
+    if (exec->stop) {
+      pthread_mutex_unlock(&exec->idle_lock);
+      return NULL;
+    }
+    exec->queued--; // Claim one: it is in some queue (pushed before counted)
+    pthread_mutex_unlock(&exec->idle_lock);
+
+    PufuNode *node = NULL;
+    while (!node)
+      node = take(self);
+
+    pufu_node_execute_compute(node);
+    node->worker = self->id;
+    __atomic_fetch_add(&self->turns, 1, __ATOMIC_RELAXED);
+    if (still_computing(exec, node))
+      requeue(exec, self, node);
+    else
+      complete(exec, node);
+  }
+}
+
+PufuExecutor *pufu_executor_init(int workers) {
+  if (workers <= 0)
+    workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (workers <= 0)
+    workers = 1;
+
+  PufuExecutor *exec = calloc(1, sizeof(PufuExecutor));
+  if (!exec)
+    return NULL;
+  exec->workers = calloc(workers, sizeof(PufuWorker));
+  exec->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (!exec->workers || exec->event_fd < 0) {
+    perror("[Executor] init");
+    if (exec->event_fd >= 0)
+      close(exec->event_fd);
+    free(exec->workers);
+    free(exec);
+    return NULL;
+  }
+  pthread_mutex_init(&exec->idle_lock, NULL);
+  pthread_cond_init(&exec->idle, NULL);
+  pthread_mutex_init(&exec->done_lock, NULL);
+  pthread_cond_init(&exec->drained, NULL);
+
+  for (int i = 0; i < workers; i++) {
+    PufuWorker *w = &exec->workers[i];
+    w->exec = exec;
+    w->id = i;
+    pthread_mutex_init(&w->lock, NULL);
+    if (pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+      printf("[Executor] No se pudo crear el worker %d\n", i);
+      break;
+    }
+    exec->count++;
+  }
+  if (exec->count == 0) {
+    pufu_executor_cleanup(exec);
+    return NULL;
+  }
+  return exec;
+}
+
+void pufu_executor_submit(PufuExecutor *exec, PufuNode *node) {
+  int target = node->worker;
+  if (target < 0 || target >= exec->count) {
+    target = exec->next;
+    exec->next = (exec->next + 1) % exec->count;
+  }
+  node->in_flight = 1;
+  exec->in_flight++;
+  exec->submitted++;
+  queue_push(&exec->workers[target], node);
+
+  pthread_mutex_lock(&exec->idle_lock);
+  exec->queued++;
+  pthread_cond_signal(&exec->idle);
+  pthread_mutex_unlock(&exec->idle_lock);
+}
+
+PufuNode *pufu_executor_reap(PufuExecutor *exec) {
+  uint64_t count;
+  if (read(exec->event_fd, &count, sizeof(count)) < 0)
+    count = 0; // EAGAIN: nothing finished since the last reap
+
+  pthread_mutex_lock(&exec->done_lock);
+  PufuNode *done = exec->done;
+  exec->done = NULL;
+  pthread_mutex_unlock(&exec->done_lock);
+
+  for (PufuNode *node = done; node; node = node->exec_next) {
+    node->in_flight = 0;
+    exec->in_flight--;
+  }
+  return done;
+}
+
+void pufu_executor_drain(PufuExecutor *exec) {
+  __atomic_store_n(&exec->hold, 1, __ATOMIC_RELEASE);
+  pthread_mutex_lock(&exec->done_lock);
+  while (exec->finished < exec->submitted)
+    pthread_cond_wait(&exec->drained, &exec->done_lock);
+  pthread_mutex_unlock(&exec->done_lock);
+  __atomic_store_n(&exec->hold, 0, __ATOMIC_RELEASE);
+}
+
+int pufu_executor_fd(const PufuExecutor *exec) { return exec->event_fd; }
+
+int pufu_executor_workers(const PufuExecutor *exec) { return exec->count; }
+
+int pufu_executor_in_flight(const PufuExecutor *exec) {
+  return exec->in_flight;
+}
+
+int pufu_executor_format_stats(const PufuExecutor *exec, char *buf,
+                               int size) {
+  int len = 0;
+  for (int i = 0; i < exec->count && len < size; i++) {
+    const PufuWorker *w = &exec->workers[i];
+    len += snprintf(buf + len, size - len,
+                    "worker %d: %lld turns, %lld steals\n", i,
+                    __atomic_load_n(&w->turns, __ATOMIC_RELAXED),
+                    __atomic_load_n(&w->steals, __ATOMIC_RELAXED));
+  }
+  return len;
+}
+
+void pufu_executor_cleanup(PufuExecutor *exec) {
+  if (!exec)
+    return;
+  pthread_mutex_lock(&exec->idle_lock);
+  exec->stop = 1;
+  pthread_cond_broadcast(&exec->idle);
+  pthread_mutex_unlock(&exec->idle_lock);
+  for (int i = 0; i < exec->count; i++)
+    pthread_join(exec->workers[i].thread, NULL);
+
+  for (int i = 0; i < exec->count; i++)
+    pthread_mutex_destroy(&exec->workers[i].lock);
+  pthread_mutex_destroy(&exec->idle_lock);
+  pthread_cond_destroy(&exec->idle);
+  pthread_mutex_destroy(&exec->done_lock);
+  pthread_cond_destroy(&exec->drained);
+  close(exec->event_fd);
+  free(exec->workers);
+  free(exec);
+}
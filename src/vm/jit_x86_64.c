@@ -0,0 +1,518 @@
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS
+#include "pufu/jit.h"
+#include "pufu/opcode.h"
+#include "pufu/socket.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <sys/mman.h>
+
+// Native block: runs from its loop head until it leaves the block or the
+// budget runs out, stores node->ip and returns the budget left.
+typedef int (*PufuJitFn)(PufuNode *node, int budget);
+
+struct PufuJit {
+  const PufuParser *parser; // Program the counters/code belong to
+  int count;                // Instructions in that program
+  int *hits;                // Taken back-edges per loop head
+  PufuJitFn *entry;         // Native code per loop head (NULL = none)
+  uint8_t *failed;          // Loop heads that could not be compiled
+
+  uint8_t *code; // mmap'd arena (RX, flipped to RW while emitting)
+  size_t used;
+
+  PufuSocket *socket;  // Socket the code was compiled against
+  int native_alu;      // socket advertises PUFU_SOCKET_CAP_NATIVE_ALU
+  PufuNodeSystem *sys; // For the syscall helper (set on every entry)
+
+  int blocks;
+  int invalidations;
+  long long entries;
+  long long native_insns;
+};
+
+// --- Code buffer ---
+
+typedef struct {
+  uint8_t buf[PUFU_JIT_MAX_BLOCK * 48 + 64];
+  int len;
+  int overflow;
+  int label[PUFU_JIT_MAX_BLOCK]; // Native offset per block instruction
+  struct {
+    int pos;    // rel32 to patch
+    int target; // Block index, or -1 for the epilogue
+  } fixups[PUFU_JIT_MAX_BLOCK * 2 + 4];
+  int fixup_count;
+} Emitter;
+
+static void emit8(Emitter *e, uint8_t byte) {
+  if (e->len >= (int)sizeof(e->buf)) {
+    e->overflow = 1;
+    return;
+  }
+  e->buf[e->len++] = byte;
+}
+
+static void emit_bytes(Emitter *e, const uint8_t *bytes, int n) {
+  for (int i = 0; i < n; i++)
+    emit8(e, bytes[i]);
+}
+
+static void emit32(Emitter *e, int32_t value) {
+  uint32_t v = (uint32_t)value;
+  for (int i = 0; i < 4; i++)
+    emit8(e, (uint8_t)(v >> (8 * i)));
+}
+
+static void emit64(Emitter *e, uint64_t value) {
+  for (int i = 0; i < 8; i++)
+    emit8(e, (uint8_t)(value >> (8 * i)));
+}
+
+// rel32 placeholder resolved once the whole block is emitted
+static void emit_fixup(Emitter *e, int target) {
+  int n = e->fixup_count;
+  if (n >= (int)(sizeof(e->fixups) / sizeof(e->fixups[0]))) {
+    e->overflow = 1;
+    return;
+  }
+  e->fixups[n].pos = e->len;
+  e->fixups[n].target = target;
+  e->fixup_count++;
+  emit32(e, 0);
+}
+
+// --- Templates (rbx = node, r12d = budget left) ---
+
+#define REG_DISP(r) ((int32_t)(offsetof(PufuNode, registers) + 4 * (r)))
+#define IP_DISP ((int32_t)offsetof(PufuNode, ip))
+#define CMP_DISP ((int32_t)offsetof(PufuNode, cmp_flag))
+
+static void emit_prologue(Emitter *e) {
+  static const uint8_t code[] = {
+      0x53,             // push rbx
+      0x41, 0x54,       // push r12
+      0x55,             // push rbp (keeps rsp 16-byte aligned for calls)
+      0x48, 0x89, 0xFB, // mov rbx, rdi
+      0x41, 0x89, 0xF4, // mov r12d, esi
+  };
+  emit_bytes(e, code, sizeof(code));
+}
+
+static void emit_epilogue(Emitter *e) {
+  static const uint8_t code[] = {
+      0x44, 0x89, 0xE0, // mov eax, r12d
+      0x5D,             // pop rbp
+      0x41, 0x5C,       // pop r12
+      0x5B,             // pop rbx
+      0xC3,             // ret
+  };
+  emit_bytes(e, code, sizeof(code));
+}
+
+// eax / ecx = operand value (same rules as get_operand_value)
+static void emit_load(Emitter *e, int ecx, int kind, int value) {
+  if (kind == PUFU_OPERAND_REG) {
+    emit8(e, 0x8B); // mov r32, [rbx+disp32]
+    emit8(e, ecx ? 0x8B : 0x83);
+    emit32(e, REG_DISP(value));
+  } else {
+    emit8(e, ecx ? 0xB9 : 0xB8); // mov r32, imm32
+    emit32(e, (kind == PUFU_OPERAND_IMM) ? value : 0);
+  }
+}
+
+static void emit_mov(Emitter *e, const PufuInstruction *inst) {
+  if (inst->a_kind != PUFU_OPERAND_REG)
+    return;
+  if (inst->b_kind == PUFU_OPERAND_REG) {
+    emit_load(e, 0, inst->b_kind, inst->b);
+    emit8(e, 0x89); // mov [rbx+disp32], eax
+    emit8(e, 0x83);
+    emit32(e, REG_DISP(inst->a));
+  } else {
+    emit8(e, 0xC7); // mov dword [rbx+disp32], imm32
+    emit8(e, 0x83);
+    emit32(e, REG_DISP(inst->a));
+    emit32(e, (inst->b_kind == PUFU_OPERAND_IMM) ? inst->b : 0);
+  }
+}
+
+// add/sub dword [reg a], operand b
+static void emit_arith(Emitter *e, const PufuInstruction *inst, int sub) {
+  if (inst->a_kind != PUFU_OPERAND_REG)
+    return;
+  if (inst->b_kind == PUFU_OPERAND_REG) {
+    emit_load(e, 1, inst->b_kind, inst->b);
+    emit8(e, sub ? 0x29 : 0x01); // add/sub [rbx+disp32], ecx
+    emit8(e, 0x8B);
+    emit32(e, REG_DISP(inst->a));
+  } else if (inst->b_kind == PUFU_OPERAND_IMM) {
+    emit8(e, 0x81); // add/sub dword [rbx+disp32], imm32
+    emit8(e, sub ? 0xAB : 0x83);
+    emit32(e, REG_DISP(inst->a));
+    emit32(e, inst->b);
+  }
+}
+
+// cmp_flag = (a > b) - (a < b)
+static void emit_cmp(Emitter *e, const PufuInstruction *inst) {
+  static const uint8_t code[] = {
+      0x31, 0xD2,       // xor edx, edx
+      0x39, 0xC8,       // cmp eax, ecx
+      0x0F, 0x9F, 0xC2, // setg dl
+      0x0F, 0x9C, 0xC0, // setl al
+      0x0F, 0xB6, 0xC0, // movzx eax, al
+      0x29, 0xC2,       // sub edx, eax
+      0x89, 0x93,       // mov [rbx+disp32], edx
+  };
+  emit_load(e, 0, inst->a_kind, inst->a);
+  emit_load(e, 1, inst->b_kind, inst->b);
+  emit_bytes(e, code, sizeof(code));
+  emit32(e, CMP_DISP);
+}
+
+// Charge the instructions run since the last flush against the budget
+static void emit_charge(Emitter *e, int *pending) {
+  if (*pending == 0)
+    return;
+  emit8(e, 0x41); // sub r12d, imm32
+  emit8(e, 0x81);
+  emit8(e, 0xEC);
+  emit32(e, *pending);
+  *pending = 0;
+}
+
+// node->ip = target; return to the interpreter
+static void emit_exit(Emitter *e, int target) {
+  emit8(e, 0xC7); // mov dword [rbx+disp32], imm32
+  emit8(e, 0x83);
+  emit32(e, IP_DISP);
+  emit32(e, target);
+  emit8(e, 0xE9); // jmp epilogue
+  emit_fixup(e, -1);
+}
+
+// Continue at `target`: stay native inside the block, exit otherwise.
+// Backward jumps only loop while budget is left.
+static void emit_goto(Emitter *e, int head, int end, int at, int target) {
+  if (target < head || target > end) {
+    emit_exit(e, target);
+    return;
+  }
+  if (target <= at) {
+    static const uint8_t test[] = {0x45, 0x85, 0xE4}; // test r12d, r12d
+    emit_bytes(e, test, sizeof(test));
+    emit8(e, 0x0F); // jg target
+    emit8(e, 0x8F);
+    emit_fixup(e, target - head);
+    emit_exit(e, target);
+  } else {
+    emit8(e, 0xE9); // jmp target
+    emit_fixup(e, target - head);
+  }
+}
+
+// Kernel syscall from native code. Returns 1 if the block must stop:
+// the syscall blocked/slept/exited, jumped, or swapped socket or program.
+static int jit_syscall(PufuNode *node) {
+  PufuJit *jit = node->jit;
+  int ip = node->ip;
+  pufu_node_syscall(jit->sys, node, &node->parser->instructions[ip]);
+  if (node->yielded || node->wake_time > 0 || !node->active)
+    return 1;
+  if (node->ip != ip + 1)
+    return 1;
+  return pufu_get_current_socket() != jit->socket ||
+         node->parser != jit->parser;
+}
+
+static void emit_syscall(Emitter *e, int at) {
+  static const uint8_t call[] = {
+      0x48, 0x89, 0xDF, // mov rdi, rbx
+      0x48, 0xB8,       // mov rax, imm64
+  };
+  static const uint8_t check[] = {
+      0xFF, 0xD0, // call rax
+      0x85, 0xC0, // test eax, eax
+      0x0F, 0x85, // jnz epilogue (node->ip set by the helper)
+  };
+  emit8(e, 0xC7); // mov dword [rbx+disp32], imm32
+  emit8(e, 0x83);
+  emit32(e, IP_DISP);
+  emit32(e, at);
+  emit_bytes(e, call, sizeof(call));
+  emit64(e, (uint64_t)(uintptr_t)jit_syscall);
+  emit_bytes(e, check, sizeof(check));
+  emit_fixup(e, -1);
+}
+
+// Superinstructions are compiled as their plain pair (ip + 1 is intact)
+static int base_opcode(int opcode) {
+  switch (opcode) {
+  case OP_CMP_BEQ:
+  case OP_CMP_BNE:
+  case OP_CMP_BLT:
+  case OP_CMP_BGT:
+    return OP_CMP;
+  case OP_MOV_ADD:
+  case OP_MOV_SYSCALL:
+    return OP_MOV;
+  default:
+    return opcode;
+  }
+}
+
+static int is_branch(int opcode) {
+  return opcode == OP_JMP || opcode == OP_BEQ || opcode == OP_BNE ||
+         opcode == OP_BLT || opcode == OP_BGT;
+}
+
+// Translate [head, end] (end = the back-edge branch)
+static int emit_block(Emitter *e, const PufuInstruction *code, int head,
+                      int end) {
+  uint8_t is_target[PUFU_JIT_MAX_BLOCK];
+  memset(is_target, 0, sizeof(is_target));
+  for (int i = head; i <= end; i++) {
+    if (is_branch(code[i].opcode) && code[i].a >= head && code[i].a <= end)
+      is_target[code[i].a - head] = 1;
+  }
+
+  emit_prologue(e);
+  int pending = 0;
+  for (int i = head; i <= end; i++) {
+    const PufuInstruction *inst = &code[i];
+    // Paths join here: settle the count so each path pays its own way
+    if (is_target[i - head])
+      emit_charge(e, &pending);
+    e->label[i - head] = e->len;
+    pending++;
+
+    switch (base_opcode(inst->opcode)) {
+    case OP_MOV:
+      emit_mov(e, inst);
+      break;
+    case OP_ADD:
+      emit_arith(e, inst, 0);
+      break;
+    case OP_SUB:
+      emit_arith(e, inst, 1);
+      break;
+    case OP_CMP:
+      emit_cmp(e, inst);
+      break;
+    case OP_JMP:
+      emit_charge(e, &pending);
+      emit_goto(e, head, end, i, inst->a);
+      break;
+    case OP_BEQ:
+    case OP_BNE:
+    case OP_BLT:
+    case OP_BGT: {
+      emit_charge(e, &pending);
+      int8_t want = (inst->opcode == OP_BLT) ? -1
+                    : (inst->opcode == OP_BGT) ? 1
+                                               : 0;
+      emit8(e, 0x83); // cmp dword [rbx+disp32], imm8
+      emit8(e, 0xBB);
+      emit32(e, CMP_DISP);
+      emit8(e, (uint8_t)want);
+      emit8(e, 0x0F); // branch not taken: skip the goto
+      emit8(e, (inst->opcode == OP_BNE) ? 0x84 : 0x85); // je / jne
+      int skip = e->len;
+      emit32(e, 0);
+      emit_goto(e, head, end, i, inst->a);
+      int32_t rel = e->len - (skip + 4);
+      memcpy(&e->buf[skip], &rel, sizeof(rel));
+      break;
+    }
+    case OP_SYSCALL:
+      emit_charge(e, &pending);
+      emit_syscall(e, i);
+      break;
+    default:
+      break; // NOP, MUL, DIV (not implemented by the VM either)
+    }
+  }
+  emit_charge(e, &pending);
+  emit_exit(e, end + 1);
+
+  int epilogue = e->len;
+  emit_epilogue(e);
+  if (e->overflow)
+    return -1;
+
+  for (int i = 0; i < e->fixup_count; i++) {
+    int target = e->fixups[i].target;
+    int dest = (target < 0) ? epilogue : e->label[target];
+    int32_t rel = dest - (e->fixups[i].pos + 4);
+    memcpy(&e->buf[e->fixups[i].pos], &rel, sizeof(rel));
+  }
+  return 0;
+}
+
+static PufuJitFn compile_block(PufuJit *jit, int head, int end) {
+  if (end < head || end - head + 1 > PUFU_JIT_MAX_BLOCK || end >= jit->count)
+    return NULL;
+
+  if (!jit->code) {
+    void *mem = mmap(NULL, PUFU_JIT_ARENA_SIZE, PROT_READ | PROT_EXEC,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+      return NULL;
+    jit->code = mem;
+    jit->used = 0;
+  }
+
+  Emitter *e = calloc(1, sizeof(Emitter));
+  if (!e)
+    return NULL;
+  if (emit_block(e, jit->parser->instructions, head, end) < 0 ||
+      jit->used + e->len > PUFU_JIT_ARENA_SIZE) {
+    free(e);
+    return NULL;
+  }
+
+  // W^X: the arena is only writable while a block is copied in
+  if (mprotect(jit->code, PUFU_JIT_ARENA_SIZE, PROT_READ | PROT_WRITE) < 0) {
+    free(e);
+    return NULL;
+  }
+  uint8_t *dest = jit->code + jit->used;
+  memcpy(dest, e->buf, e->len);
+  jit->used += (e->len + 15) & ~15;
+  mprotect(jit->code, PUFU_JIT_ARENA_SIZE, PROT_READ | PROT_EXEC);
+  free(e);
+
+  jit->blocks++;
+  PufuJitFn fn;
+  void *addr = dest;
+  memcpy(&fn, &addr, sizeof(fn));
+  return fn;
+}
+
+// Inline ALU only for sockets whose alu_* are plain integer math
+static int socket_native_alu(const PufuSocket *socket) {
+  return socket && socket->alu_add && socket->alu_sub && socket->alu_cmp &&
+         (socket->caps & PUFU_SOCKET_CAP_NATIVE_ALU);
+}
+
+PufuJit *pufu_jit_create(const PufuParser *parser) {
+  if (!parser || parser->count <= 0)
+    return NULL;
+  PufuJit *jit = calloc(1, sizeof(PufuJit));
+  if (!jit)
+    return NULL;
+  jit->parser = parser;
+  jit->count = parser->count;
+  jit->hits = calloc(parser->count, sizeof(int));
+  jit->entry = calloc(parser->count, sizeof(PufuJitFn));
+  jit->failed = calloc(parser->count, 1);
+  if (!jit->hits || !jit->entry || !jit->failed) {
+    pufu_jit_destroy(jit);
+    return NULL;
+  }
+  return jit;
+}
+
+void pufu_jit_destroy(PufuJit *jit) {
+  if (!jit)
+    return;
+  if (jit->code)
+    munmap(jit->code, PUFU_JIT_ARENA_SIZE);
+  free(jit->hits);
+  free(jit->entry);
+  free(jit->failed);
+  free(jit);
+}
+
+void pufu_jit_invalidate(PufuJit *jit) {
+  if (!jit)
+    return;
+  memset(jit->hits, 0, jit->count * sizeof(int));
+  memset(jit->entry, 0, jit->count * sizeof(PufuJitFn));
+  memset(jit->failed, 0, jit->count);
+  jit->used = 0;
+  jit->blocks = 0;
+  jit->invalidations++;
+}
+
+int pufu_jit_backedge(PufuJit *jit, PufuNodeSystem *sys, PufuNode *node,
+                      int from, int budget) {
+  if (!jit || node->parser != jit->parser || budget <= 0)
+    return 0;
+  int head = node->ip;
+  if (head < 0 || head >= jit->count)
+    return 0;
+
+  // A hot swapped socket may bring its own ALU: recompile (or stop)
+  PufuSocket *socket = pufu_get_current_socket();
+  if (socket != jit->socket) {
+    if (jit->blocks > 0)
+      pufu_jit_invalidate(jit);
+    jit->socket = socket;
+    jit->native_alu = socket_native_alu(socket);
+  }
+  if (!jit->native_alu)
+    return 0;
+
+  PufuJitFn fn = jit->entry[head];
+  if (!fn) {
+    if (jit->failed[head] || ++jit->hits[head] < PUFU_JIT_HOT_THRESHOLD)
+      return 0;
+    fn = compile_block(jit, head, from);
+    if (!fn) {
+      jit->failed[head] = 1;
+      return 0;
+    }
+    jit->entry[head] = fn;
+  }
+
+  jit->sys = sys;
+  int executed = budget - fn(node, budget);
+  jit->entries++;
+  jit->native_insns += executed;
+  return executed;
+}
+
+int pufu_jit_format_stats(const PufuJit *jit, char *buf, int size) {
+  if (!jit)
+    return snprintf(buf, size, "jit=off");
+  return snprintf(buf, size,
+                  "jit: blocks=%d code=%zuB entries=%lld native=%lld "
+                  "invalidations=%d",
+                  jit->blocks, jit->used, jit->entries, jit->native_insns,
+                  jit->invalidations);
+}
+
+#else // !__x86_64__: no JIT, the interpreter runs everything
+
+PufuJit *pufu_jit_create(const PufuParser *parser) {
+  (void)parser;
+  return NULL;
+}
+
+void pufu_jit_destroy(PufuJit *jit) { (void)jit; }
+
+void pufu_jit_invalidate(PufuJit *jit) { (void)jit; }
+
+int pufu_jit_backedge(PufuJit *jit, PufuNodeSystem *sys, PufuNode *node,
+                      int from, int budget) {
+  (void)jit;
+  (void)sys;
+  (void)node;
+  (void)from;
+  (void)budget;
+  return 0;
+}
+
+int pufu_jit_format_stats(const PufuJit *jit, char *buf, int size) {
+  (void)jit;
+  return snprintf(buf, size, "jit=off");
+}
+
+#endif // __x86_64__
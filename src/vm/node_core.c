@@ -1,5 +1,8 @@
+#include "pufu/jit.h"
 #include "pufu/loader.h"
 #include "pufu/node.h"
+#include "pufu/program.h"
+#include "pufu/slab.h"
 #include "pufu/terminal.h"
 #include "pufu/virtual_bus.h"
 #include <stdio.h>
@@ -9,14 +12,70 @@
 
 // --- Helpers ---
 
+// Virtual clock (ns); 0 while the real monotonic clock is in use. Relaxed
+// atomics: worker threads read it for their quantum deadlines.
+static long long virtual_ns = 0;
+
 long long get_time_ms() {
+  long long v = __atomic_load_n(&virtual_ns, __ATOMIC_RELAXED);
+  if (v)
+    return v / 1000000;
   struct timespec ts;
   clock_gettime(CLOCK_MONOTONIC, &ts);
   return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 }
 
+long long get_time_us(void) {
+  long long v = __atomic_load_n(&virtual_ns, __ATOMIC_RELAXED);
+  if (v)
+    return v / 1000;
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void pufu_clock_set_virtual(int enabled) {
+  __atomic_store_n(&virtual_ns, enabled ? PUFU_VIRTUAL_EPOCH_MS * 1000000 : 0,
+                   __ATOMIC_RELAXED);
+}
+
+int pufu_clock_is_virtual(void) {
+  return __atomic_load_n(&virtual_ns, __ATOMIC_RELAXED) != 0;
+}
+
+void pufu_clock_charge(int instructions) {
+  if (__atomic_load_n(&virtual_ns, __ATOMIC_RELAXED))
+    __atomic_fetch_add(&virtual_ns,
+                       (long long)instructions * PUFU_VIRTUAL_NS_PER_INSN,
+                       __ATOMIC_RELAXED);
+}
+
+void pufu_clock_advance_to(long long ms) {
+  long long target = ms * 1000000;
+  long long v = __atomic_load_n(&virtual_ns, __ATOMIC_RELAXED);
+  while (v && target > v &&
+         !__atomic_compare_exchange_n(&virtual_ns, &v, target, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+}
+
 int get_key(void) { return pufu_terminal_get_key(); }
 
+static int is_crystal_file(const char *filename) {
+  const char *dot = strrchr(filename, '.');
+  return dot && strcmp(dot, ".crystal") == 0;
+}
+
+// Control blocks and mailboxes come from slabs: a spawn that reuses a freed
+// node and fits its name inline does not call malloc at all
+static PufuSlab node_slab = PUFU_SLAB_INIT(sizeof(PufuNode), 32);
+static PufuSlab mailbox_slab = PUFU_SLAB_INIT(sizeof(PufuMailbox), 8);
+static long long mail_posted = 0;  // Messages queued, all mailboxes
+static long long mail_dropped = 0; // Posts refused (full, no memory)
+
+static PufuNode *create_node(const char *filename, int type_override,
+                             PufuProgram *program);
+
 // --- System Initialization ---
 
 PufuNodeSystem *pufu_node_system_init(void) {
@@ -27,6 +86,20 @@ PufuNodeSystem *pufu_node_system_init(void) {
   system->arbiter = NULL;
   system->nodes = NULL;
   system->bus = pufu_virtual_bus_init();
+  if (!system->bus || pufu_proc_table_init(&system->procs) < 0) {
+    pufu_virtual_bus_cleanup(system->bus);
+    free(system);
+    return NULL;
+  }
+  memset(&system->topics, 0, sizeof(system->topics));
+  memset(&system->rpc, 0, sizeof(system->rpc));
+  memset(system->ready, 0, sizeof(system->ready));
+  memset(system->class_stats, 0, sizeof(system->class_stats));
+  system->live_count = 0;
+  system->parked_count = 0;
+  system->zombie_count = 0;
+  system->reaped = 0;
+  system->exit_status = 0;
 
   pufu_log("pufu_so node parser initialized");
 
@@ -39,23 +112,26 @@ PufuNode *pufu_node_load(PufuNodeSystem *system, const char *filename) {
   if (!system)
     return NULL;
 
+  // Program image: parsed once per file, shared by every node spawned
+  // from it (Crystal nodes load their own netlist)
+  PufuProgram *program = NULL;
+  int type = -1;
+  if (!is_crystal_file(filename)) {
+    program = pufu_program_acquire(filename, -1);
+    if (!program)
+      return NULL;
+    type = program->type;
+  }
+
   // Create Node
-  PufuNode *node = pufu_create_node(filename, -1);
-  if (!node)
+  PufuNode *node = create_node(filename, type, program);
+  if (!node) {
+    pufu_program_release(program);
     return NULL;
+  }
 
   // Load Content
-  if (node->type == PUFU_NODE_ASSEMBLER ||
-      node->type == PUFU_NODE_TRINITY_SCENE) {
-    if (pufu_parse_file(node->parser, filename) < 0) {
-      printf("Error parsing file: %s\n", filename);
-      // Cleanup
-      pufu_parser_cleanup(node->parser);
-      free(node->filename);
-      free(node);
-      return NULL;
-    }
-  } else if (node->type == PUFU_NODE_CRYSTAL) {
+  if (node->type == PUFU_NODE_CRYSTAL) {
     // Crystal loading logic handled in init or we need a loader function
     // For now assume crystal init did enough or we need pufu_crystal_load
     // In legacy, crystal might load itself.
@@ -64,10 +140,163 @@ PufuNode *pufu_node_load(PufuNodeSystem *system, const char *filename) {
   // Add to list
   node->next = system->nodes;
   system->nodes = node;
+  pufu_proc_add(&system->procs, node);
+  system->live_count++;
+  pufu_node_ready(system, node);
 
   return node;
 }
 
+int pufu_node_parse_pid(const char *target) {
+  if (!*target)
+    return 0;
+  long pid = 0;
+  for (const char *p = target; *p; p++) {
+    if (*p < '0' || *p > '9' || pid > 0x7fffffff / 10)
+      return 0;
+    pid = pid * 10 + (*p - '0');
+  }
+  return (int)pid;
+}
+
+PufuNode *pufu_node_find(PufuNodeSystem *system, const char *target) {
+  int pid = pufu_node_parse_pid(target);
+  if (pid > 0)
+    return pufu_proc_find(&system->procs, pid);
+  PufuNode *node = pufu_proc_find_named(&system->procs, target);
+  while (node && !pufu_node_live(node))
+    node = pufu_proc_next_named(node);
+  return node;
+}
+
+void pufu_node_ready(PufuNodeSystem *system, PufuNode *node) {
+  if (node->run_state == PUFU_RUN_READY || node->run_state == PUFU_RUN_ZOMBIE)
+    return;
+  if (node->run_state == PUFU_RUN_PARKED)
+    system->parked_count--;
+  node->run_state = PUFU_RUN_READY;
+  node->ready_us = get_time_us();
+  PufuRunQueue *queue = &system->ready[node->sched_class];
+
+  // Interactive: earliest deadline first. Budgets are mostly equal, so it
+  // usually goes at the tail like everyone else.
+  if (node->sched_class == PUFU_CLASS_INTERACTIVE) {
+    node->deadline_us = node->ready_us + node->deadline_budget_us;
+    if (queue->tail && queue->tail->deadline_us > node->deadline_us) {
+      PufuNode **link = &queue->head; // Never past the tail
+      while ((*link)->deadline_us <= node->deadline_us)
+        link = &(*link)->run_next;
+      node->run_next = *link;
+      *link = node;
+      return;
+    }
+  }
+  node->run_next = NULL;
+  if (queue->tail)
+    queue->tail->run_next = node;
+  else
+    queue->head = node;
+  queue->tail = node;
+}
+
+void pufu_node_set_class(PufuNodeSystem *system, PufuNode *node,
+                         int sched_class) {
+  if (sched_class < 0 || sched_class >= PUFU_CLASS_COUNT ||
+      sched_class == node->sched_class)
+    return;
+  if (node->run_state != PUFU_RUN_READY) {
+    node->sched_class = sched_class;
+    return;
+  }
+  // Unlink from the old queue, then queue again under the new class
+  PufuRunQueue *queue = &system->ready[node->sched_class];
+  PufuNode *prev = NULL;
+  PufuNode **link = &queue->head;
+  while (*link != node) {
+    prev = *link;
+    link = &prev->run_next;
+  }
+  *link = node->run_next;
+  if (queue->tail == node)
+    queue->tail = prev;
+  node->sched_class = sched_class;
+  node->run_state = PUFU_RUN_IDLE;
+  pufu_node_ready(system, node);
+}
+
+static const char *class_names[PUFU_CLASS_COUNT] = {"interactive", "normal",
+                                                    "batch"};
+
+int pufu_node_parse_class(const char *name) {
+  for (int c = 0; c < PUFU_CLASS_COUNT; c++) {
+    if (strcmp(name, class_names[c]) == 0)
+      return c;
+  }
+  return -1;
+}
+
+const char *pufu_node_class_name(int sched_class) {
+  if (sched_class < 0 || sched_class >= PUFU_CLASS_COUNT)
+    return "?";
+  return class_names[sched_class];
+}
+
+void pufu_node_wake(PufuNodeSystem *system, PufuNode *node) {
+  if (node->run_state == PUFU_RUN_PARKED)
+    pufu_node_ready(system, node);
+}
+
+void pufu_node_stop(PufuNodeSystem *system, PufuNode *node) {
+  if (node->in_flight) { // Read by the worker between turns
+    __atomic_store_n(&node->stop_pending, 1, __ATOMIC_RELEASE);
+    return;
+  }
+  node->active = 0;
+  // Sleeping or parked: reaped next pass. A node stopping itself is still
+  // in its turn (IDLE) and the scheduler sees it right after.
+  if (node->run_state != PUFU_RUN_IDLE)
+    pufu_node_ready(system, node);
+}
+
+// Calls accepted by a server that is going away fail now instead of
+// waiting for their deadline
+static void fail_accepted_calls(PufuNodeSystem *system, PufuNode *server) {
+  for (int i = 0; i < server->accepted.count; i++) {
+    const PufuRpcRequest *request = &server->accepted.requests[i];
+    PufuNode *caller = pufu_proc_find(&system->procs, request->caller);
+    if (caller && caller->call_id == request->id &&
+        caller->call_state == PUFU_CALL_PENDING) {
+      caller->call_state = PUFU_CALL_FAILED;
+      system->rpc.failed++;
+      pufu_node_wake(system, caller);
+    }
+  }
+}
+
+int pufu_node_system_reap(PufuNodeSystem *system) {
+  int reaped = 0;
+  PufuNode **link = &system->nodes;
+  while (*link && system->zombie_count > 0) {
+    PufuNode *node = *link;
+    if (node->run_state != PUFU_RUN_ZOMBIE) {
+      link = &node->next;
+      continue;
+    }
+    *link = node->next;
+    if (system->arbiter == node) {
+      system->exit_status = node->exit_code;
+      system->arbiter = NULL;
+    }
+    fail_accepted_calls(system, node);
+    pufu_proc_remove(&system->procs, node);
+    system->zombie_count--;
+    pufu_node_destroy(node);
+    reaped++;
+  }
+  system->reaped += reaped;
+  return reaped;
+}
+
 int pufu_node_set_arbiter(PufuNodeSystem *system, PufuNode *node) {
   if (!system || !node)
     return -1;
@@ -79,13 +308,65 @@ int pufu_node_set_arbiter(PufuNodeSystem *system, PufuNode *node) {
   return 0;
 }
 
+int pufu_node_system_format_stats(PufuNodeSystem *system, char *buf,
+                                  int size) {
+  int len = snprintf(buf, size,
+                     "nodes: live=%d parked=%d zombies=%d reaped=%lld "
+                     "slab=%d/%d mailboxes=%d mail=%lld dropped=%lld ",
+                     system->live_count, system->parked_count,
+                     system->zombie_count, system->reaped, node_slab.in_use,
+                     pufu_slab_capacity(&node_slab), mailbox_slab.in_use,
+                     mail_posted, mail_dropped);
+  if (len < 0 || len >= size)
+    return len;
+  len += pufu_virtual_bus_format_stats(system->bus, buf + len, size - len);
+  if (len >= size - 1)
+    return len;
+  buf[len++] = ' ';
+  len += pufu_shm_format_stats(buf + len, size - len);
+  if (len >= size - 1)
+    return len;
+  buf[len++] = ' ';
+  len += pufu_topic_format_stats(&system->topics, buf + len, size - len);
+  if (len >= size - 1)
+    return len;
+  buf[len++] = ' ';
+  return len + pufu_rpc_format_stats(&system->rpc, buf + len, size - len);
+}
+
+// Upper bound of the bucket holding the p99 turn
+static long long p99_us(const PufuClassStats *stats) {
+  long long seen = 0;
+  for (int b = 0; b < PUFU_LATENCY_BUCKETS; b++) {
+    seen += stats->histogram[b];
+    if (seen * 100 >= stats->turns * 99)
+      return 1LL << b;
+  }
+  return stats->max_us;
+}
+
+int pufu_node_system_format_class_stats(PufuNodeSystem *system, char *buf,
+                                        int size) {
+  int len = 0;
+  for (int c = 0; c < PUFU_CLASS_COUNT && len < size; c++) {
+    const PufuClassStats *stats = &system->class_stats[c];
+    len += snprintf(buf + len, size - len,
+                    "%s%s: %lld turns avg=%lldus p99<%lldus max=%lldus",
+                    c ? " | " : "", class_names[c], stats->turns,
+                    stats->turns ? stats->total_us / stats->turns : 0,
+                    stats->turns ? p99_us(stats) : 0, stats->max_us);
+    if (c == PUFU_CLASS_INTERACTIVE && len < size)
+      len += snprintf(buf + len, size - len, " missed=%lld", stats->missed);
+  }
+  return len;
+}
+
 // --- Node Factory ---
 
 // Detectar tipo de nodo usando Magic Header
-static PufuNodeType detect_node_type(const char *filename) {
+PufuNodeType pufu_node_detect_type(const char *filename) {
   // 1. Extension Check
-  const char *dot = strrchr(filename, '.');
-  if (dot && strcmp(dot, ".crystal") == 0) {
+  if (is_crystal_file(filename)) {
     return PUFU_NODE_CRYSTAL;
   }
 
@@ -108,26 +389,57 @@ static PufuNodeType detect_node_type(const char *filename) {
   return PUFU_NODE_ASSEMBLER;
 }
 
-PufuNode *pufu_create_node(const char *filename, int type_override) {
-  PufuNode *node = malloc(sizeof(PufuNode));
+static void release_node(PufuNode *node) {
+  if (node->filename != node->name_buf)
+    free(node->filename);
+  pufu_shm_refs_clear(&node->shm);
+  pufu_rpc_accepted_clear(&node->accepted);
+  pufu_mailbox_cleanup(node->mailbox);
+  pufu_slab_free(&mailbox_slab, node->mailbox);
+  pufu_slab_free(&node_slab, node);
+}
+
+// `program` given: the node runs that shared image and needs no parser of
+// its own, nor a reload watcher (reloads are tracked per image)
+static PufuNode *create_node(const char *filename, int type_override,
+                             PufuProgram *program) {
+  PufuNode *node = pufu_slab_alloc(&node_slab);
   if (!node)
     return NULL;
 
-  node->filename = strdup(filename);
-  if (!node->filename) {
-    free(node);
-    return NULL;
+  size_t len = strlen(filename);
+  if (len < sizeof(node->name_buf)) {
+    memcpy(node->name_buf, filename, len + 1);
+    node->filename = node->name_buf;
+  } else {
+    node->filename = strdup(filename);
+    if (!node->filename) {
+      pufu_slab_free(&node_slab, node);
+      return NULL;
+    }
   }
 
+  node->pid = 0;
+  node->name_hash = 0;
+  node->pid_next = NULL;
+  node->name_next = NULL;
   node->type = (type_override != -1) ? (PufuNodeType)type_override
-                                     : detect_node_type(filename);
+                                     : pufu_node_detect_type(filename);
   node->parser = NULL;
   node->crystal = NULL;
   node->body = NULL;
   node->reload = NULL;
+  node->mailbox = NULL;
+  memset(&node->shm, 0, sizeof(node->shm));
+  memset(&node->accepted, 0, sizeof(node->accepted));
+  node->call_id = 0;
+  node->call_state = 0;
+  node->program = program;
 
   // Configuration based on Type
-  if (node->type == PUFU_NODE_ASSEMBLER) {
+  if (program) {
+    node->parser = program->parser;
+  } else if (node->type == PUFU_NODE_ASSEMBLER) {
     node->parser = pufu_parser_init();
   } else if (node->type == PUFU_NODE_CRYSTAL) {
     node->crystal = pufu_crystal_init();
@@ -141,46 +453,207 @@ PufuNode *pufu_create_node(const char *filename, int type_override) {
   if ((node->type == PUFU_NODE_ASSEMBLER ||
        node->type == PUFU_NODE_TRINITY_SCENE) &&
       !node->parser) {
-    free(node->filename);
-    free(node);
+    release_node(node);
     return NULL;
   }
   if (node->type == PUFU_NODE_CRYSTAL && !node->crystal) {
-    free(node->filename);
-    free(node);
+    pufu_parser_cleanup(node->parser);
+    release_node(node);
     return NULL;
   }
 
-  // Hot Reload is always useful
-  node->reload = pufu_hot_reload_init(filename);
+  // Hot Reload for nodes that own their code (shared images watch their
+  // source themselves, see pufu_program_watch_fd)
+  if (!program)
+    node->reload = pufu_hot_reload_init(filename);
 
   node->next = NULL;
   node->is_arbiter = 0;
+  node->exit_code = 0;
   node->loop_counter = 0;
   node->ip = 0;
   node->active = 1;
   node->wake_time = 0;
+  node->wait_sources = 0;
+  node->wait_deadline = 0;
   node->cmp_flag = 0;
-  node->input_pos = 0;
   memset(node->registers, 0, sizeof(node->registers));
   memset(node->input_buffer, 0, sizeof(node->input_buffer));
   node->input_pos = 0;
+  node->args[0] = '\0';
 
   // Default TWS to active one (or 0)
   // extern int pufu_tws_get_active(void); // Forward decl or include terminal.h
   // Removed extern implicit because terminal.h is included
   node->tws_id = pufu_tws_get_active();
 
-  // IPC Queue Init
-  node->ipc_head = 0;
-  node->ipc_tail = 0;
-  node->ipc_count = 0;
+  node->mailbox_capacity = PUFU_MAILBOX_DEFAULT_CAPACITY;
+
+  // Scheduling
+  node->quantum = PUFU_DEFAULT_QUANTUM;
+  node->quantum_us = PUFU_DEFAULT_QUANTUM_US;
+  node->yielded = PUFU_YIELD_NONE;
+  memset(&node->timer, 0, sizeof(node->timer));
+  node->watched = 0;
+  node->run_state = PUFU_RUN_IDLE;
+  node->run_next = NULL;
+  node->sched_class = PUFU_CLASS_NORMAL;
+  node->deadline_budget_us = PUFU_INTERACTIVE_DEADLINE_US;
+  node->ready_us = 0;
+  node->deadline_us = 0;
+  node->spin_pass = -1;
+  node->on_workers = 0;
+  node->in_flight = 0;
+  node->worker = -1;
+  node->stop_pending = 0;
+  node->jit_stale = 0;
+  node->exec_next = NULL;
+  memset(&node->stats, 0, sizeof(node->stats));
+  node->jit = NULL; // Created on the first hot loop (JIT builds)
 
   return node;
 }
 
+PufuNode *pufu_create_node(const char *filename, int type_override) {
+  return create_node(filename, type_override, NULL);
+}
+
+// Allocated on the first message; NULL if out of memory
+static PufuMailbox *ensure_mailbox(PufuNode *target) {
+  if (!target->mailbox) {
+    target->mailbox = pufu_slab_alloc(&mailbox_slab);
+    if (!target->mailbox ||
+        pufu_mailbox_init(target->mailbox, target->mailbox_capacity) < 0) {
+      pufu_slab_free(&mailbox_slab, target->mailbox);
+      target->mailbox = NULL;
+    }
+  }
+  return target->mailbox;
+}
+
+static int count_post(int result) {
+  if (result == PUFU_MAIL_OK)
+    mail_posted++;
+  else
+    mail_dropped++;
+  return result;
+}
+
+int pufu_node_post(PufuNode *target, const char *sender, const char *content,
+                   int type) {
+  PufuMailbox *mailbox = ensure_mailbox(target);
+  return count_post(mailbox ? pufu_mailbox_post(mailbox, sender, content, type)
+                            : PUFU_MAIL_NO_MEMORY);
+}
+
+static int post_shared(PufuNode *target, const char *sender,
+                       PufuMailPayload *payload, int type) {
+  PufuMailbox *mailbox = ensure_mailbox(target);
+  return count_post(mailbox ? pufu_mailbox_post_shared(mailbox, sender,
+                                                       payload, type)
+                            : PUFU_MAIL_NO_MEMORY);
+}
+
+int pufu_node_publish(PufuNodeSystem *system, PufuNode *sender,
+                      const char *topic, const char *content,
+                      int *delivered) {
+  PufuTopicTable *table = &system->topics;
+  PufuTopic *t = pufu_topic_find(table, topic);
+  *delivered = 0;
+
+  // Drop subscribers that exited (PIDs are never reused), then all or
+  // nothing: one full mailbox holds the message back, so every subscriber
+  // sees the same sequence
+  int i = 0;
+  while (t && i < t->count) {
+    PufuNode *node = pufu_proc_find(&system->procs, t->pids[i]);
+    if (!node || !pufu_node_live(node)) {
+      if (pufu_topic_remove_at(table, t, i))
+        t = NULL;
+      continue;
+    }
+    if (node != sender && node->mailbox &&
+        pufu_mailbox_count(node->mailbox) >= node->mailbox->capacity) {
+      table->refused++;
+      return PUFU_MAIL_FULL;
+    }
+    i++;
+  }
+  table->published++;
+  if (!t) {
+    table->unheard++;
+    return PUFU_MAIL_OK;
+  }
+
+  char text[PUFU_MAIL_CONTENT_MAX + 1];
+  snprintf(text, sizeof(text), "%s:%s", topic, content);
+  PufuMailPayload *payload = pufu_mail_payload_create(text);
+  if (!payload)
+    return PUFU_MAIL_NO_MEMORY;
+  for (i = 0; i < t->count; i++) {
+    PufuNode *node = pufu_proc_find(&system->procs, t->pids[i]);
+    if (node != sender &&
+        post_shared(node, sender->filename, payload, 5) == PUFU_MAIL_OK) {
+      pufu_node_wake(system, node);
+      (*delivered)++;
+    }
+  }
+  table->delivered += *delivered;
+  pufu_mail_payload_release(payload);
+  return PUFU_MAIL_OK;
+}
+
+int pufu_node_broadcast(PufuNodeSystem *system, PufuNode *sender,
+                        const char *content) {
+  PufuMailPayload *payload = pufu_mail_payload_create(content);
+  if (!payload)
+    return system->live_count;
+  int refused = 0;
+  for (PufuNode *t = system->nodes; t; t = t->next) {
+    if (t == sender || !pufu_node_live(t))
+      continue;
+    if (post_shared(t, sender->filename, payload, 2) == PUFU_MAIL_OK)
+      pufu_node_wake(system, t);
+    else
+      refused++;
+  }
+  pufu_mail_payload_release(payload);
+  return refused;
+}
+
+// Bus route of a subscriber node, keyed by PID: a node that exited is no
+// longer in the process table and its routes are dropped
+static int deliver_signal(void *ctx, int pid, const PufuSignal *signal) {
+  PufuNodeSystem *system = ctx;
+  PufuNode *node = pufu_proc_find(&system->procs, pid);
+  if (!node || !pufu_node_live(node))
+    return -1;
+  char content[PUFU_MAIL_CONTENT_MAX + 1];
+  pufu_signal_format(signal, content, sizeof(content));
+  if (pufu_node_post(node, "VirtualBus", content, 3) != PUFU_MAIL_OK)
+    return 1;
+  pufu_node_wake(system, node);
+  return 0;
+}
+
+int pufu_node_subscribe(PufuNodeSystem *system, PufuNode *node, uint16_t id) {
+  return pufu_virtual_bus_route(system->bus, id, deliver_signal, system,
+                                node->pid);
+}
+
 // --- System Cleanup ---
 
+void pufu_node_destroy(PufuNode *node) {
+  pufu_hot_reload_cleanup(node->reload);
+  pufu_jit_destroy(node->jit);
+  pufu_crystal_cleanup(node->crystal);
+  if (node->program)
+    pufu_program_release(node->program); // Shared image
+  else
+    pufu_parser_cleanup(node->parser);
+  release_node(node);
+}
+
 void pufu_node_system_cleanup(PufuNodeSystem *system) {
   if (!system)
     return;
@@ -188,10 +661,7 @@ void pufu_node_system_cleanup(PufuNodeSystem *system) {
   PufuNode *current = system->nodes;
   while (current) {
     PufuNode *next = current->next;
-    pufu_hot_reload_cleanup(current->reload);
-    pufu_parser_cleanup(current->parser);
-    free(current->filename);
-    free(current);
+    pufu_node_destroy(current);
     current = next;
   }
 
@@ -199,6 +669,8 @@ void pufu_node_system_cleanup(PufuNodeSystem *system) {
   extern void trinity_shutdown(void);
   trinity_shutdown();
 
+  pufu_topic_table_cleanup(&system->topics);
+  pufu_proc_table_cleanup(&system->procs);
   pufu_virtual_bus_cleanup(system->bus);
   free(system);
 }
@@ -1,5 +1,7 @@
 #include "pufu/crystal.h"
 #include "pufu/hot_reload.h" // For system_check
+#include "pufu/jit.h"
+#include "pufu/program.h"
 #include "pufu/node.h"
 #include "pufu/socket.h"
 #include "pufu/syscalls.h"
@@ -23,181 +25,463 @@ int get_value(PufuNode *node, const char *str) {
   return atoi(str);
 }
 
-int find_label(PufuNode *node, const char *label) {
-  if (!node->parser)
-    return -1;
+// Decoded operands (filled by the parser): no atoi in the hot path
+int get_operand_reg(int kind, int value) {
+  return (kind == PUFU_OPERAND_REG) ? value : -1;
+}
 
-  // OPTIMIZED LOOKUP: Use Label Index
-  if (node->parser->labels) {
-    for (int i = 0; i < node->parser->label_count; i++) {
-      if (strcmp(node->parser->labels[i].name, label) == 0) {
-        return node->parser->labels[i].index;
-      }
-    }
+int get_operand_value(PufuNode *node, int kind, int value) {
+  if (kind == PUFU_OPERAND_REG)
+    return node->registers[value];
+  if (kind == PUFU_OPERAND_IMM)
+    return value;
+  return 0;
+}
+
+// Syscall argument as text (from the program string pool)
+const char *get_string_arg(PufuNode *node, PufuInstruction *inst) {
+  if (inst->b_kind != PUFU_OPERAND_STR)
+    return "";
+  return pufu_parser_string(node->parser, inst->b);
+}
+
+// Syscall slow path: kernel dispatch, then the socket text fallback
+void pufu_node_syscall(PufuNodeSystem *sys, PufuNode *node,
+                       PufuInstruction *inst) {
+  // Check Dispatch
+  if (pufu_syscall_dispatch(sys, node, inst))
+    return;
+
+  // Fallback to ARM Socket text exec for unknown syscalls?
+  // "syscall name arg1"
+  char code[256];
+  snprintf(code, sizeof(code), "syscall %s",
+           pufu_parser_string(node->parser, inst->c));
+  if (inst->b_kind == PUFU_OPERAND_STR) {
+    strncat(code, " ", 255 - strlen(code));
+    strncat(code, get_string_arg(node, inst), 255 - strlen(code));
   }
-  return -1;
+  PufuSocket *socket = pufu_get_current_socket();
+  if (socket && socket->execute) {
+    socket->execute(code);
+  }
+  node->ip++;
 }
 
-// Ejecutar un nodo (un paso)
-int pufu_node_execute(PufuNodeSystem *sys, PufuNode *node) {
-  if (!node || !node->active)
-    return 0;
+// --- Instruction bodies (shared by both dispatch engines) ---
 
-  // Verificar si está durmiendo
-  if (node->wake_time > 0) {
-    if (get_time_ms() < node->wake_time) {
-      return 1; // Sigue durmiendo
-    }
-    node->wake_time = 0; // Despertar
+static inline void op_mov(PufuNode *node, const PufuInstruction *inst) {
+  int reg = get_operand_reg(inst->a_kind, inst->a);
+  if (reg >= 0)
+    node->registers[reg] = get_operand_value(node, inst->b_kind, inst->b);
+}
+
+static inline void op_add(PufuNode *node, PufuSocket *socket,
+                          const PufuInstruction *inst) {
+  int reg = get_operand_reg(inst->a_kind, inst->a);
+  if (reg >= 0 && socket && socket->alu_add) {
+    int src = get_operand_value(node, inst->b_kind, inst->b);
+    node->registers[reg] = socket->alu_add(node->registers[reg], src);
   }
+}
 
-  if (node->type == PUFU_NODE_ASSEMBLER ||
-      node->type == PUFU_NODE_TRINITY_SCENE) {
-    if (!node->parser || node->ip >= node->parser->count) {
-      node->active = 0;
+static inline void op_sub(PufuNode *node, PufuSocket *socket,
+                          const PufuInstruction *inst) {
+  int reg = get_operand_reg(inst->a_kind, inst->a);
+  if (reg >= 0 && socket && socket->alu_sub) {
+    int src = get_operand_value(node, inst->b_kind, inst->b);
+    node->registers[reg] = socket->alu_sub(node->registers[reg], src);
+  }
+}
+
+static inline void op_cmp(PufuNode *node, PufuSocket *socket,
+                          const PufuInstruction *inst) {
+  int v1 = get_operand_value(node, inst->a_kind, inst->a);
+  int v2 = get_operand_value(node, inst->b_kind, inst->b);
+  if (socket && socket->alu_cmp) {
+    node->cmp_flag = socket->alu_cmp(v1, v2);
+  }
+}
+
+// Branch targets are resolved at load time (pufu_parser_link)
+static inline int branch_taken(int opcode, int cmp_flag) {
+  switch (opcode) {
+  case OP_BEQ:
+    return cmp_flag == 0;
+  case OP_BNE:
+    return cmp_flag != 0;
+  case OP_BLT:
+    return cmp_flag == -1;
+  case OP_BGT:
+    return cmp_flag == 1;
+  default:
+    return 1; // OP_JMP
+  }
+}
+
+// Sleep, blocking I/O, exit and exec all end the slice
+static inline int syscall_ends_slice(PufuNode *node) {
+  return node->yielded || node->wake_time > 0 || !node->active;
+}
+
+#ifdef PUFU_JIT
+// Taken backward branch at `from`: hand the loop to the JIT once it is hot
+static inline int jit_backedge(PufuNodeSystem *sys, PufuNode *node, int from,
+                               int budget) {
+  if (!node->jit) {
+    node->jit = pufu_jit_create(node->parser);
+    if (!node->jit)
       return 0;
+  }
+  return pufu_jit_backedge(node->jit, sys, node, from, budget);
+}
+
+#define JIT_BACKEDGE(from)                                                     \
+  do {                                                                         \
+    if (sys && node->ip <= (from) && executed < budget) {                      \
+      int native = jit_backedge(sys, node, (from), budget - executed);         \
+      if (native > 0) {                                                        \
+        executed += native;                                                    \
+        if (syscall_ends_slice(node))                                          \
+          goto slice_end;                                                      \
+        socket = pufu_get_current_socket();                                    \
+      }                                                                        \
+    }                                                                          \
+  } while (0)
+#else
+#define JIT_BACKEDGE(from) (void)(from)
+#endif
+
+static void end_slice(PufuNode *node, int executed, int expired) {
+  if (expired)
+    node->stats.quantum_expired++;
+  if (node->yielded || node->wake_time > 0)
+    node->stats.yields++;
+  node->stats.turns++;
+  node->stats.instructions += executed;
+  node->stats.last_turn = executed;
+  pufu_clock_charge(executed);
+}
+
+// Run one time slice: up to node->quantum instructions or node->quantum_us
+// microseconds, stopping early when the node sleeps, yields or exits.
+// Superinstructions count as the two instructions they replace.
+
+#ifdef PUFU_JIT
+#define ENGINE_SUFFIX "+jit"
+#else
+#define ENGINE_SUFFIX ""
+#endif
+
+#ifdef PUFU_THREADED_DISPATCH
+
+const char *pufu_node_engine(void) { return "threaded" ENGINE_SUFFIX; }
+
+// Direct-threaded engine: each handler jumps straight to the next one
+// through a label table (GCC computed goto), no central switch.
+static void run_slice(PufuNodeSystem *sys, PufuNode *node) {
+// Unknown opcodes default to NOP, then the real handlers override them
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+  static void *dispatch[256] = {
+      [0 ... 255] = &&do_nop,
+      [OP_MOV] = &&do_mov,
+      [OP_ADD] = &&do_add,
+      [OP_SUB] = &&do_sub,
+      [OP_CMP] = &&do_cmp,
+      [OP_JMP] = &&do_jmp,
+      [OP_BEQ] = &&do_branch,
+      [OP_BNE] = &&do_branch,
+      [OP_BLT] = &&do_branch,
+      [OP_BGT] = &&do_branch,
+      [OP_SYSCALL] = &&do_syscall,
+      [OP_CMP_BEQ] = &&do_cmp_beq,
+      [OP_CMP_BNE] = &&do_cmp_bne,
+      [OP_CMP_BLT] = &&do_cmp_blt,
+      [OP_CMP_BGT] = &&do_cmp_bgt,
+      [OP_MOV_ADD] = &&do_mov_add,
+      [OP_MOV_SYSCALL] = &&do_mov_syscall,
+  };
+#pragma GCC diagnostic pop
+  PufuInstruction *code = node->parser->instructions;
+  int count = node->parser->count;
+  int budget = (node->quantum > 0) ? node->quantum : 1;
+  long long deadline =
+      (node->quantum_us > 0) ? get_time_us() + node->quantum_us : 0;
+  int next_check = 64;
+  PufuSocket *socket = pufu_get_current_socket();
+  PufuInstruction *inst;
+  int executed = 0;
+  int expired = 0;
+  int from; // Branch source, for back-edge detection
+
+  node->yielded = PUFU_YIELD_NONE;
+
+// Account for n instructions, then jump to the handler at node->ip
+#define NEXT(n)                                                                \
+  do {                                                                         \
+    executed += (n);                                                           \
+    goto dispatch_next;                                                        \
+  } while (0)
+
+dispatch_next:
+  if (executed >= budget) {
+    expired = 1;
+    goto slice_end;
+  }
+  // Time budget is checked every 64 instructions to keep the loop tight
+  if (deadline && executed >= next_check) {
+    next_check = executed + 64;
+    if (get_time_us() >= deadline) {
+      expired = 1;
+      goto slice_end;
     }
+  }
+  if (node->ip >= count) {
+    node->active = 0;
+    goto slice_end;
+  }
+  inst = &code[node->ip];
+  goto *dispatch[inst->opcode];
+
+do_nop:
+  node->ip++;
+  NEXT(1);
+
+do_mov:
+  op_mov(node, inst);
+  node->ip++;
+  NEXT(1);
+
+do_add:
+  op_add(node, socket, inst);
+  node->ip++;
+  NEXT(1);
 
-    PufuInstruction *inst = &node->parser->instructions[node->ip];
-    char code[256];
+do_sub:
+  op_sub(node, socket, inst);
+  node->ip++;
+  NEXT(1);
+
+do_cmp:
+  op_cmp(node, socket, inst);
+  node->ip++;
+  NEXT(1);
+
+do_jmp:
+  from = node->ip;
+  node->ip = inst->a;
+  JIT_BACKEDGE(from);
+  NEXT(1);
+
+do_branch:
+  from = node->ip;
+  node->ip =
+      branch_taken(inst->opcode, node->cmp_flag) ? inst->a : node->ip + 1;
+  JIT_BACKEDGE(from);
+  NEXT(1);
+
+do_cmp_beq:
+  op_cmp(node, socket, inst);
+  from = node->ip + 1;
+  node->ip = (node->cmp_flag == 0) ? inst[1].a : node->ip + 2;
+  JIT_BACKEDGE(from);
+  NEXT(2);
+
+do_cmp_bne:
+  op_cmp(node, socket, inst);
+  from = node->ip + 1;
+  node->ip = (node->cmp_flag != 0) ? inst[1].a : node->ip + 2;
+  JIT_BACKEDGE(from);
+  NEXT(2);
+
+do_cmp_blt:
+  op_cmp(node, socket, inst);
+  from = node->ip + 1;
+  node->ip = (node->cmp_flag == -1) ? inst[1].a : node->ip + 2;
+  JIT_BACKEDGE(from);
+  NEXT(2);
+
+do_cmp_bgt:
+  op_cmp(node, socket, inst);
+  from = node->ip + 1;
+  node->ip = (node->cmp_flag == 1) ? inst[1].a : node->ip + 2;
+  JIT_BACKEDGE(from);
+  NEXT(2);
+
+do_mov_add:
+  op_mov(node, inst);
+  op_add(node, socket, &inst[1]);
+  node->ip += 2;
+  NEXT(2);
+
+do_mov_syscall:
+  op_mov(node, inst);
+  node->ip++;
+  executed++;
+  inst++;
+  // fall through into the syscall at ip + 1
+
+do_syscall:
+  if (!sys) { // Worker thread: the main thread runs the syscall
+    node->yielded = PUFU_YIELD_SYSCALL;
+    goto slice_end;
+  }
+  executed++;
+  pufu_node_syscall(sys, node, inst);
+  if (syscall_ends_slice(node))
+    goto slice_end;
+  // Syscalls may hot swap the socket (system_update)
+  socket = pufu_get_current_socket();
+  NEXT(0);
+
+#undef NEXT
+
+slice_end:
+  end_slice(node, executed, expired);
+}
+
+#else
+
+const char *pufu_node_engine(void) { return "switch" ENGINE_SUFFIX; }
+
+static void run_slice(PufuNodeSystem *sys, PufuNode *node) {
+  PufuInstruction *code = node->parser->instructions;
+  int count = node->parser->count;
+  int budget = (node->quantum > 0) ? node->quantum : 1;
+  long long deadline =
+      (node->quantum_us > 0) ? get_time_us() + node->quantum_us : 0;
+  int next_check = 64;
+  PufuSocket *socket = pufu_get_current_socket();
+  int executed = 0;
+  int expired = 0;
+
+  node->yielded = PUFU_YIELD_NONE;
+  while (executed < budget) {
+    if (node->ip >= count) {
+      node->active = 0;
+      goto slice_end;
+    }
+    PufuInstruction *inst = &code[node->ip];
+    executed++;
 
     // OPTIMIZED VM: Switch by Opcode
     switch (inst->opcode) {
-    case OP_MOV: {
-      int reg = get_reg_index(inst->reg1);
-      if (reg >= 0) {
-        const char *src = inst->reg2[0] ? inst->reg2 : inst->value;
-        node->registers[reg] = get_value(node, src);
-      }
+    case OP_MOV:
+      op_mov(node, inst);
       node->ip++;
-      return 1;
-    }
+      break;
 
-    case OP_ADD: {
-      int reg = get_reg_index(inst->reg1);
-      if (reg >= 0) {
-        const char *src = inst->reg2[0] ? inst->reg2 : inst->value;
-        PufuSocket *socket = pufu_get_current_socket();
-        if (socket && socket->alu_add) {
-          node->registers[reg] =
-              socket->alu_add(node->registers[reg], get_value(node, src));
-        }
-      }
+    case OP_ADD:
+      op_add(node, socket, inst);
       node->ip++;
-      return 1;
-    }
+      break;
 
-    case OP_SUB: {
-      int reg = get_reg_index(inst->reg1);
-      if (reg >= 0) {
-        const char *src = inst->reg2[0] ? inst->reg2 : inst->value;
-        PufuSocket *socket = pufu_get_current_socket();
-        if (socket && socket->alu_sub) {
-          node->registers[reg] =
-              socket->alu_sub(node->registers[reg], get_value(node, src));
-        }
-      }
+    case OP_SUB:
+      op_sub(node, socket, inst);
       node->ip++;
-      return 1;
-    }
+      break;
 
-    case OP_CMP: {
-      int v1 = get_value(node, inst->reg1);
-      const char *src = inst->reg2[0] ? inst->reg2 : inst->value;
-      int v2 = get_value(node, src);
-      PufuSocket *socket = pufu_get_current_socket();
-      if (socket && socket->alu_cmp) {
-        node->cmp_flag = socket->alu_cmp(v1, v2);
-      }
+    case OP_CMP:
+      op_cmp(node, socket, inst);
       node->ip++;
-      return 1;
-    }
+      break;
 
-    case OP_JMP: {
-      int target = find_label(node, inst->reg1);
-      if (target >= 0)
-        node->ip = target;
-      else
-        node->ip++;
-      return 1;
+    case OP_JMP:
+    case OP_BEQ:
+    case OP_BNE:
+    case OP_BLT:
+    case OP_BGT: {
+      int from = node->ip;
+      node->ip =
+          branch_taken(inst->opcode, node->cmp_flag) ? inst->a : node->ip + 1;
+      JIT_BACKEDGE(from);
+      break;
     }
 
-    case OP_BEQ: {
-      if (node->cmp_flag == 0) {
-        int target = find_label(node, inst->reg1);
-        if (target >= 0) {
-          node->ip = target;
-          return 1;
-        }
-      }
-      node->ip++;
-      return 1;
+    case OP_CMP_BEQ:
+    case OP_CMP_BNE:
+    case OP_CMP_BLT:
+    case OP_CMP_BGT: {
+      int from = node->ip + 1;
+      op_cmp(node, socket, inst);
+      node->ip = branch_taken(inst[1].opcode, node->cmp_flag) ? inst[1].a
+                                                              : node->ip + 2;
+      executed++;
+      JIT_BACKEDGE(from);
+      break;
     }
 
-    case OP_BNE: {
-      if (node->cmp_flag != 0) {
-        int target = find_label(node, inst->reg1);
-        if (target >= 0) {
-          node->ip = target;
-          return 1;
-        }
-      }
-      node->ip++;
-      return 1;
-    }
+    case OP_MOV_ADD:
+      op_mov(node, inst);
+      op_add(node, socket, &inst[1]);
+      node->ip += 2;
+      executed++;
+      break;
 
-    case OP_BLT: {
-      if (node->cmp_flag == -1) {
-        int target = find_label(node, inst->reg1);
-        if (target >= 0) {
-          node->ip = target;
-          return 1;
-        }
-      }
+    case OP_MOV_SYSCALL:
+      op_mov(node, inst);
       node->ip++;
-      return 1;
+      inst++;
+      executed++;
+      // fall through
+    case OP_SYSCALL:
+      if (!sys) { // Worker thread: the main thread runs the syscall
+        executed--;
+        node->yielded = PUFU_YIELD_SYSCALL;
+        goto slice_end;
+      }
+      pufu_node_syscall(sys, node, inst);
+      if (syscall_ends_slice(node))
+        goto slice_end;
+      // Syscalls may hot swap the socket (system_update)
+      socket = pufu_get_current_socket();
+      break;
+
+    default:
+      // NOP or Unknown
+      node->ip++; // Just skip
+      break;
     }
 
-    case OP_BGT: {
-      if (node->cmp_flag == 1) {
-        int target = find_label(node, inst->reg1);
-        if (target >= 0) {
-          node->ip = target;
-          return 1;
-        }
+    // Time budget is checked every 64 instructions to keep the loop tight
+    if (deadline && executed >= next_check) {
+      next_check = executed + 64;
+      if (get_time_us() >= deadline) {
+        expired = 1;
+        goto slice_end;
       }
-      node->ip++;
-      return 1;
     }
+  }
+  expired = 1;
 
-    case OP_LABEL:
-      node->ip++;
-      return 1;
+slice_end:
+  end_slice(node, executed, expired);
+}
 
-    case OP_SYSCALL:
-      // Check Dispatch
-      if (pufu_syscall_dispatch(sys, node, inst)) {
-        return 1;
-      }
-      // Fallback to ARM Socket text exec for unknown syscalls?
-      // "syscall name arg1"
-      snprintf(code, sizeof(code), "syscall %s", inst->value);
-      if (inst->reg1[0]) {
-        strncat(code, " ", 255 - strlen(code));
-        strncat(code, inst->reg1, 255 - strlen(code));
-      }
-      PufuSocket *socket = pufu_get_current_socket();
-      if (socket && socket->execute) {
-        socket->execute(code);
-      }
-      node->ip++;
-      return 1;
+#endif // PUFU_THREADED_DISPATCH
 
-    default:
-      // NOP or Unknown
-      node->ip++; // Just skip
-      return 1;
+// Ejecutar un nodo (un turno del scheduler)
+int pufu_node_execute(PufuNodeSystem *sys, PufuNode *node) {
+  if (!node || !node->active)
+    return 0;
+
+  // Verificar si está durmiendo
+  if (node->wake_time > 0) {
+    if (get_time_ms() < node->wake_time) {
+      return 1; // Sigue durmiendo
     }
+    node->wake_time = 0; // Despertar
+  }
+
+  if (node->type == PUFU_NODE_ASSEMBLER ||
+      node->type == PUFU_NODE_TRINITY_SCENE) {
+    if (!node->parser || node->ip >= node->parser->count) {
+      node->active = 0;
+      return 0;
+    }
+    run_slice(sys, node);
+    return node->active;
   } else if (node->type == PUFU_NODE_CRYSTAL) {
     if (node->crystal) {
       uint8_t result = pufu_crystal_step(node->crystal);
@@ -210,27 +494,76 @@ int pufu_node_execute(PufuNodeSystem *sys, PufuNode *node) {
   return 0;
 }
 
+int pufu_node_execute_compute(PufuNode *node) {
+  if (!node || !node->active || node->wake_time > 0)
+    return 0;
+  if (node->type != PUFU_NODE_ASSEMBLER)
+    return 0;
+  if (!node->parser || node->ip >= node->parser->count) {
+    node->active = 0;
+    return 0;
+  }
+  run_slice(NULL, node);
+  return node->active;
+}
+
+int pufu_node_format_stats(PufuNode *node, char *buf, int size) {
+  int len = snprintf(buf, size,
+                     "%s: insns=%lld turns=%lld last=%d quantum=%d/%dus "
+                     "expired=%lld yields=%lld class=%s",
+                     node->filename, node->stats.instructions,
+                     node->stats.turns, node->stats.last_turn, node->quantum,
+                     node->quantum_us, node->stats.quantum_expired,
+                     node->stats.yields,
+                     pufu_node_class_name(node->sched_class));
+  if (node->jit && len > 0 && len < size - 1) {
+    buf[len++] = ' ';
+    len += pufu_jit_format_stats(node->jit, buf + len, size - len);
+  }
+  return len;
+}
+
+// The node's source changed: compiled loops go back to the VM (once a
+// worker running the node has handed it back)
+static void source_changed(PufuNode *node) {
+  printf("\nNodo modificado: %s\n", node->filename);
+  if (node->in_flight)
+    node->jit_stale = 1;
+  else
+    pufu_jit_invalidate(node->jit);
+  if (node->is_arbiter) {
+    printf("(Este es el nodo árbitro)\n");
+  }
+}
+
+int pufu_node_check(PufuNode *node) {
+  if (!node->reload || pufu_hot_reload_check(node->reload) <= 0)
+    return 0;
+  source_changed(node);
+  return 1;
+}
+
+// New spawns already get the new version (the image is stale); the nodes
+// still running the old one are told here
+static void program_changed(PufuProgram *program, void *arg) {
+  PufuNodeSystem *system = arg;
+  for (PufuNode *node = system->nodes; node; node = node->next) {
+    if (node->program == program && pufu_node_live(node))
+      source_changed(node);
+  }
+}
+
+int pufu_node_system_check_programs(PufuNodeSystem *system) {
+  return pufu_program_check(program_changed, system);
+}
+
 // Verificar cambios en todos los nodos
 int pufu_node_system_check(PufuNodeSystem *system) {
   if (!system)
     return -1;
 
-  int changes = 0;
-  PufuNode *current = system->nodes;
-  while (current) {
-    int result = 0;
-    if (current->reload) {
-      result = pufu_hot_reload_check(current->reload);
-    }
-    if (result > 0) {
-      printf("\nNodo modificado: %s\n", current->filename);
-      if (current->is_arbiter) {
-        printf("(Este es el nodo árbitro)\n");
-      }
-      changes++;
-    }
-    current = current->next;
-  }
-
+  int changes = pufu_node_system_check_programs(system);
+  for (PufuNode *current = system->nodes; current; current = current->next)
+    changes += pufu_node_check(current);
   return changes;
 }
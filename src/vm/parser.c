@@ -1,11 +1,20 @@
 #include "pufu/parser.h"
+#include "pufu/name_hash.h"
 #include "pufu/syscall_ids.h" // New Header
 #include <ctype.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define INITIAL_CAPACITY 32
+#define INTERN_INITIAL_CAPACITY 64
+
+_Static_assert(sizeof(PufuInstruction) == 16,
+               "PufuInstruction must stay a 16-byte packed encoding");
 
 PufuParser *pufu_parser_init(void) {
   PufuParser *parser = malloc(sizeof(PufuParser));
@@ -13,7 +22,10 @@ PufuParser *pufu_parser_init(void) {
     return NULL;
 
   parser->instructions = malloc(sizeof(PufuInstruction) * INITIAL_CAPACITY);
-  if (!parser->instructions) {
+  parser->debug = malloc(sizeof(PufuDebugInfo) * INITIAL_CAPACITY);
+  if (!parser->instructions || !parser->debug) {
+    free(parser->instructions);
+    free(parser->debug);
     free(parser);
     return NULL;
   }
@@ -27,370 +39,697 @@ PufuParser *pufu_parser_init(void) {
   parser->labels = malloc(sizeof(PufuLabelEntry) * parser->label_capacity);
   parser->label_count = 0;
 
+  // String Pool Init
+  parser->strings_capacity = 256;
+  parser->strings = malloc(parser->strings_capacity);
+  parser->strings_size = 0;
+  parser->intern_capacity = INTERN_INITIAL_CAPACITY;
+  parser->intern_table = calloc(parser->intern_capacity, sizeof(int));
+  parser->intern_count = 0;
+
+  parser->line_no = 0;
+  parser->in_docstring = 0;
+  parser->linked = 0;
+  parser->image = NULL;
+  parser->image_size = 0;
+
   return parser;
 }
 
-static int is_comment_or_empty(const char *line) {
-  while (*line) {
-    if (*line == '#')
+// Source text is never copied: lines and tokens are views into the mmap'd
+// file (or the caller's buffer for pufu_parse_line)
+typedef struct {
+  const char *s;
+  int len;
+} PufuView;
+
+static int parse_error(const char *filename, int line, int col,
+                       const char *msg) {
+  printf("[Parser] %s:%d:%d: %s\n", filename ? filename : "<buffer>", line,
+         col, msg);
+  return -1;
+}
+
+static int view_contains(const char *s, int len, const char *needle) {
+  int n = strlen(needle);
+  for (int i = 0; i + n <= len; i++) {
+    if (memcmp(s + i, needle, n) == 0)
       return 1;
-    if (!isspace(*line))
-      return 0;
-    line++;
   }
-  return 1;
+  return 0;
 }
 
-static int is_label(const char *line) {
-  if (strstr(line, "_claw::") || strstr(line, "_pufu::"))
+// atoi over a view (no NUL terminator to stop at)
+static int32_t view_atoi(const char *s, int len) {
+  int i = 0, neg = 0;
+  if (i < len && (s[i] == '-' || s[i] == '+'))
+    neg = (s[i++] == '-');
+  uint32_t value = 0;
+  for (; i < len && isdigit((unsigned char)s[i]); i++)
+    value = value * 10 + (s[i] - '0');
+  return (int32_t)(neg ? 0u - value : value);
+}
+
+static int is_label(const char *text, const char *end) {
+  if (view_contains(text, end - text, "_claw::") ||
+      view_contains(text, end - text, "_pufu::"))
     return 0;
-  const char *ptr = line;
-  while (*ptr && !isspace(*ptr))
+  const char *ptr = text;
+  while (ptr < end && !isspace((unsigned char)*ptr))
     ptr++;
-  if (ptr > line && *(ptr - 1) == ':')
+  if (ptr > text && *(ptr - 1) == ':')
     return 1;
   return 0;
 }
 
-static void get_opcode_from_string(PufuInstruction *inst, const char *op_str) {
-  if (strcmp(op_str, "mov") == 0)
-    inst->opcode = OP_MOV;
-  else if (strcmp(op_str, "add") == 0)
-    inst->opcode = OP_ADD;
-  else if (strcmp(op_str, "sub") == 0)
-    inst->opcode = OP_SUB;
-  else if (strcmp(op_str, "mul") == 0)
-    inst->opcode = OP_MUL;
-  else if (strcmp(op_str, "div") == 0)
-    inst->opcode = OP_DIV;
-  else if (strcmp(op_str, "cmp") == 0)
-    inst->opcode = OP_CMP;
-  else if (strcmp(op_str, "jmp") == 0)
-    inst->opcode = OP_JMP;
-  else if (strcmp(op_str, "beq") == 0)
-    inst->opcode = OP_BEQ;
-  else if (strcmp(op_str, "bne") == 0)
-    inst->opcode = OP_BNE;
-  else if (strcmp(op_str, "blt") == 0)
-    inst->opcode = OP_BLT;
-  else if (strcmp(op_str, "bgt") == 0)
-    inst->opcode = OP_BGT;
-  else if (strcmp(op_str, "label") == 0)
-    inst->opcode = OP_LABEL;
-  else if (strcmp(op_str, "syscall") == 0)
-    inst->opcode = OP_SYSCALL;
-  else if (op_str[0] == '(')
-    inst->opcode = OP_SYSCALL; // Shorthand
-  else
-    inst->opcode = OP_NOP;
+// Mnemonic and syscall names resolve through generated perfect hashes
+// (tools/pufu_names.txt -> include/pufu/name_hash.h, `make names`)
+static PufuOpcode get_opcode_from_string(PufuView op) {
+  if (op.len > 0 && op.s[0] == '(')
+    return OP_SYSCALL; // Shorthand
+  return pufu_opcode_lookup(op.s, op.len);
 }
 
-// Optimized Syscall Tokenization
-static int get_syscall_id(const char *name) {
-  if (strcmp(name, "(write)") == 0)
-    return SYS_WRITE;
-  if (strcmp(name, "(read_char)") == 0)
-    return SYS_READ_CHAR;
-  if (strcmp(name, "(console_input)") == 0)
-    return SYS_CONSOLE_INPUT;
-  if (strcmp(name, "(print_char)") == 0)
-    return SYS_PRINT_CHAR;
-  if (strcmp(name, "(clear_buffer)") == 0)
-    return SYS_CLEAR_BUFFER;
-  if (strcmp(name, "(console_clear)") == 0)
-    return SYS_CONSOLE_CLEAR;
-  if (strcmp(name, "(set_prompt)") == 0)
-    return SYS_SET_PROMPT;
-  if (strcmp(name, "(cat)") == 0)
-    return SYS_CAT;
-  if (strcmp(name, "(log_buffer)") == 0)
-    return SYS_LOG_BUFFER;
-  if (strcmp(name, "(prepend_string)") == 0)
-    return SYS_PREPEND_STRING;
-
-  if (strcmp(name, "(spawn)") == 0)
-    return SYS_SPAWN;
-  if (strcmp(name, "(exec)") == 0)
-    return SYS_EXEC;
-  if (strcmp(name, "(kill)") == 0)
-    return SYS_KILL;
-  if (strcmp(name, "(exit)") == 0)
-    return SYS_EXIT;
-  if (strcmp(name, "(sleep)") == 0)
-    return SYS_SLEEP;
-  if (strcmp(name, "(shutdown)") == 0)
-    return SYS_SHUTDOWN;
-  if (strcmp(name, "(spawn_from_buffer)") == 0)
-    return SYS_SPAWN_FROM_BUFFER;
-  if (strcmp(name, "(kill_from_buffer)") == 0)
-    return SYS_KILL_FROM_BUFFER;
-  if (strcmp(name, "(parse_command)") == 0)
-    return SYS_PARSE_COMMAND;
-
-  if (strcmp(name, "(ipc_send_from_buffer)") == 0)
-    return SYS_IPC_SEND;
-  if (strcmp(name, "(ipc_read)") == 0)
-    return SYS_IPC_READ;
-  if (strcmp(name, "(ipc_broadcast_from_buffer)") == 0)
-    return SYS_IPC_BROADCAST;
-
-  if (strcmp(name, "(config_get)") == 0)
-    return SYS_CONFIG_GET;
-
-  if (strcmp(name, "(tws_switch)") == 0)
-    return SYS_TWS_SWITCH;
-  if (strcmp(name, "(tws_switch_from_args)") == 0)
-    return SYS_TWS_SWITCH_ARGS;
-
-  if (strcmp(name, "(trinity_init)") == 0)
-    return SYS_TRINITY_INIT;
-  if (strcmp(name, "(trinity_step)") == 0)
-    return SYS_TRINITY_STEP;
-  if (strcmp(name, "(window_init)") == 0)
-    return SYS_WINDOW_INIT;
-  if (strcmp(name, "(window_clear)") == 0)
-    return SYS_WINDOW_CLEAR;
-  if (strcmp(name, "(window_swap)") == 0)
-    return SYS_WINDOW_SWAP;
-  if (strcmp(name, "(window_draw_model)") == 0)
-    return SYS_WINDOW_DRAW_MODEL;
-
-  if (strcmp(name, "(create_ui_button)") == 0)
-    return SYS_CREATE_UI_BUTTON;
-
-  if (strcmp(name, "(trinity_set_vec3)") == 0)
-    return SYS_TRINITY_SET_VEC3;
-
-  if (strcmp(name, "(trinity_set_string)") == 0)
-    return SYS_TRINITY_SET_STRING;
-
-  if (strcmp(name, "(create_ui_image)") == 0)
-    return SYS_CREATE_UI_IMAGE;
-
-  if (strcmp(name, "(create_ui_window)") == 0)
-    return SYS_CREATE_UI_WINDOW;
-
-  if (strcmp(name, "(trinity_poll_event)") == 0)
-    return SYS_TRINITY_POLL_EVENT;
-  if (strcmp(name, "(trinity_set_vec4)") == 0)
-    return SYS_TRINITY_SET_VEC4;
-  if (strcmp(name, "(trinity_get_vec4)") == 0)
-    return SYS_TRINITY_GET_VEC4;
-  if (strcmp(name, "(trinity_update_rect)") == 0)
-    return SYS_TRINITY_UPDATE_RECT;
-
-  // Meow
-  if (strcmp(name, "(trinity_load_meow)") == 0)
-    return SYS_TRINITY_LOAD_MEOW;
-  if (strcmp(name, "load_meow") == 0)
-    return SYS_TRINITY_LOAD_MEOW;
-  if (strcmp(name, "(itoa)") == 0)
-    return SYS_ITOA;
-  if (strcmp(name, "(bind_event)") == 0)
-    return SYS_BIND_EVENT;
-  if (strcmp(name, "(exec_binding)") == 0)
-    return SYS_EXEC_BINDING;
-  if (strcmp(name, "(get_version)") == 0)
-    return SYS_GET_VERSION;
-  if (strcmp(name, "(clear_buffer)") == 0)
-    return SYS_CLEAR_BUFFER;
-
-  if (strcmp(name, "(system_update)") == 0)
-    return SYS_SYSTEM_UPDATE;
-  if (strcmp(name, "(download_update)") == 0)
-    return SYS_DOWNLOAD_UPDATE;
-
-  return SYS_UNKNOWN;
+// --- Interned String Pool ---
+
+static unsigned int hash_bytes(const char *str, int len) {
+  unsigned int h = 2166136261u; // FNV-1a
+  for (int i = 0; i < len; i++) {
+    h ^= (unsigned char)str[i];
+    h *= 16777619u;
+  }
+  return h;
 }
 
-int pufu_parse_line(PufuParser *parser, const char *line) {
-  if (is_comment_or_empty(line))
+static int intern_grow(PufuParser *parser) {
+  int new_cap = parser->intern_capacity * 2;
+  int *table = calloc(new_cap, sizeof(int));
+  if (!table)
+    return -1;
+  for (int i = 0; i < parser->intern_capacity; i++) {
+    int entry = parser->intern_table[i];
+    if (!entry)
+      continue;
+    const char *s = parser->strings + entry - 1;
+    unsigned int slot = hash_bytes(s, strlen(s)) & (new_cap - 1);
+    while (table[slot])
+      slot = (slot + 1) & (new_cap - 1);
+    table[slot] = entry;
+  }
+  free(parser->intern_table);
+  parser->intern_table = table;
+  parser->intern_capacity = new_cap;
+  return 0;
+}
+
+// Make room for `bytes` more at the end of the pool
+static int pool_reserve(PufuParser *parser, int bytes) {
+  if (parser->strings_size + bytes <= parser->strings_capacity)
     return 0;
+  int new_cap = parser->strings_capacity * 2;
+  while (parser->strings_size + bytes > new_cap)
+    new_cap *= 2;
+  char *new_strings = realloc(parser->strings, new_cap);
+  if (!new_strings)
+    return -1;
+  parser->strings = new_strings;
+  parser->strings_capacity = new_cap;
+  return 0;
+}
 
-  if (parser->count >= parser->capacity) {
-    int new_capacity = parser->capacity * 2;
-    PufuInstruction *new_instructions =
-        realloc(parser->instructions, sizeof(PufuInstruction) * new_capacity);
-    if (!new_instructions)
-      return -1;
-    parser->instructions = new_instructions;
-    parser->capacity = new_capacity;
+// Intern a string in the pool (identical strings share one offset).
+// Returns its offset, or -1 on allocation failure.
+static int pool_intern(PufuParser *parser, const char *str, int len) {
+  if (!parser->strings || !parser->intern_table)
+    return -1;
+
+  unsigned int mask = parser->intern_capacity - 1;
+  unsigned int slot = hash_bytes(str, len) & mask;
+  while (parser->intern_table[slot]) {
+    const char *s = parser->strings + parser->intern_table[slot] - 1;
+    if (strncmp(s, str, len) == 0 && s[len] == '\0')
+      return parser->intern_table[slot] - 1;
+    slot = (slot + 1) & mask;
   }
 
-  PufuInstruction *inst = &parser->instructions[parser->count];
-  memset(inst, 0, sizeof(PufuInstruction));
+  if (pool_reserve(parser, len + 1) < 0)
+    return -1;
+  int offset = parser->strings_size;
+  // memmove: pool_intern_literal decodes straight into the pool tail
+  memmove(parser->strings + offset, str, len);
+  parser->strings[offset + len] = '\0';
+  parser->strings_size += len + 1;
+
+  parser->intern_table[slot] = offset + 1;
+  parser->intern_count++;
+  if (parser->intern_count * 2 > parser->intern_capacity)
+    intern_grow(parser);
+  return offset;
+}
 
-  // Handle Label Definition Syntax "name:"
-  if (is_label(line)) {
-    inst->opcode = OP_LABEL;
-    strcpy(inst->op, "label");
-    const char *ptr = line;
-    while (*ptr && isspace(*ptr))
-      ptr++;
-    const char *end = ptr;
-    while (*end && *end != ':')
-      end++;
-    int len = end - ptr;
-    if (len >= 127)
-      len = 127;
-    strncpy(inst->reg1, ptr, len);
-    inst->reg1[len] = '\0';
-
-    // START LABEL INDEXING LOGIC
-    if (parser->label_count >= parser->label_capacity) {
-      int new_cap = parser->label_capacity * 2;
-      PufuLabelEntry *new_labels =
-          realloc(parser->labels, sizeof(PufuLabelEntry) * new_cap);
-      if (new_labels) {
-        parser->labels = new_labels;
-        parser->label_capacity = new_cap;
-      }
-    }
-    if (parser->labels && parser->label_count < parser->label_capacity) {
-      strncpy(parser->labels[parser->label_count].name, inst->reg1, 63);
-      parser->labels[parser->label_count].index = parser->count;
-      parser->label_count++;
+// Intern the body of a "literal": \" \\ \n \t are decoded in place at the
+// end of the pool, so escaped strings cost no scratch buffer either
+static int pool_intern_literal(PufuParser *parser, const char *str, int len) {
+  if (!memchr(str, '\\', len))
+    return pool_intern(parser, str, len);
+  if (!parser->strings || pool_reserve(parser, len + 1) < 0)
+    return -1;
+
+  char *out = parser->strings + parser->strings_size;
+  int n = 0;
+  for (int i = 0; i < len; i++) {
+    char ch = str[i];
+    if (ch == '\\' && i + 1 < len) {
+      ch = str[++i];
+      if (ch == 'n')
+        ch = '\n';
+      else if (ch == 't')
+        ch = '\t';
+      else if (ch != '"' && ch != '\\')
+        out[n++] = '\\'; // Unknown escape: kept as written
     }
-    // END LABEL INDEXING LOGIC
+    out[n++] = ch;
+  }
+  return pool_intern(parser, out, n);
+}
 
-    parser->count++;
+const char *pufu_parser_string(const PufuParser *parser, int offset) {
+  if (!parser || !parser->strings || offset < 0 ||
+      offset >= parser->strings_size)
+    return "";
+  return parser->strings + offset;
+}
+
+// Text of an operand as handlers see it (quotes stripped, escapes decoded)
+static int pool_intern_token(PufuParser *parser, PufuView tok) {
+  if (tok.len >= 2 && tok.s[0] == '"')
+    return pool_intern_literal(parser, tok.s + 1, tok.len - 2);
+  return pool_intern(parser, tok.s, tok.len);
+}
+
+// Decode an operand token once at load time:
+// "r3" -> register, "42"/"-7" -> immediate, "text"/label -> string pool.
+// -1 if it is a register outside r0-r15 ("r16", "r2x"): that is a typo,
+// not text, and must not run as something else.
+static int decode_operand(PufuParser *parser, PufuView tok, uint8_t *kind,
+                          int32_t *value) {
+  *kind = PUFU_OPERAND_NONE;
+  *value = 0;
+  if (tok.len == 0)
+    return 0;
+
+  const char *s = tok.s;
+  if ((s[0] == 'r' || s[0] == 'R') && tok.len > 1 &&
+      isdigit((unsigned char)s[1])) {
+    // Digits stop counting once past r15, so a long index cannot wrap
+    // around into range (or below 0) the way view_atoi would
+    int reg = 0, i = 1;
+    for (; i < tok.len && isdigit((unsigned char)s[i]) && reg < 16; i++)
+      reg = reg * 10 + (s[i] - '0');
+    if (i < tok.len || reg >= 16) // Same rule as the .pufub loader
+      return -1;
+    *kind = PUFU_OPERAND_REG;
+    *value = reg;
     return 0;
   }
 
-  // Normal Instruction Parsing
-  char buffer[256];
-  strncpy(buffer, line, 255);
-  buffer[255] = '\0';
+  if (isdigit((unsigned char)s[0]) ||
+      ((s[0] == '-' || s[0] == '+') && tok.len > 1 &&
+       isdigit((unsigned char)s[1]))) {
+    *kind = PUFU_OPERAND_IMM;
+    *value = view_atoi(s, tok.len);
+    return 0;
+  }
 
-  char *ptr = buffer;
-  while (*ptr && isspace(*ptr))
-    ptr++;
+  *value = pool_intern_token(parser, tok);
+  *kind = (*value >= 0) ? PUFU_OPERAND_STR : PUFU_OPERAND_NONE;
+  return 0;
+}
 
-  // Op
-  char *op_start = ptr;
-  while (*ptr && !isspace(*ptr))
-    ptr++;
-  if (*ptr) {
-    *ptr = 0;
-    ptr++;
-  }
+// Label names ("r2loop", "1st") are text whatever they look like
+static void decode_name(PufuParser *parser, PufuView tok, uint8_t *kind,
+                        int32_t *value) {
+  *kind = PUFU_OPERAND_NONE;
+  *value = 0;
+  if (tok.len == 0)
+    return;
+  *value = pool_intern_token(parser, tok);
+  *kind = (*value >= 0) ? PUFU_OPERAND_STR : PUFU_OPERAND_NONE;
+}
+
+static int is_branch(PufuOpcode op) {
+  return op == OP_JMP || op == OP_BEQ || op == OP_BNE || op == OP_BLT ||
+         op == OP_BGT;
+}
+
+// Report a bad register operand at its column
+static int register_error(const char *filename, int line_no,
+                          const char *line, PufuView tok) {
+  char msg[96];
+  snprintf(msg, sizeof(msg), "bad register '%.*s' (r0-r15)",
+           tok.len > 32 ? 32 : tok.len, tok.s);
+  return parse_error(filename, line_no, tok.s - line + 1, msg);
+}
 
-  strncpy(inst->op, op_start, 31);
-  get_opcode_from_string(inst, inst->op);
+static int ensure_capacity(PufuParser *parser) {
+  if (parser->count < parser->capacity)
+    return 0;
+  int new_capacity = parser->capacity * 2;
+  PufuInstruction *new_instructions =
+      realloc(parser->instructions, sizeof(PufuInstruction) * new_capacity);
+  if (!new_instructions)
+    return -1;
+  parser->instructions = new_instructions;
+  PufuDebugInfo *new_debug =
+      realloc(parser->debug, sizeof(PufuDebugInfo) * new_capacity);
+  if (!new_debug)
+    return -1;
+  parser->debug = new_debug;
+  parser->capacity = new_capacity;
+  return 0;
+}
 
-  // Special Handling for Syscall Shorthand "(write)"
-  if (inst->opcode == OP_SYSCALL && inst->op[0] == '(') {
-    strncpy(inst->value, inst->op, 127);
-    inst->is_syscall = 1;
-    inst->syscall_id = get_syscall_id(inst->value);
-    // Continue to parse args as reg1
+static int index_label(PufuParser *parser, PufuView name) {
+  if (name.len >= (int)sizeof(parser->labels[0].name))
+    return -1;
+  if (parser->label_count >= parser->label_capacity) {
+    int new_cap = parser->label_capacity * 2;
+    PufuLabelEntry *new_labels =
+        realloc(parser->labels, sizeof(PufuLabelEntry) * new_cap);
+    if (new_labels) {
+      parser->labels = new_labels;
+      parser->label_capacity = new_cap;
+    }
   }
+  if (parser->labels && parser->label_count < parser->label_capacity) {
+    PufuLabelEntry *entry = &parser->labels[parser->label_count];
+    memcpy(entry->name, name.s, name.len);
+    entry->name[name.len] = '\0';
+    entry->index = parser->count;
+    parser->label_count++;
+  }
+  return 0;
+}
 
-  // Arg 1
-  while (*ptr && isspace(*ptr))
+// Next token (quoted strings kept whole, \" does not close them).
+// Returns -1 if a string literal runs off the end of the line.
+static int next_token(const char **cur, const char *end, PufuView *tok) {
+  const char *ptr = *cur;
+  while (ptr < end && isspace((unsigned char)*ptr))
     ptr++;
-  if (*ptr) {
-    char *arg1_start = ptr;
-    if (*ptr == '"') {
-      ptr++; // skip quote
-      while (*ptr && *ptr != '"')
-        ptr++;
-      if (*ptr)
-        ptr++; // skip closing
-    } else {
-      while (*ptr && !isspace(*ptr))
+  const char *start = ptr;
+  int ok = 0;
+  if (ptr < end && *ptr == '"') {
+    ptr++; // skip quote
+    while (ptr < end && *ptr != '"') {
+      if (*ptr == '\\' && ptr + 1 < end)
         ptr++;
+      ptr++;
     }
-    char save = *ptr;
-    *ptr = 0;
-    strncpy(inst->reg1, arg1_start, 127);
-
-    // If it's a syscall, and we parsed arg1, this might be the value (if
-    // explicit syscall)
-    if (strcmp(inst->op, "syscall") == 0) {
-      strncpy(inst->value, arg1_start, 127); // value = syscall name
-      inst->is_syscall = 1;
-      inst->syscall_id = get_syscall_id(inst->value);
-      *inst->reg1 = 0;
-    }
-
-    if (save)
+    if (ptr < end)
+      ptr++; // skip closing
+    else
+      ok = -1;
+  } else {
+    while (ptr < end && !isspace((unsigned char)*ptr))
       ptr++;
+  }
+  tok->s = start;
+  tok->len = ptr - start;
+  *cur = ptr;
+  return ok;
+}
 
-    // PATCH: Index OP_LABEL style labels
-    if (inst->opcode == OP_LABEL) {
-      if (parser->label_count >= parser->label_capacity) {
-        int new_cap = parser->label_capacity * 2;
-        PufuLabelEntry *new_labels =
-            realloc(parser->labels, sizeof(PufuLabelEntry) * new_cap);
-        if (new_labels) {
-          parser->labels = new_labels;
-          parser->label_capacity = new_cap;
-        }
-      }
-      if (parser->labels && parser->label_count < parser->label_capacity) {
-        strncpy(parser->labels[parser->label_count].name, inst->reg1, 63);
-        parser->labels[parser->label_count].index = parser->count;
-        parser->label_count++;
-      }
-    }
+// Parse one source line [line, line + len), without its newline
+static int parse_view(PufuParser *parser, const char *filename,
+                      const char *line, int len) {
+  if (parser->image)
+    return -1; // .pufub programs are read-only
+  parser->line_no++;
+
+  const char *end = line + len;
+  while (end > line && (end[-1] == '\n' || end[-1] == '\r'))
+    end--;
+  const char *text = line;
+  while (text < end && isspace((unsigned char)*text))
+    text++;
+  if (text == end || *text == '#')
+    return 0;
+
+  // """docstring""" blocks may span lines and are never code
+  if (parser->in_docstring ||
+      (end - text >= 3 && memcmp(text, "\"\"\"", 3) == 0)) {
+    const char *from = parser->in_docstring ? text : text + 3;
+    parser->in_docstring = !view_contains(from, end - from, "\"\"\"");
+    return 0;
   }
 
-  // Arg 2 (or Arg 1 for syscall)
-  while (*ptr && isspace(*ptr))
-    ptr++;
-  if (*ptr) {
-    char *arg2_start = ptr;
-    if (*ptr == '"') {
-      ptr++;
-      while (*ptr && *ptr != '"')
-        ptr++;
-      if (*ptr)
-        ptr++;
-    } else {
-      while (*ptr && !isspace(*ptr))
-        ptr++;
-    }
-    char save = *ptr;
-    *ptr = 0;
+  if (ensure_capacity(parser) < 0)
+    return -1;
 
-    if (inst->is_syscall) {
-      strncpy(inst->reg1, arg2_start, 127);
-    } else {
-      strncpy(inst->reg2, arg2_start, 127);
-      if (isdigit(arg2_start[0]) || arg2_start[0] == '-') {
-        strncpy(inst->value, arg2_start, 127);
-      }
+  PufuInstruction *inst = &parser->instructions[parser->count];
+  memset(inst, 0, sizeof(PufuInstruction));
+
+  // Debug Side Table: source line, trimmed
+  parser->debug[parser->count].line = parser->line_no;
+  parser->debug[parser->count].text = pool_intern(parser, text, end - text);
+
+  // Handle Label Definition Syntax "name:"
+  if (is_label(text, end)) {
+    PufuView name = {text, (const char *)memchr(text, ':', end - text) - text};
+    if (index_label(parser, name) < 0)
+      return parse_error(filename, parser->line_no, text - line + 1,
+                         "label name too long");
+
+    uint8_t kind;
+    inst->opcode = OP_LABEL;
+    decode_name(parser, name, &kind, &inst->a);
+    inst->a_kind = kind;
+    parser->count++;
+    return 0;
+  }
+
+  // Normal Instruction Parsing
+  PufuView op, arg1, arg2;
+  PufuView *tokens[3] = {&op, &arg1, &arg2};
+  const char *ptr = text;
+  for (int i = 0; i < 3; i++) {
+    if (next_token(&ptr, end, tokens[i]) < 0)
+      return parse_error(filename, parser->line_no, tokens[i]->s - line + 1,
+                         "unterminated string literal");
+  }
+
+  inst->opcode = get_opcode_from_string(op);
+
+  if (inst->opcode == OP_SYSCALL) {
+    // "(write) arg" shorthand or explicit "syscall (write) arg"
+    PufuView name = op;
+    PufuView arg = arg2.len ? arg2 : arg1;
+    if (op.s[0] != '(') {
+      name = arg1;
+      arg = arg2;
     }
-    if (save)
-      ptr++;
+    inst->syscall_id = pufu_syscall_lookup(name.s, name.len);
+    inst->c = pool_intern(parser, name.s, name.len);
+
+    uint8_t kind;
+    if (decode_operand(parser, arg, &kind, &inst->a) < 0)
+      return register_error(filename, parser->line_no, line, arg);
+    inst->a_kind = kind;
+    if (arg.len) {
+      // Handlers read the argument as text too (quotes stripped)
+      inst->b = pool_intern_token(parser, arg);
+      inst->b_kind = PUFU_OPERAND_STR;
+    }
+  } else {
+    // Branch targets and OP_LABEL names are labels, never registers
+    uint8_t kind;
+    if (is_branch(inst->opcode) || inst->opcode == OP_LABEL)
+      decode_name(parser, arg1, &kind, &inst->a);
+    else if (decode_operand(parser, arg1, &kind, &inst->a) < 0)
+      return register_error(filename, parser->line_no, line, arg1);
+    inst->a_kind = kind;
+    if (decode_operand(parser, arg2, &kind, &inst->b) < 0)
+      return register_error(filename, parser->line_no, line, arg2);
+    inst->b_kind = kind;
+
+    // PATCH: Index OP_LABEL style labels
+    if (inst->opcode == OP_LABEL && arg1.len &&
+        index_label(parser, arg1) < 0)
+      return parse_error(filename, parser->line_no, arg1.s - line + 1,
+                         "label name too long");
   }
 
   parser->count++;
   return 0;
 }
 
+int pufu_parse_line(PufuParser *parser, const char *line) {
+  return parse_view(parser, NULL, line, strlen(line));
+}
+
 int pufu_parse_file(PufuParser *parser, const char *filename) {
-  FILE *file = fopen(filename, "r");
-  if (!file)
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0)
     return -1;
-  char line[256];
-  while (fgets(line, sizeof(line), file)) {
-    if (pufu_parse_line(parser, line) < 0) {
-      fclose(file);
-      return -1;
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return -1;
+  }
+  if (st.st_size == 0) {
+    close(fd);
+    return 0;
+  }
+  // Tokenize straight out of the page cache: no line buffer, no length cap
+  const char *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return -1;
+  madvise((void *)map, st.st_size, MADV_SEQUENTIAL);
+
+  const char *ptr = map, *end = map + st.st_size;
+  int result = 0;
+  while (ptr < end) {
+    const char *nl = memchr(ptr, '\n', end - ptr);
+    const char *eol = nl ? nl : end;
+    if (parse_view(parser, filename, ptr, eol - ptr) < 0) {
+      result = -1;
+      break;
+    }
+    ptr = eol + 1;
+  }
+  munmap((void *)map, st.st_size);
+  return result;
+}
+
+static int lookup_label(PufuParser *parser, const char *name) {
+  for (int i = 0; i < parser->label_count; i++) {
+    if (strcmp(parser->labels[i].name, name) == 0)
+      return parser->labels[i].index;
+  }
+  return -1;
+}
+
+// Link Pass: branches get a resolved index so the VM never scans labels, and
+// OP_LABEL slots are removed from the executed stream.
+int pufu_parser_link(PufuParser *parser, const char *filename) {
+  if (!parser)
+    return -1;
+  if (parser->linked)
+    return 0;
+
+  // remap[i] = index of instruction i once labels are stripped.
+  // A label maps to the first real instruction that follows it.
+  int *remap = malloc(sizeof(int) * (parser->count + 1));
+  if (!remap)
+    return -1;
+  int kept = 0;
+  for (int i = 0; i < parser->count; i++) {
+    remap[i] = kept;
+    if (parser->instructions[i].opcode != OP_LABEL)
+      kept++;
+  }
+  remap[parser->count] = kept;
+
+  int unresolved = 0;
+  for (int i = 0; i < parser->count; i++) {
+    PufuInstruction *inst = &parser->instructions[i];
+    if (!is_branch(inst->opcode))
+      continue;
+    const char *name = (inst->a_kind == PUFU_OPERAND_STR)
+                           ? pufu_parser_string(parser, inst->a)
+                           : "";
+    int index = lookup_label(parser, name);
+    if (index < 0) {
+      printf("[Parser] %s:%d: unresolved label '%s' in '%s'\n",
+             filename ? filename : "<buffer>", parser->debug[i].line, name,
+             pufu_parser_string(parser, parser->debug[i].text));
+      unresolved++;
+      continue;
+    }
+    inst->a_kind = PUFU_OPERAND_LABEL;
+    inst->a = remap[index];
+  }
+
+  if (unresolved > 0) {
+    free(remap);
+    return -1;
+  }
+
+  // Compact in place (order preserved, so remap stays valid)
+  int out = 0;
+  for (int i = 0; i < parser->count; i++) {
+    if (parser->instructions[i].opcode == OP_LABEL)
+      continue;
+    if (out != i) {
+      parser->instructions[out] = parser->instructions[i];
+      parser->debug[out] = parser->debug[i];
     }
+    out++;
   }
-  fclose(file);
+  parser->count = out;
+
+  for (int i = 0; i < parser->label_count; i++)
+    parser->labels[i].index = remap[parser->labels[i].index];
+
+  free(remap);
+  parser->linked = 1;
   return 0;
 }
 
+// Superinstruction for a (first, second) pair, or OP_NOP if none
+static PufuOpcode fuse_pair(const PufuInstruction *first,
+                            const PufuInstruction *second) {
+  if (first->opcode == OP_CMP) {
+    switch (second->opcode) {
+    case OP_BEQ:
+      return OP_CMP_BEQ;
+    case OP_BNE:
+      return OP_CMP_BNE;
+    case OP_BLT:
+      return OP_CMP_BLT;
+    case OP_BGT:
+      return OP_CMP_BGT;
+    default:
+      return OP_NOP;
+    }
+  }
+  if (first->opcode == OP_MOV && first->a_kind == PUFU_OPERAND_REG) {
+    if (second->opcode == OP_ADD && second->a_kind == PUFU_OPERAND_REG)
+      return OP_MOV_ADD;
+    if (second->opcode == OP_SYSCALL)
+      return OP_MOV_SYSCALL;
+  }
+  return OP_NOP;
+}
+
+int pufu_parser_optimize(PufuParser *parser) {
+  if (!parser || !parser->linked)
+    return 0;
+
+  // The second op stays where it is, so branch targets need no fixup:
+  // a jump to i + 1 just runs the plain instruction.
+  int fused = 0;
+  for (int i = 0; i + 1 < parser->count; i++) {
+    PufuOpcode super =
+        fuse_pair(&parser->instructions[i], &parser->instructions[i + 1]);
+    if (super == OP_NOP)
+      continue;
+    parser->instructions[i].opcode = super;
+    fused++;
+    i++; // the second op of a pair never starts another one
+  }
+  return fused;
+}
+
+static const char *opcode_name(uint8_t opcode) {
+  switch (opcode) {
+  case OP_NOP:
+    return "nop";
+  case OP_MOV:
+    return "mov";
+  case OP_ADD:
+    return "add";
+  case OP_SUB:
+    return "sub";
+  case OP_MUL:
+    return "mul";
+  case OP_DIV:
+    return "div";
+  case OP_CMP:
+    return "cmp";
+  case OP_JMP:
+    return "jmp";
+  case OP_BEQ:
+    return "beq";
+  case OP_BNE:
+    return "bne";
+  case OP_BLT:
+    return "blt";
+  case OP_BGT:
+    return "bgt";
+  case OP_LABEL:
+    return "label";
+  case OP_SYSCALL:
+    return "syscall";
+  case OP_CMP_BEQ:
+    return "cmp+beq";
+  case OP_CMP_BNE:
+    return "cmp+bne";
+  case OP_CMP_BLT:
+    return "cmp+blt";
+  case OP_CMP_BGT:
+    return "cmp+bgt";
+  case OP_MOV_ADD:
+    return "mov+add";
+  case OP_MOV_SYSCALL:
+    return "mov+sys";
+  default:
+    return "???";
+  }
+}
+
+static void print_operand(const PufuParser *parser, FILE *out, int kind,
+                          int value) {
+  switch (kind) {
+  case PUFU_OPERAND_REG:
+    fprintf(out, " r%d", value);
+    break;
+  case PUFU_OPERAND_IMM:
+    fprintf(out, " #%d", value);
+    break;
+  case PUFU_OPERAND_STR:
+    fprintf(out, " \"%s\"", pufu_parser_string(parser, value));
+    break;
+  case PUFU_OPERAND_LABEL:
+    fprintf(out, " @%d", value);
+    break;
+  default:
+    break;
+  }
+}
+
+void pufu_parser_disassemble(const PufuParser *parser, FILE *out) {
+  if (!parser)
+    return;
+  fprintf(out, "; %d instructions (%zu bytes), string pool %d bytes\n",
+          parser->count, parser->count * sizeof(PufuInstruction),
+          parser->strings_size);
+  for (int i = 0; i < parser->count; i++) {
+    const PufuInstruction *inst = &parser->instructions[i];
+    fprintf(out, "%4d  %-7s", i, opcode_name(inst->opcode));
+    if (inst->opcode == OP_SYSCALL) {
+      fprintf(out, " %s[%d]", pufu_parser_string(parser, inst->c),
+              inst->syscall_id);
+      print_operand(parser, out, inst->a_kind, inst->a);
+    } else {
+      print_operand(parser, out, inst->a_kind, inst->a);
+      print_operand(parser, out, inst->b_kind, inst->b);
+    }
+    fprintf(out, "\t; %d: %s\n", parser->debug[i].line,
+            pufu_parser_string(parser, parser->debug[i].text));
+  }
+}
+
 void pufu_parser_cleanup(PufuParser *parser) {
+  if (parser && parser->image) {
+    // Everything but the struct lives in the .pufub mapping
+    munmap(parser->image, parser->image_size);
+    free(parser);
+    return;
+  }
   if (parser) {
     if (parser->instructions)
       free(parser->instructions);
+    if (parser->debug)
+      free(parser->debug);
     if (parser->labels)
       free(parser->labels);
+    if (parser->strings)
+      free(parser->strings);
+    if (parser->intern_table)
+      free(parser->intern_table);
     free(parser);
   }
 }
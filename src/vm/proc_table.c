@@ -0,0 +1,144 @@
+#include "pufu/proc_table.h"
+#include "pufu/node.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_BUCKETS 64
+
+// FNV-1a
+static unsigned hash_name(const char *name) {
+  unsigned h = 2166136261u;
+  for (const unsigned char *p = (const unsigned char *)name; *p; p++)
+    h = (h ^ *p) * 16777619u;
+  return h;
+}
+
+static unsigned hash_pid(int pid) { return (unsigned)pid * 2654435761u; }
+
+static void link_node(PufuProcTable *table, PufuNode *node) {
+  unsigned mask = (unsigned)table->buckets - 1;
+  PufuNode **pid_head = &table->by_pid[hash_pid(node->pid) & mask];
+  node->pid_next = *pid_head;
+  *pid_head = node;
+  PufuNode **name_head = &table->by_name[node->name_hash & mask];
+  node->name_next = *name_head;
+  *name_head = node;
+}
+
+static int allocate(PufuProcTable *table, int buckets) {
+  table->by_pid = calloc(buckets, sizeof(PufuNode *));
+  table->by_name = calloc(buckets, sizeof(PufuNode *));
+  if (!table->by_pid || !table->by_name) {
+    free(table->by_pid);
+    free(table->by_name);
+    return -1;
+  }
+  table->buckets = buckets;
+  return 0;
+}
+
+int pufu_proc_table_init(PufuProcTable *table) {
+  table->count = 0;
+  table->next_pid = 1;
+  return allocate(table, INITIAL_BUCKETS);
+}
+
+void pufu_proc_table_cleanup(PufuProcTable *table) {
+  free(table->by_pid);
+  free(table->by_name);
+  table->by_pid = NULL;
+  table->by_name = NULL;
+  table->buckets = 0;
+  table->count = 0;
+}
+
+// Double both indexes. Each old name chain is reversed before re-linking
+// so the new chains stay newest-first. Out of memory: keep the old size.
+static void grow(PufuProcTable *table) {
+  PufuNode **old_pids = table->by_pid;
+  PufuNode **old_names = table->by_name;
+  int old_buckets = table->buckets;
+  if (allocate(table, old_buckets * 2) < 0) {
+    table->by_pid = old_pids;
+    table->by_name = old_names;
+    return;
+  }
+
+  for (int b = 0; b < old_buckets; b++) {
+    PufuNode *reversed = NULL;
+    PufuNode *n = old_names[b];
+    while (n) {
+      PufuNode *next = n->name_next;
+      n->name_next = reversed;
+      reversed = n;
+      n = next;
+    }
+    while (reversed) {
+      PufuNode *next = reversed->name_next;
+      link_node(table, reversed);
+      reversed = next;
+    }
+  }
+  free(old_pids);
+  free(old_names);
+}
+
+int pufu_proc_add(PufuProcTable *table, PufuNode *node) {
+  if (!table->by_pid)
+    return -1;
+  if (table->count >= table->buckets)
+    grow(table);
+  node->pid = table->next_pid++;
+  node->name_hash = hash_name(node->filename);
+  link_node(table, node);
+  table->count++;
+  return node->pid;
+}
+
+void pufu_proc_remove(PufuProcTable *table, PufuNode *node) {
+  if (!table->by_pid || node->pid <= 0)
+    return;
+  unsigned mask = (unsigned)table->buckets - 1;
+  PufuNode **link = &table->by_pid[hash_pid(node->pid) & mask];
+  while (*link && *link != node)
+    link = &(*link)->pid_next;
+  if (!*link)
+    return; // Not in this table
+  *link = node->pid_next;
+
+  link = &table->by_name[node->name_hash & mask];
+  while (*link && *link != node)
+    link = &(*link)->name_next;
+  if (*link)
+    *link = node->name_next;
+  node->pid_next = NULL;
+  node->name_next = NULL;
+  table->count--;
+}
+
+PufuNode *pufu_proc_find(const PufuProcTable *table, int pid) {
+  if (!table->by_pid || pid <= 0)
+    return NULL;
+  PufuNode *n = table->by_pid[hash_pid(pid) & ((unsigned)table->buckets - 1)];
+  while (n && n->pid != pid)
+    n = n->pid_next;
+  return n;
+}
+
+static PufuNode *match_name(PufuNode *n, unsigned hash, const char *name) {
+  while (n && (n->name_hash != hash || strcmp(n->filename, name) != 0))
+    n = n->name_next;
+  return n;
+}
+
+PufuNode *pufu_proc_find_named(const PufuProcTable *table, const char *name) {
+  if (!table->by_name)
+    return NULL;
+  unsigned hash = hash_name(name);
+  return match_name(table->by_name[hash & ((unsigned)table->buckets - 1)],
+                    hash, name);
+}
+
+PufuNode *pufu_proc_next_named(const PufuNode *node) {
+  return match_name(node->name_next, node->name_hash, node->filename);
+}
@@ -0,0 +1,157 @@
+#define _DEFAULT_SOURCE // realpath
+#include "pufu/program.h"
+#include "pufu/boot_trace.h"
+#include "pufu/node.h"
+#include "pufu/pufub.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// Saved in place (write) or replaced (editors that rename a new file over
+// it): either way the image no longer matches the source
+#define WATCH_EVENTS                                                           \
+  (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF)
+
+// Registry of live images (few files, so a list is enough)
+static PufuProgram *programs = NULL;
+static int watch_fd = -2; // -2: not created yet, -1: inotify unavailable
+
+int pufu_program_watch_fd(void) {
+  if (watch_fd == -2)
+    watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  return watch_fd;
+}
+
+static void unwatch(PufuProgram *program) {
+  if (program->watch >= 0)
+    inotify_rm_watch(watch_fd, program->watch);
+  program->watch = -1;
+}
+
+static PufuParser *load_parser(const char *path, int type) {
+  PufuParser *parser = pufu_parser_init();
+  if (!parser)
+    return NULL;
+  if (pufu_parse_file(parser, path) < 0) {
+    printf("Error parsing file: %s\n", path);
+    pufu_parser_cleanup(parser);
+    return NULL;
+  }
+  // Resolve labels now so bad jumps fail at load, not at runtime
+  if (pufu_parser_link(parser, path) < 0) {
+    printf("Error linking file: %s\n", path);
+    pufu_parser_cleanup(parser);
+    return NULL;
+  }
+  pufu_parser_optimize(parser);
+  pufu_pufub_store(parser, path, type);
+  return parser;
+}
+
+PufuProgram *pufu_program_acquire(const char *filename, int type) {
+  char full[PATH_MAX];
+  const char *path = realpath(filename, full) ? full : filename;
+
+  for (PufuProgram *p = programs; p; p = p->next) {
+    if (!p->stale && strcmp(p->path, path) == 0) {
+      p->refs++;
+      return p;
+    }
+  }
+
+  // Precompiled program: one mmap, no tokenizing, no type sniffing
+  long long t0 = pufu_boot_trace_now();
+  int cached_type = -1;
+  PufuParser *parser = pufu_pufub_load(path, &cached_type);
+  if (parser) {
+    type = cached_type;
+    pufu_boot_trace_span("load_cached", t0);
+  } else {
+    if (type < 0)
+      type = pufu_node_detect_type(path);
+    parser = load_parser(path, type);
+    if (!parser)
+      return NULL;
+    pufu_boot_trace_span("parse", t0);
+  }
+
+  PufuProgram *program = calloc(1, sizeof(PufuProgram));
+  if (!program || !(program->path = strdup(path))) {
+    free(program);
+    pufu_parser_cleanup(parser);
+    return NULL;
+  }
+  program->parser = parser;
+  program->type = type;
+  program->refs = 1;
+  int fd = pufu_program_watch_fd();
+  program->watch = fd >= 0 ? inotify_add_watch(fd, path, WATCH_EVENTS) : -1;
+  program->next = programs;
+  programs = program;
+  return program;
+}
+
+static void unlink_program(PufuProgram *program) {
+  PufuProgram **link = &programs;
+  while (*link && *link != program)
+    link = &(*link)->next;
+  if (*link)
+    *link = program->next;
+}
+
+void pufu_program_release(PufuProgram *program) {
+  if (!program || --program->refs > 0)
+    return;
+  unlink_program(program);
+  unwatch(program);
+  pufu_parser_cleanup(program->parser);
+  free(program->path);
+  free(program);
+}
+
+void pufu_program_invalidate(PufuProgram *program) {
+  if (!program)
+    return;
+  program->stale = 1;
+  unwatch(program); // The next acquire watches the new version
+}
+
+int pufu_program_check(void (*changed)(PufuProgram *program, void *arg),
+                       void *arg) {
+  if (watch_fd < 0)
+    return 0;
+  int count = 0;
+  char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  ssize_t len;
+  while ((len = read(watch_fd, buf, sizeof(buf))) > 0) {
+    for (char *p = buf; p < buf + len;) {
+      const struct inotify_event *event = (const struct inotify_event *)p;
+      p += sizeof(struct inotify_event) + event->len;
+      // Late events of an image already invalidated (IN_IGNORED too)
+      // match no watch
+      for (PufuProgram *program = programs; program; program = program->next) {
+        if (program->watch == event->wd && (event->mask & WATCH_EVENTS)) {
+          pufu_program_invalidate(program);
+          if (changed)
+            changed(program, arg);
+          count++;
+          break;
+        }
+      }
+    }
+  }
+  if (len < 0 && errno != EAGAIN)
+    perror("[Program] inotify read");
+  return count;
+}
+
+int pufu_program_count(void) {
+  int count = 0;
+  for (PufuProgram *p = programs; p; p = p->next)
+    count++;
+  return count;
+}
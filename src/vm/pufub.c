@@ -0,0 +1,253 @@
+#define _DEFAULT_SOURCE // realpath
+#include "pufu/pufub.h"
+#include "pufu/name_hash.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// On-disk layout: header, then the sections at the recorded offsets
+typedef struct {
+  char magic[4]; // "PUFB"
+  uint32_t version;
+  uint32_t inst_size;  // sizeof(PufuInstruction), guards layout changes
+  uint32_t names_hash; // PUFU_NAMES_HASH, guards name table changes
+  int32_t node_type;
+  int64_t source_mtime_sec;
+  int64_t source_mtime_nsec;
+  int64_t source_size;
+  int32_t has_pufu_init;
+  int32_t count;
+  int32_t label_count;
+  int32_t strings_size;
+  uint32_t inst_offset;
+  uint32_t debug_offset;
+  uint32_t labels_offset;
+  uint32_t strings_offset;
+} PufubHeader;
+
+static int cache_enabled = 1;
+
+void pufu_pufub_set_enabled(int enabled) { cache_enabled = enabled; }
+
+int pufu_pufub_enabled(void) { return cache_enabled; }
+
+static uint64_t hash_path(const char *path) {
+  uint64_t h = 14695981039346656037ull; // FNV-1a 64
+  for (; *path; path++) {
+    h ^= (unsigned char)*path;
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+int pufu_pufub_path(const char *source, char *out, int size) {
+  char full[PATH_MAX];
+  const char *key = realpath(source, full) ? full : source;
+  const char *base = strrchr(source, '/');
+  base = base ? base + 1 : source;
+  return snprintf(out, size, "%s/%s.%016llx.pufub", PUFU_CACHE_DIR, base,
+                  (unsigned long long)hash_path(key));
+}
+
+static int section_ok(size_t file_size, uint32_t offset, size_t bytes) {
+  return offset <= file_size && bytes <= file_size - offset &&
+         offset % 4 == 0;
+}
+
+static int is_branch(int op) {
+  return op == OP_JMP || op == OP_BEQ || op == OP_BNE || op == OP_BLT ||
+         op == OP_BGT;
+}
+
+static int is_fused_branch(int op) {
+  return op == OP_CMP_BEQ || op == OP_CMP_BNE || op == OP_CMP_BLT ||
+         op == OP_CMP_BGT;
+}
+
+// Never trust a cache file: every index the VM follows must be in range
+static int image_ok(const PufubHeader *h, const uint8_t *base,
+                    size_t file_size) {
+  if (h->count < 0 || h->label_count < 0 || h->strings_size <= 0)
+    return 0;
+  if (!section_ok(file_size, h->inst_offset,
+                  (size_t)h->count * sizeof(PufuInstruction)) ||
+      !section_ok(file_size, h->debug_offset,
+                  (size_t)h->count * sizeof(PufuDebugInfo)) ||
+      !section_ok(file_size, h->labels_offset,
+                  (size_t)h->label_count * sizeof(PufuLabelEntry)) ||
+      !section_ok(file_size, h->strings_offset, h->strings_size))
+    return 0;
+
+  const char *strings = (const char *)base + h->strings_offset;
+  if (strings[h->strings_size - 1] != '\0')
+    return 0;
+
+  const PufuInstruction *code =
+      (const PufuInstruction *)(base + h->inst_offset);
+  const PufuDebugInfo *debug = (const PufuDebugInfo *)(base + h->debug_offset);
+  for (int i = 0; i < h->count; i++) {
+    const PufuInstruction *inst = &code[i];
+    int kinds[2] = {inst->a_kind, inst->b_kind};
+    int values[2] = {inst->a, inst->b};
+    for (int k = 0; k < 2; k++) {
+      if (kinds[k] == PUFU_OPERAND_REG && (values[k] < 0 || values[k] >= 16))
+        return 0;
+      if (kinds[k] == PUFU_OPERAND_STR &&
+          (values[k] < 0 || values[k] >= h->strings_size))
+        return 0;
+      if (kinds[k] == PUFU_OPERAND_LABEL &&
+          (values[k] < 0 || values[k] > h->count))
+        return 0;
+    }
+    if (inst->opcode == OP_SYSCALL &&
+        (inst->c < 0 || inst->c >= h->strings_size))
+      return 0;
+    // Branches jump to inst->a; a fused compare takes inst[1]'s branch
+    if (is_branch(inst->opcode) && inst->a_kind != PUFU_OPERAND_LABEL)
+      return 0;
+    if (is_fused_branch(inst->opcode) &&
+        (i + 1 >= h->count || inst[1].opcode == OP_JMP ||
+         !is_branch(inst[1].opcode)))
+      return 0;
+    if (debug[i].text < 0 || debug[i].text >= h->strings_size)
+      return 0;
+  }
+  return 1;
+}
+
+PufuParser *pufu_pufub_load(const char *source, int *node_type) {
+  if (!cache_enabled)
+    return NULL;
+
+  struct stat src;
+  if (stat(source, &src) < 0)
+    return NULL;
+
+  char path[PATH_MAX];
+  pufu_pufub_path(source, path, sizeof(path));
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(PufubHeader)) {
+    close(fd);
+    return NULL;
+  }
+  size_t size = st.st_size;
+  // Private + read-only: nodes can share the pages, nobody can write them
+  void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return NULL;
+
+  const PufubHeader *h = map;
+  if (memcmp(h->magic, "PUFB", 4) != 0 || h->version != PUFU_PUFUB_VERSION ||
+      h->inst_size != sizeof(PufuInstruction) ||
+      h->names_hash != PUFU_NAMES_HASH ||
+      h->source_mtime_sec != (int64_t)src.st_mtim.tv_sec ||
+      h->source_mtime_nsec != (int64_t)src.st_mtim.tv_nsec ||
+      h->source_size != (int64_t)src.st_size || !image_ok(h, map, size)) {
+    munmap(map, size);
+    return NULL;
+  }
+
+  PufuParser *parser = calloc(1, sizeof(PufuParser));
+  if (!parser) {
+    munmap(map, size);
+    return NULL;
+  }
+  uint8_t *base = map;
+  parser->instructions = (PufuInstruction *)(base + h->inst_offset);
+  parser->debug = (PufuDebugInfo *)(base + h->debug_offset);
+  parser->count = h->count;
+  parser->capacity = h->count;
+  parser->has_pufu_init = h->has_pufu_init;
+  parser->labels = (PufuLabelEntry *)(base + h->labels_offset);
+  parser->label_count = h->label_count;
+  parser->label_capacity = h->label_count;
+  parser->strings = (char *)(base + h->strings_offset);
+  parser->strings_size = h->strings_size;
+  parser->strings_capacity = h->strings_size;
+  parser->linked = 1;
+  parser->image = map;
+  parser->image_size = size;
+
+  if (node_type)
+    *node_type = h->node_type;
+  return parser;
+}
+
+static uint32_t align4(uint32_t n) { return (n + 3) & ~3u; }
+
+int pufu_pufub_store(const PufuParser *parser, const char *source,
+                     int node_type) {
+  if (!cache_enabled || !parser || !parser->linked || parser->image)
+    return -1;
+
+  struct stat src;
+  if (stat(source, &src) < 0)
+    return -1;
+
+  PufubHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, "PUFB", 4);
+  h.version = PUFU_PUFUB_VERSION;
+  h.inst_size = sizeof(PufuInstruction);
+  h.names_hash = PUFU_NAMES_HASH;
+  h.node_type = node_type;
+  h.source_mtime_sec = src.st_mtim.tv_sec;
+  h.source_mtime_nsec = src.st_mtim.tv_nsec;
+  h.source_size = src.st_size;
+  h.has_pufu_init = parser->has_pufu_init;
+  h.count = parser->count;
+  h.label_count = parser->label_count;
+  // Always at least one NUL so offset 0 ("") is valid
+  h.strings_size = parser->strings_size > 0 ? parser->strings_size : 1;
+  h.inst_offset = align4(sizeof(h));
+  h.debug_offset = h.inst_offset + h.count * sizeof(PufuInstruction);
+  h.labels_offset = h.debug_offset + h.count * sizeof(PufuDebugInfo);
+  h.strings_offset =
+      align4(h.labels_offset + h.label_count * sizeof(PufuLabelEntry));
+
+  mkdir(PUFU_CACHE_DIR, 0755);
+  char path[PATH_MAX], tmp[PATH_MAX + 16];
+  pufu_pufub_path(source, path, sizeof(path));
+  snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+
+  FILE *f = fopen(tmp, "wb");
+  if (!f)
+    return -1;
+  static const char pad[4] = {0};
+  int ok = fwrite(&h, sizeof(h), 1, f) == 1;
+  ok = ok && fwrite(pad, 1, h.inst_offset - sizeof(h), f) ==
+                 h.inst_offset - sizeof(h);
+  ok = ok && fwrite(parser->instructions, sizeof(PufuInstruction),
+                    h.count, f) == (size_t)h.count;
+  ok = ok && fwrite(parser->debug, sizeof(PufuDebugInfo), h.count, f) ==
+                 (size_t)h.count;
+  ok = ok && fwrite(parser->labels, sizeof(PufuLabelEntry), h.label_count,
+                    f) == (size_t)h.label_count;
+  uint32_t labels_end =
+      h.labels_offset + h.label_count * sizeof(PufuLabelEntry);
+  ok = ok && fwrite(pad, 1, h.strings_offset - labels_end, f) ==
+                 h.strings_offset - labels_end;
+  if (parser->strings_size > 0)
+    ok = ok && fwrite(parser->strings, 1, parser->strings_size, f) ==
+                   (size_t)parser->strings_size;
+  else
+    ok = ok && fwrite(pad, 1, 1, f) == 1;
+  ok = (fclose(f) == 0) && ok;
+
+  // Atomic replace: a reader sees the old file or the new one, never half
+  if (!ok || rename(tmp, path) < 0) {
+    unlink(tmp);
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,412 @@
+#include "pufu/scheduler.h"
+#include "pufu/boot_trace.h"
+#include "pufu/dyn_loader.h"
+#include "pufu/jit.h"
+#include "pufu/program.h"
+#include "pufu/terminal.h"
+#include "pufu/trinity.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#define MAX_EVENTS 16
+
+// Executor to drain before a socket hot swap (one scheduler per process)
+static PufuExecutor *swap_exec = NULL;
+
+static void drain_workers(void) {
+  if (swap_exec)
+    pufu_executor_drain(swap_exec);
+}
+
+static void start_workers(PufuScheduler *sched, int workers) {
+  sched->exec = pufu_executor_init(workers > 0 ? workers : 0);
+  if (!sched->exec) {
+    printf("[Scheduler] Sin workers: todo corre en el hilo principal\n");
+    return;
+  }
+  struct epoll_event ev = {0};
+  ev.events = EPOLLIN;
+  ev.data.ptr = sched->exec; // Finished turns to reap
+  epoll_ctl(sched->epoll_fd, EPOLL_CTL_ADD, pufu_executor_fd(sched->exec),
+            &ev);
+  swap_exec = sched->exec;
+  pufu_loader_set_quiesce(drain_workers);
+}
+
+PufuScheduler *pufu_scheduler_init(PufuNodeSystem *system, int workers) {
+  PufuScheduler *sched = calloc(1, sizeof(PufuScheduler));
+  if (!sched)
+    return NULL;
+
+  sched->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (sched->epoll_fd < 0) {
+    perror("[Scheduler] epoll_create1");
+    free(sched);
+    return NULL;
+  }
+  sched->system = system;
+  pufu_timer_wheel_init(&sched->wheel, get_time_ms());
+
+  // Regular files and /dev/null cannot be polled: then input never wakes
+  // anyone, which is also true of the data they would deliver
+  pufu_scheduler_watch_fd(sched, STDIN_FILENO);
+
+  // Signals sent while we block (other threads) kick the bus fd
+  struct epoll_event ev = {0};
+  ev.events = EPOLLIN;
+  ev.data.ptr = system->bus;
+  epoll_ctl(sched->epoll_fd, EPOLL_CTL_ADD, pufu_virtual_bus_fd(system->bus),
+            &ev);
+
+  // Program sources edited on disk (hot reload of shared images)
+  if (pufu_program_watch_fd() >= 0) {
+    ev.data.ptr = sched;
+    epoll_ctl(sched->epoll_fd, EPOLL_CTL_ADD, pufu_program_watch_fd(), &ev);
+  }
+  if (workers != 0)
+    start_workers(sched, workers);
+  return sched;
+}
+
+int pufu_scheduler_watch_fd(PufuScheduler *sched, int fd) {
+  struct epoll_event ev = {0};
+  ev.events = EPOLLIN | EPOLLET; // One wakeup per arrival, never a spin
+  ev.data.ptr = NULL;            // Plain I/O: wake parked nodes
+  return epoll_ctl(sched->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+// Hot-reload inotify fd: the event carries the node to re-check
+static void watch_node(PufuScheduler *sched, PufuNode *node) {
+  node->watched = 1;
+  if (!node->reload || node->reload->watch_fd < 0)
+    return;
+  struct epoll_event ev = {0};
+  ev.events = EPOLLIN;
+  ev.data.ptr = node;
+  epoll_ctl(sched->epoll_fd, EPOLL_CTL_ADD, node->reload->watch_fd, &ev);
+}
+
+static void wake_node(PufuTimer *timer, void *arg) {
+  PufuScheduler *sched = arg;
+  PufuNode *node =
+      (PufuNode *)((char *)timer - offsetof(PufuNode, timer));
+  long long due_us = timer->expires * 1000;
+  node->wake_time = 0;
+  pufu_node_ready(sched->system, node);
+  if (due_us < node->ready_us) // Latency counts from the timer's expiry
+    node->ready_us = due_us;
+}
+
+// An exited node leaves the wheel and the epoll set now; the reaper frees
+// it once the pass is over
+static void bury(PufuScheduler *sched, PufuNode *node) {
+  PufuNodeSystem *system = sched->system;
+  pufu_timer_cancel(&sched->wheel, &node->timer);
+  if (node->watched && node->reload && node->reload->watch_fd >= 0)
+    epoll_ctl(sched->epoll_fd, EPOLL_CTL_DEL, node->reload->watch_fd, NULL);
+  node->run_state = PUFU_RUN_ZOMBIE;
+  system->live_count--;
+  system->zombie_count++;
+}
+
+static void park(PufuScheduler *sched, PufuNode *node) {
+  node->run_state = PUFU_RUN_PARKED;
+  sched->system->parked_count++;
+}
+
+// A node parked on I/O waits for something that could unblock it: new mail
+// wakes it directly (pufu_node_wake), any fd event wakes every parked node
+// and a queued Trinity event wakes the event waiters (poll_event, or a
+// (wait) on events). A key already pulled off stdin by a (wait) raises no
+// new fd event, so it wakes the input waiters directly.
+static void unpark(PufuScheduler *sched) {
+  PufuNodeSystem *system = sched->system;
+  if (system->parked_count == 0)
+    return;
+  int events = !sched->io_ready && trinity_pending_events();
+  int key = !sched->io_ready && pufu_terminal_key_buffered();
+  if (!sched->io_ready && !events && !key)
+    return;
+  for (PufuNode *node = system->nodes; node; node = node->next) {
+    if (node->run_state != PUFU_RUN_PARKED)
+      continue;
+    if (sched->io_ready ||
+        (events && (node->yielded == PUFU_YIELD_EVENT ||
+                    (node->wait_sources & PUFU_WAIT_EVENT))) ||
+        (key && (node->yielded == PUFU_YIELD_INPUT ||
+                 (node->wait_sources & PUFU_WAIT_INPUT))))
+      pufu_node_ready(system, node);
+  }
+}
+
+// An inline turn that ran out of quantum without blocking: compute-bound
+static int is_compute_bound(const PufuNode *node) {
+  return node->type == PUFU_NODE_ASSEMBLER && node->active &&
+         node->yielded == PUFU_YIELD_NONE && node->wake_time == 0;
+}
+
+// Take back the nodes the workers gave up. One that stopped in front of a
+// syscall stays on the main thread, where its next turn runs it.
+static void finish_turns(PufuScheduler *sched) {
+  PufuNode *node = pufu_executor_reap(sched->exec);
+  while (node) {
+    PufuNode *next = node->exec_next;
+    sched->stats.handbacks++;
+    if (node->stop_pending) {
+      node->stop_pending = 0;
+      node->active = 0;
+    }
+    if (node->jit_stale) {
+      node->jit_stale = 0;
+      pufu_jit_invalidate(node->jit);
+    }
+    if (node->yielded == PUFU_YIELD_SYSCALL)
+      node->on_workers = 0;
+    node->run_state = PUFU_RUN_IDLE;
+    pufu_node_ready(sched->system, node);
+    node = next;
+  }
+}
+
+// Where a node goes after its turn (or when it comes out of the run queue
+// without being able to run)
+static void settle(PufuScheduler *sched, PufuNode *node) {
+  if (!node->active) {
+    bury(sched, node);
+  } else if (node->wake_time > 0) {
+    node->run_state = PUFU_RUN_SLEEPING;
+    if (!node->timer.armed) // sys_sleep only sets wake_time
+      pufu_timer_add(&sched->wheel, &node->timer, node->wake_time);
+  } else if (node->yielded == PUFU_YIELD_INPUT ||
+             node->yielded == PUFU_YIELD_IPC ||
+             node->yielded == PUFU_YIELD_EVENT) {
+    if (node->yielded == PUFU_YIELD_INPUT)
+      pufu_boot_trace_finish(); // Waiting for the user: booted
+    park(sched, node);
+  } else if (node->yielded == PUFU_YIELD_WAIT) {
+    if (node->wait_sources & PUFU_WAIT_INPUT)
+      pufu_boot_trace_finish();
+    park(sched, node); // Until a source fires or the timeout does
+    if (node->wait_deadline > 0)
+      pufu_timer_add(&sched->wheel, &node->timer, node->wait_deadline);
+  } else {
+    if (sched->exec && is_compute_bound(node))
+      node->on_workers = 1;
+    node->spin_pass = sched->stats.passes;
+    pufu_node_ready(sched->system, node);
+  }
+}
+
+// Ready -> run latency, charged to the node's class
+static void account(PufuNodeSystem *system, PufuNode *node) {
+  long long now_us = get_time_us();
+  long long latency = now_us - node->ready_us;
+  if (latency < 0)
+    latency = 0;
+  PufuClassStats *stats = &system->class_stats[node->sched_class];
+  stats->turns++;
+  stats->total_us += latency;
+  if (latency > stats->max_us)
+    stats->max_us = latency;
+  int bucket = 0;
+  while (bucket < PUFU_LATENCY_BUCKETS - 1 && (1LL << bucket) <= latency)
+    bucket++;
+  stats->histogram[bucket]++;
+  if (node->sched_class == PUFU_CLASS_INTERACTIVE &&
+      latency > node->deadline_budget_us)
+    stats->missed++;
+}
+
+static void run_node(PufuScheduler *sched, PufuNode *node, long long now) {
+  node->run_state = PUFU_RUN_IDLE;
+  if (node->wait_sources) // Woken before its (wait) timed out
+    pufu_timer_cancel(&sched->wheel, &node->timer);
+  if (!node->watched)
+    watch_node(sched, node);
+  if (!node->active || node->wake_time > 0) {
+    settle(sched, node);
+    return;
+  }
+  account(sched->system, node);
+  if (node->on_workers) {
+    node->run_state = PUFU_RUN_WORKER;
+    pufu_executor_submit(sched->exec, node);
+    return;
+  }
+
+  pufu_node_execute(sched->system, node);
+  if (node->type == PUFU_NODE_CRYSTAL && node->active)
+    node->wake_time = now + PUFU_CRYSTAL_TICK_MS;
+  settle(sched, node);
+}
+
+// Block until the next timer or I/O event (or just poll if `timeout` is 0)
+static void wait_events(PufuScheduler *sched, int timeout) {
+  struct epoll_event events[MAX_EVENTS];
+  if (timeout != 0)
+    sched->stats.waits++;
+  int n = epoll_wait(sched->epoll_fd, events, MAX_EVENTS, timeout);
+  for (int i = 0; i < n; i++) {
+    PufuNode *node = events[i].data.ptr;
+    if (sched->exec && events[i].data.ptr == (void *)sched->exec)
+      continue; // Reaped at the start of the next pass
+    if (events[i].data.ptr == (void *)sched->system->bus) {
+      pufu_virtual_bus_ack(sched->system->bus); // Delivered next pass
+      continue;
+    }
+    if (events[i].data.ptr == (void *)sched) {
+      sched->reloads += pufu_node_system_check_programs(sched->system);
+      continue;
+    }
+    if (node)
+      sched->reloads += pufu_node_check(node);
+    else
+      sched->io_ready = 1;
+  }
+  if (n > 0)
+    sched->stats.io_wakeups += n;
+}
+
+// Between two turns: look for timers and input every PUFU_INPUT_POLL_US,
+// then give a turn to the interactive nodes woken since (mail, input,
+// events, timers) instead of leaving them for the next pass. One that used
+// up its quantum in this pass already waits for the next one.
+static void run_interactive(PufuScheduler *sched, long long now) {
+  PufuNodeSystem *system = sched->system;
+  long long now_us = get_time_us();
+  if (now_us - sched->polled_us >= PUFU_INPUT_POLL_US) {
+    sched->polled_us = now_us;
+    sched->stats.timer_wakeups += pufu_timer_wheel_advance(
+        &sched->wheel, now_us / 1000, wake_node, sched);
+    wait_events(sched, 0);
+    unpark(sched);
+    sched->io_ready = 0;
+  }
+
+  // Only what is queued now: nodes these turns wake wait for the next call
+  PufuRunQueue *queue = &system->ready[PUFU_CLASS_INTERACTIVE];
+  PufuNode *node = queue->head;
+  PufuNode *keep_head = NULL, *keep_tail = NULL;
+  queue->head = NULL;
+  queue->tail = NULL;
+  while (node) {
+    PufuNode *next = node->run_next;
+    node->run_next = NULL;
+    if (node->spin_pass == sched->stats.passes) {
+      if (keep_tail)
+        keep_tail->run_next = node;
+      else
+        keep_head = node;
+      keep_tail = node;
+    } else {
+      sched->stats.preemptions++;
+      run_node(sched, node, now);
+    }
+    node = next;
+  }
+  if (keep_head) { // Back in front, still in deadline order
+    keep_tail->run_next = queue->head;
+    queue->head = keep_head;
+    if (!queue->tail)
+      queue->tail = keep_tail;
+  }
+}
+
+static void run_list(PufuScheduler *sched, PufuNode *node, long long now) {
+  while (node) {
+    PufuNode *next = node->run_next;
+    node->run_next = NULL;
+    run_node(sched, node, now);
+    run_interactive(sched, now);
+    node = next;
+  }
+}
+
+static int has_ready(const PufuNodeSystem *system) {
+  for (int c = 0; c < PUFU_CLASS_COUNT; c++) {
+    if (system->ready[c].head)
+      return 1;
+  }
+  return 0;
+}
+
+int pufu_scheduler_run_once(PufuScheduler *sched) {
+  PufuNodeSystem *system = sched->system;
+  long long now = get_time_ms();
+  sched->stats.passes++;
+  sched->reloads = 0;
+  sched->stats.timer_wakeups +=
+      pufu_timer_wheel_advance(&sched->wheel, now, wake_node, sched);
+
+  if (sched->exec)
+    finish_turns(sched);
+  pufu_virtual_bus_process(system->bus); // Wakes subscribers
+  unpark(sched);
+  sched->io_ready = 0;
+
+  // Run what is queued now: nodes readied during the pass (mail, spawns,
+  // expired quanta) go to the next one. Batch nodes only get the pass if
+  // nothing else was ready, or once the oldest has waited too long.
+  PufuNode *queued[PUFU_CLASS_COUNT] = {NULL};
+  PufuRunQueue *batch = &system->ready[PUFU_CLASS_BATCH];
+  int busy = system->ready[PUFU_CLASS_INTERACTIVE].head ||
+             system->ready[PUFU_CLASS_NORMAL].head;
+  for (int c = 0; c < PUFU_CLASS_COUNT; c++) {
+    PufuRunQueue *queue = &system->ready[c];
+    if (queue == batch && busy && batch->head &&
+        get_time_us() - batch->head->ready_us <
+            PUFU_BATCH_MAX_WAIT_MS * 1000LL) {
+      sched->stats.batch_deferrals++;
+      continue;
+    }
+    queued[c] = queue->head;
+    queue->head = NULL;
+    queue->tail = NULL;
+  }
+  sched->polled_us = get_time_us();
+  for (int c = 0; c < PUFU_CLASS_COUNT; c++)
+    run_list(sched, queued[c], now);
+  fflush(stdout);
+
+  // Safe point: no syscall is running and the pass holds no node pointers
+  if (system->zombie_count > 0)
+    pufu_node_system_reap(system);
+  if (system->live_count == 0)
+    return 0;
+
+  int timeout = 0;
+  if (!has_ready(system) && pufu_virtual_bus_arm(system->bus) == 0) {
+    long long next = pufu_timer_wheel_next(&sched->wheel);
+    timeout = -1; // Only I/O (or a signal) can wake us
+    if (next >= 0) {
+      long long delay = next - get_time_ms();
+      timeout = delay > 0 ? (int)delay : 0;
+      // Virtual time: everyone is asleep, so jump straight to the next
+      // deadline (not while a worker is still running a turn)
+      if (timeout > 0 && pufu_clock_is_virtual() &&
+          (!sched->exec || pufu_executor_in_flight(sched->exec) == 0)) {
+        pufu_clock_advance_to(next);
+        sched->stats.fast_forwards++;
+        timeout = 0;
+      }
+    }
+  }
+  wait_events(sched, timeout);
+  return system->live_count;
+}
+
+void pufu_scheduler_cleanup(PufuScheduler *sched) {
+  if (!sched)
+    return;
+  if (sched->exec) {
+    pufu_loader_set_quiesce(NULL);
+    swap_exec = NULL;
+    pufu_executor_drain(sched->exec);
+    pufu_executor_cleanup(sched->exec);
+  }
+  close(sched->epoll_fd);
+  free(sched);
+}
@@ -0,0 +1,59 @@
+#include "pufu/slab.h"
+#include <stdlib.h>
+
+// A chunk is one aligned block: a cache line for the chunk link followed
+// by per_chunk objects. New objects are pushed in reverse so the free list
+// hands them out in address order.
+static int grow(PufuSlab *slab) {
+  size_t bytes = PUFU_SLAB_ALIGN + slab->size * (size_t)slab->per_chunk;
+  char *chunk = aligned_alloc(PUFU_SLAB_ALIGN, bytes);
+  if (!chunk)
+    return -1;
+  *(void **)chunk = slab->chunks;
+  slab->chunks = chunk;
+  slab->chunk_count++;
+
+  for (int i = slab->per_chunk - 1; i >= 0; i--) {
+    void *obj = chunk + PUFU_SLAB_ALIGN + slab->size * (size_t)i;
+    *(void **)obj = slab->free_list;
+    slab->free_list = obj;
+  }
+  return 0;
+}
+
+void *pufu_slab_alloc(PufuSlab *slab) {
+  if (!slab->free_list && grow(slab) < 0)
+    return NULL;
+  void *obj = slab->free_list;
+  slab->free_list = *(void **)obj;
+  slab->in_use++;
+  slab->allocs++;
+  return obj;
+}
+
+void pufu_slab_free(PufuSlab *slab, void *obj) {
+  if (!obj)
+    return;
+  *(void **)obj = slab->free_list;
+  slab->free_list = obj;
+  slab->in_use--;
+}
+
+int pufu_slab_release(PufuSlab *slab) {
+  if (slab->in_use > 0)
+    return -1;
+  void *chunk = slab->chunks;
+  while (chunk) {
+    void *next = *(void **)chunk;
+    free(chunk);
+    chunk = next;
+  }
+  slab->chunks = NULL;
+  slab->free_list = NULL;
+  slab->chunk_count = 0;
+  return 0;
+}
+
+int pufu_slab_capacity(const PufuSlab *slab) {
+  return slab->chunk_count * slab->per_chunk;
+}
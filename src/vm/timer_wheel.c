@@ -0,0 +1,149 @@
+#include "pufu/timer_wheel.h"
+#include <stddef.h>
+
+#define SLOT_MASK (PUFU_WHEEL_SLOTS - 1)
+#define LEVEL_SPAN(l) (1LL << (PUFU_WHEEL_BITS * ((l) + 1)))
+
+static void list_init(PufuTimer *head) {
+  head->next = head;
+  head->prev = head;
+}
+
+static void list_append(PufuTimer *head, PufuTimer *timer) {
+  timer->prev = head->prev;
+  timer->next = head;
+  head->prev->next = timer;
+  head->prev = timer;
+}
+
+static void list_unlink(PufuTimer *timer) {
+  timer->prev->next = timer->next;
+  timer->next->prev = timer->prev;
+  timer->next = timer->prev = NULL;
+}
+
+void pufu_timer_wheel_init(PufuTimerWheel *wheel, long long now) {
+  wheel->now = now;
+  wheel->count = 0;
+  for (int l = 0; l < PUFU_WHEEL_LEVELS; l++)
+    for (int s = 0; s < PUFU_WHEEL_SLOTS; s++)
+      list_init(&wheel->slots[l][s]);
+}
+
+// File a timer by its distance from now: level l holds deadlines less
+// than 64^(l+1) ticks away, indexed by the l-th group of 6 bits. A cascade
+// runs before the tick's level 0 slot fires, so a timer due on that very
+// tick goes into that slot; a new timer can only fire from the next tick.
+static void file_timer(PufuTimerWheel *wheel, PufuTimer *timer,
+                       int cascading) {
+  long long at = timer->expires;
+  if (cascading && at < wheel->now)
+    at = wheel->now;
+  else if (!cascading && at <= wheel->now)
+    at = wheel->now + 1; // Overdue: next tick
+  long long delta = at - wheel->now;
+
+  int level = 0;
+  while (level < PUFU_WHEEL_LEVELS - 1 && delta >= LEVEL_SPAN(level))
+    level++;
+  if (delta >= LEVEL_SPAN(level))
+    at = wheel->now + LEVEL_SPAN(level) - 1; // Beyond the wheel: park
+
+  int slot = (at >> (PUFU_WHEEL_BITS * level)) & SLOT_MASK;
+  list_append(&wheel->slots[level][slot], timer);
+}
+
+void pufu_timer_add(PufuTimerWheel *wheel, PufuTimer *timer,
+                    long long expires) {
+  if (timer->armed)
+    pufu_timer_cancel(wheel, timer);
+  timer->expires = expires;
+  timer->armed = 1;
+  wheel->count++;
+  file_timer(wheel, timer, 0);
+}
+
+void pufu_timer_cancel(PufuTimerWheel *wheel, PufuTimer *timer) {
+  if (!timer->armed)
+    return;
+  list_unlink(timer);
+  timer->armed = 0;
+  wheel->count--;
+}
+
+// Move every timer of a higher-level slot down to where it now belongs
+static void cascade(PufuTimerWheel *wheel, int level, int slot) {
+  PufuTimer *head = &wheel->slots[level][slot];
+  PufuTimer pending;
+  list_init(&pending);
+  while (head->next != head) {
+    PufuTimer *timer = head->next;
+    list_unlink(timer);
+    list_append(&pending, timer);
+  }
+  while (pending.next != &pending) {
+    PufuTimer *timer = pending.next;
+    list_unlink(timer);
+    file_timer(wheel, timer, 1);
+  }
+}
+
+int pufu_timer_wheel_advance(PufuTimerWheel *wheel, long long now,
+                             void (*fire)(PufuTimer *timer, void *arg),
+                             void *arg) {
+  if (wheel->count == 0) {
+    if (now > wheel->now)
+      wheel->now = now; // Nothing to fire: skip the idle ticks
+    return 0;
+  }
+
+  int fired = 0;
+  while (wheel->now < now && wheel->count > 0) {
+    wheel->now++;
+    long long tick = wheel->now;
+    for (int l = 1; l < PUFU_WHEEL_LEVELS; l++) {
+      if ((tick & (LEVEL_SPAN(l - 1) - 1)) != 0)
+        break;
+      cascade(wheel, l, (tick >> (PUFU_WHEEL_BITS * l)) & SLOT_MASK);
+    }
+
+    PufuTimer *head = &wheel->slots[0][tick & SLOT_MASK];
+    while (head->next != head) {
+      PufuTimer *timer = head->next;
+      list_unlink(timer);
+      timer->armed = 0;
+      wheel->count--;
+      fired++;
+      fire(timer, arg);
+    }
+  }
+  if (wheel->count == 0 && now > wheel->now)
+    wheel->now = now;
+  return fired;
+}
+
+long long pufu_timer_wheel_next(const PufuTimerWheel *wheel) {
+  if (wheel->count == 0)
+    return -1;
+
+  long long next = -1;
+  // Level 0 slots hold exact deadlines: the first non-empty one wins there
+  for (int i = 1; i <= PUFU_WHEEL_SLOTS; i++) {
+    const PufuTimer *head = &wheel->slots[0][(wheel->now + i) & SLOT_MASK];
+    if (head->next != head) {
+      next = wheel->now + i;
+      break;
+    }
+  }
+  // Upper levels may still hold something sooner (not cascaded yet)
+  for (int l = 1; l < PUFU_WHEEL_LEVELS; l++) {
+    for (int s = 0; s < PUFU_WHEEL_SLOTS; s++) {
+      const PufuTimer *head = &wheel->slots[l][s];
+      for (const PufuTimer *t = head->next; t != head; t = t->next) {
+        if (next < 0 || t->expires < next)
+          next = t->expires;
+      }
+    }
+  }
+  return next;
+}
@@ -0,0 +1,154 @@
+"""
+Pufu OS - Perfect hash generator for parser names.
+
+Reads tools/pufu_names.txt (syscall names and opcode mnemonics) and writes
+include/pufu/name_hash.h: one collision-free table per section, so the
+parser resolves a name with a single hash and a single compare. The header
+is build output: the Makefile reruns this script whenever the names file
+changes, so adding a syscall only touches tools/pufu_names.txt. It also
+records PUFU_NAMES_HASH, a digest of the name list that .pufub cache files
+are keyed on, so cached images stop loading when a name or its id changes.
+
+Usage: python3 tools/gen_name_hash.py [names.txt] [name_hash.h]
+"""
+
+import sys
+
+MASK = 0xFFFFFFFF
+
+
+def name_hash(name, seed):
+    # Must match pufu_name_hash() in the generated header
+    h = (2166136261 ^ seed) & MASK
+    for byte in name.encode():
+        h ^= byte
+        h = (h * 16777619) & MASK
+    h ^= h >> 15
+    return h
+
+
+def read_sections(path):
+    sections = {}
+    current = None
+    with open(path) as f:
+        for line in f:
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            if line.startswith("[") and line.endswith("]"):
+                current = line[1:-1]
+                sections[current] = []
+                continue
+            name, ident = line.split()
+            if any(name == n for n, _ in sections[current]):
+                sys.exit("duplicate name in [%s]: %s" % (current, name))
+            sections[current].append((name, ident))
+    return sections
+
+
+def names_digest(sections):
+    # FNV-1a over the entries, not the file: comments and blank lines do not
+    # invalidate caches
+    h = 2166136261
+    for section in sorted(sections):
+        for name, ident in sections[section]:
+            for byte in ("%s %s %s\n" % (section, name, ident)).encode():
+                h ^= byte
+                h = (h * 16777619) & MASK
+    return h
+
+
+def find_seed(names):
+    # Smallest power-of-two table (>= 2n) with a seed that has no collision
+    size = 1
+    while size < 2 * len(names):
+        size *= 2
+    while True:
+        for seed in range(1, 1 << 20):
+            slots = {name_hash(n, seed) & (size - 1) for n in names}
+            if len(slots) == len(names):
+                return seed, size
+        size *= 2
+
+
+def emit_section(out, section, entries, id_type):
+    names = [n for n, _ in entries]
+    seed, size = find_seed(names)
+    upper = section.upper()
+    table = [None] * size
+    for name, ident in entries:
+        table[name_hash(name, seed) & (size - 1)] = (name, ident)
+
+    out.append("// [%s] %d names, %d slots" % (section, len(names), size))
+    out.append("#define PUFU_%s_HASH_SEED 0x%08xu" % (upper, seed))
+    out.append("#define PUFU_%s_HASH_SIZE %d" % (upper, size))
+    out.append("")
+    out.append("static const PufuNameEntry pufu_%s_table[%d] = {" % (section, size))
+    for slot, entry in enumerate(table):
+        if entry:
+            name, ident = entry
+            out.append('    [%d] = {"%s", %d, %s},' % (slot, name, len(name), ident))
+    out.append("};")
+    out.append("")
+    out.append("static inline %s pufu_%s_lookup(const char *name, int len) {" %
+               (id_type, section[:-1]))
+    out.append("  uint32_t slot = pufu_name_hash(name, len, PUFU_%s_HASH_SEED) &" %
+               upper)
+    out.append("                  (PUFU_%s_HASH_SIZE - 1);" % upper)
+    out.append("  const PufuNameEntry *e = &pufu_%s_table[slot];" % section)
+    out.append("  if (e->name && e->len == len && memcmp(e->name, name, len) == 0)")
+    out.append("    return (%s)e->id;" % id_type)
+    out.append("  return (%s)0;" % id_type)
+    out.append("}")
+    out.append("")
+
+
+def main():
+    src = sys.argv[1] if len(sys.argv) > 1 else "tools/pufu_names.txt"
+    dst = sys.argv[2] if len(sys.argv) > 2 else "include/pufu/name_hash.h"
+    sections = read_sections(src)
+
+    out = [
+        "// Generated by tools/gen_name_hash.py from %s. Do not edit;" % src,
+        "// the build regenerates it when the names file changes (not checked in).",
+        "#ifndef PUFU_NAME_HASH_H",
+        "#define PUFU_NAME_HASH_H",
+        "",
+        '#include "pufu/opcode.h"',
+        '#include "pufu/syscall_ids.h"',
+        "#include <stdint.h>",
+        "#include <string.h>",
+        "",
+        "typedef struct {",
+        "  const char *name;",
+        "  uint8_t len;",
+        "  uint16_t id;",
+        "} PufuNameEntry;",
+        "",
+        "// Seeded FNV-1a (must match name_hash() in the generator)",
+        "static inline uint32_t pufu_name_hash(const char *s, int len,",
+        "                                      uint32_t seed) {",
+        "  uint32_t h = 2166136261u ^ seed;",
+        "  for (int i = 0; i < len; i++) {",
+        "    h ^= (unsigned char)s[i];",
+        "    h *= 16777619u;",
+        "  }",
+        "  return h ^ (h >> 15);",
+        "}",
+        "",
+        "// Digest of the name list; .pufub headers record it (see pufub.h)",
+        "#define PUFU_NAMES_HASH 0x%08xu" % names_digest(sections),
+        "",
+    ]
+    emit_section(out, "syscalls", sections["syscalls"], "PufuSyscallID")
+    emit_section(out, "opcodes", sections["opcodes"], "PufuOpcode")
+    out.append("#endif // PUFU_NAME_HASH_H")
+
+    with open(dst, "w") as f:
+        f.write("\n".join(out) + "\n")
+    print("%s: %d syscalls, %d opcodes" %
+          (dst, len(sections["syscalls"]), len(sections["opcodes"])))
+
+
+if __name__ == "__main__":
+    main()